@@ -34,10 +34,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <set>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace
@@ -49,7 +53,6 @@ constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_DESCRIPTION = L"Encodes geometr
 
 constexpr const wchar_t* EO_EMIT_ATTRIBUTES = L"emitAttributes";
 constexpr const wchar_t* EO_EMIT_MATERIALS = L"emitMaterials";
-constexpr const wchar_t* EO_EMIT_REPORTS = L"emitReports";
 
 const prtx::DoubleVector EMPTY_UVS;
 const prtx::IndexVector EMPTY_IDX;
@@ -76,20 +79,6 @@ struct SerializedGeometry
 
 using AttributeMapNOPtrVector = std::vector<const prt::AttributeMap*>;
 
-struct AttributeMapNOPtrVectorOwner
-{
-	AttributeMapNOPtrVector v;
-
-	~AttributeMapNOPtrVectorOwner()
-	{
-		for (const auto& m : v)
-		{
-			if (m != nullptr)
-				m->destroy();
-		}
-	}
-};
-
 struct TextureUVMapping
 {
 	std::wstring key;
@@ -179,7 +168,7 @@ std::wstring uriToPath(const prtx::TexturePtr& t)
 
 // we blacklist all CGA-style material attribute keys, see prtx/Material.h
 // clang-format off
-	const std::set<std::wstring> MATERIAL_ATTRIBUTE_BLACKLIST = {
+	const std::unordered_set<std::wstring> MATERIAL_ATTRIBUTE_BLACKLIST = {
 		L"ambient.b",
 		L"ambient.g",
 		L"ambient.r",
@@ -257,15 +246,13 @@ std::wstring uriToPath(const prtx::TexturePtr& t)
 	};
 // clang-format on
 
+// keys are expected to be filtered against MATERIAL_ATTRIBUTE_BLACKLIST already
 void convertMaterialToAttributeMap(prtx::PRTUtils::AttributeMapBuilderPtr& aBuilder, const prtx::Material& prtxAttr, const prtx::WStringVector& keys)
 {
 	if (DBG)
 		log_debug(L"-- converting material: %1%") % prtxAttr.name();
 	for (const auto& key : keys)
 	{
-		if (MATERIAL_ATTRIBUTE_BLACKLIST.count(key) > 0)
-			continue;
-
 		if (DBG)
 			log_debug(L"   key: %1%") % key;
 
@@ -521,17 +508,17 @@ SerializedGeometry serializeGeometry(const prtx::GeometryPtrVector& geometries,
 }
 
 void encodeMesh(IUnrealCallbacks* cb, const SerializedGeometry& sg, wchar_t const* name, wchar_t const* meshId, int32_t prototypeIndex, const std::wstring& uri,
-				prtx::GeometryPtrVector geometries, std::vector<prtx::MaterialPtrVector> materials)
+				const prtx::GeometryPtrVector& geometries, const std::vector<prtx::MaterialPtrVector>& materials,
+				MaterialAttributeMapCache& materialAttributeMaps)
 {
 	auto puvs = toPtrVec(sg.uvs);
 	auto puvCounts = toPtrVec(sg.uvCounts);
 	auto puvIndices = toPtrVec(sg.uvIndices);
 
 	std::vector<uint32_t> faceRanges;
-	AttributeMapNOPtrVectorOwner matAttrMaps;
+	AttributeMapNOPtrVector matAttrMaps;
 
 	auto matIt = materials.cbegin();
-	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
 	for (const auto& geo : geometries)
 	{
 		const prtx::MeshPtrVector& meshes = geo->getMeshes();
@@ -541,8 +528,7 @@ void encodeMesh(IUnrealCallbacks* cb, const SerializedGeometry& sg, wchar_t cons
 			const prtx::MeshPtr& m = meshes.at(mi);
 			const prtx::MaterialPtr& mat = matIt->at(mi);
 
-			convertMaterialToAttributeMap(amb, *(mat.get()), mat->getKeys());
-			matAttrMaps.v.push_back(amb->createAttributeMapAndReset());
+			matAttrMaps.push_back(materialAttributeMaps.get(mat));
 			faceRanges.push_back(m->getFaceCount());
 		}
 
@@ -556,9 +542,41 @@ void encodeMesh(IUnrealCallbacks* cb, const SerializedGeometry& sg, wchar_t cons
 				puvs.first.data(), puvs.second.data(), puvCounts.first.data(), puvCounts.second.data(), puvIndices.first.data(),
 				puvIndices.second.data(), sg.uvs.size(),
 
-				faceRanges.data(), faceRanges.size(), matAttrMaps.v.empty() ? nullptr : matAttrMaps.v.data());
+				faceRanges.data(), faceRanges.size(), matAttrMaps.empty() ? nullptr : matAttrMaps.data());
 }
 
+// all instances of one mesh, passed to the callbacks at once
+struct InstanceBatch
+{
+	int32_t prototypeIndex;
+	std::wstring meshId;
+	std::wstring name;
+	size_t numInstanceMaterials;
+
+	prtx::DoubleVector transforms;
+	std::vector<uint32_t> materialOverrideIndices;
+	AttributeMapNOPtrVector materialOverrides;
+	std::map<AttributeMapNOPtrVector, uint32_t> materialOverrideIndexLookup;
+
+	InstanceBatch(int32_t prototypeIndex, const InstanceIdentifier& identifier, size_t numInstanceMaterials)
+		: prototypeIndex(prototypeIndex), meshId(identifier.meshId), name(identifier.name), numInstanceMaterials(numInstanceMaterials)
+	{
+	}
+
+	// material attribute maps are memoized per material, so identical override sets consist of identical pointers
+	void add(const prtx::DoubleVector& transform, const AttributeMapNOPtrVector& instanceMaterials)
+	{
+		assert(transform.size() == 16);
+		assert(instanceMaterials.size() == numInstanceMaterials);
+		transforms.insert(transforms.end(), transform.begin(), transform.end());
+
+		const auto lookupResult = materialOverrideIndexLookup.emplace(instanceMaterials, static_cast<uint32_t>(materialOverrideIndexLookup.size()));
+		if (lookupResult.second)
+			materialOverrides.insert(materialOverrides.end(), instanceMaterials.begin(), instanceMaterials.end());
+		materialOverrideIndices.push_back(lookupResult.first->second);
+	}
+};
+
 const prtx::PRTUtils::AttributeMapPtr convertReportToAttributeMap(const prtx::ReportsPtr& r) {
 	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
 
@@ -573,6 +591,41 @@ const prtx::PRTUtils::AttributeMapPtr convertReportToAttributeMap(const prtx::Re
 }
 } // namespace
 
+const prt::AttributeMap* MaterialAttributeMapCache::get(const prtx::MaterialPtr& material)
+{
+	const auto it = mAttributeMaps.find(material);
+	if (it != mAttributeMaps.end())
+		return it->second.get();
+
+	if (!mBuilder)
+		mBuilder.reset(prt::AttributeMapBuilder::create());
+
+	convertMaterialToAttributeMap(mBuilder, *material, getFilteredKeys(material->getKeys()));
+	const auto inserted = mAttributeMaps.emplace(material, prtx::PRTUtils::AttributeMapPtr{mBuilder->createAttributeMapAndReset()});
+	return inserted.first->second.get();
+}
+
+// materials created from the same shader share their key vector, so each distinct key vector is only filtered once
+const prtx::WStringVector& MaterialAttributeMapCache::getFilteredKeys(const prtx::WStringVector& keys)
+{
+	const auto it = mFilteredKeys.find(&keys);
+	if (it != mFilteredKeys.end())
+		return it->second;
+
+	prtx::WStringVector filteredKeys;
+	filteredKeys.reserve(keys.size());
+	std::copy_if(keys.begin(), keys.end(), std::back_inserter(filteredKeys),
+				 [](const std::wstring& key) { return MATERIAL_ATTRIBUTE_BLACKLIST.count(key) == 0; });
+	return mFilteredKeys.emplace(&keys, std::move(filteredKeys)).first->second;
+}
+
+void MaterialAttributeMapCache::clear()
+{
+	// the key vectors are owned by the materials, so the filtered keys must not outlive them
+	mFilteredKeys.clear();
+	mAttributeMaps.clear();
+}
+
 UnrealGeometryEncoder::UnrealGeometryEncoder(const std::wstring& id, const prt::AttributeMap* options, prt::Callbacks* callbacks)
 	: prtx::GeometryEncoder(id, options, callbacks)
 {
@@ -584,6 +637,9 @@ void UnrealGeometryEncoder::init(prtx::GenerateContext&)
 	mNsMaterial = mNamePrep.newNamespace();
 	
 	mEncPrep = prtx::EncodePreparator::create(true, mNamePrep, mNsMesh, mNsMaterial);
+	mMaterialAttributeMaps.clear();
+
+	serializedPrototypes.clear();
 
 	auto* callbacks = dynamic_cast<IUnrealCallbacks*>(getCallbacks());
 	if (callbacks == nullptr)
@@ -604,8 +660,8 @@ void UnrealGeometryEncoder::encode(prtx::GenerateContext& context, size_t initia
 		mEncPrep->add(context.getCache(), shape, initialShape.getAttributeMap());
 	}
 
-	const bool emitAttrs = getOptions()->getBool(EO_EMIT_ATTRIBUTES);
-	if (emitAttrs) {
+	const bool emitReports = getOptions()->getBool(EO_EMIT_REPORTS);
+	if (emitReports) {
 		prtx::ReportsAccumulatorPtr reportsAccumulator{prtx::SummarizingReportsAccumulator::create()};
 		prtx::ReportingStrategyPtr reportsCollector{prtx::AllShapesReportingStrategy::create(context, initialShapeIndex, reportsAccumulator)};
 
@@ -621,7 +677,9 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::Instan
 {
 	prtx::GeometryPtrVector geometries;
 	std::vector<prtx::MaterialPtrVector> materials;
-	prtx::PRTUtils::AttributeMapBuilderPtr instanceMatAmb(prt::AttributeMapBuilder::create());
+
+	std::vector<InstanceBatch> instanceBatches;
+	std::unordered_map<std::wstring, size_t> instanceBatchIndices;
 	for (const auto& inst : instances)
 	{
 		if (inst.getPrototypeIndex() != prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX)
@@ -629,29 +687,29 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::Instan
 			const prtx::MaterialPtrVector& instMaterials = inst.getMaterials();
 			const prtx::GeometryPtr& instGeom = inst.getGeometry();
 
-			AttributeMapNOPtrVectorOwner instMaterialsAttributeMap;
-
 			InstanceIdentifier identifier = createInstanceIdentifier(inst);
 			
-			if (serializedPrototypes.find(identifier.meshId) == serializedPrototypes.end())
+			// prototypes already cached by the client are neither serialized nor encoded, only their instances are emitted
+			if (serializedPrototypes.insert(identifier.meshId).second && !cb->isCachedPrototype(identifier.meshId.c_str()))
 			{
 				const std::wstring uri = instGeom->getURI()->wstring();
 				const SerializedGeometry sg = serializeGeometry({instGeom}, {instMaterials});
-				encodeMesh(cb, sg, identifier.name.c_str(), identifier.meshId.c_str(), inst.getPrototypeIndex(), uri, {instGeom}, {instMaterials});
-				serializedPrototypes.insert(identifier.meshId);
+				encodeMesh(cb, sg, identifier.name.c_str(), identifier.meshId.c_str(), inst.getPrototypeIndex(), uri, {instGeom}, {instMaterials},
+						   mMaterialAttributeMaps);
 			}
 
-			const prtx::MeshPtrVector& meshes = instGeom->getMeshes();
-			for (size_t mi = 0; mi < meshes.size(); mi++)
-			{
-				const prtx::MaterialPtr& mat = instMaterials[mi];
+			const auto batchIndex = instanceBatchIndices.emplace(identifier.meshId, instanceBatches.size());
+			if (batchIndex.second)
+				instanceBatches.emplace_back(inst.getPrototypeIndex(), identifier, instGeom->getMeshes().size());
+			InstanceBatch& batch = instanceBatches[batchIndex.first->second];
 
-				convertMaterialToAttributeMap(instanceMatAmb, *(mat.get()), mat->getKeys());
-				instMaterialsAttributeMap.v.push_back(instanceMatAmb->createAttributeMapAndReset());
+			AttributeMapNOPtrVector instMaterialsAttributeMap;
+			for (size_t mi = 0; mi < batch.numInstanceMaterials; mi++)
+			{
+				instMaterialsAttributeMap.push_back(mMaterialAttributeMaps.get(instMaterials[mi]));
 			}
 
-			cb->addInstance(inst.getPrototypeIndex(), identifier.meshId.c_str(), inst.getTransformation().data(), instMaterialsAttributeMap.v.data(),
-							instMaterialsAttributeMap.v.size());
+			batch.add(inst.getTransformation(), instMaterialsAttributeMap);
 		}
 		else
 		{
@@ -660,10 +718,18 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::Instan
 		}
 	}
 
+	for (const InstanceBatch& batch : instanceBatches)
+	{
+		cb->addInstances(batch.prototypeIndex, batch.meshId.c_str(), batch.name.c_str(), batch.transforms.data(),
+						 batch.materialOverrideIndices.size(), batch.materialOverrideIndices.data(), batch.materialOverrides.data(),
+						 batch.materialOverrideIndexLookup.size(), batch.numInstanceMaterials);
+	}
+
 	if (geometries.size() > 0)
 	{
 		const SerializedGeometry sg = serializeGeometry(geometries, materials);
-		encodeMesh(cb, sg, L"", L"", prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX, L"", geometries, materials);
+		encodeMesh(cb, sg, L"", L"", prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX, L"", geometries, materials,
+				   mMaterialAttributeMaps);
 	}
 
 	if (DBG)
@@ -690,6 +756,7 @@ void UnrealGeometryEncoder::finish(prtx::GenerateContext& /*context*/)
 	mEncPrep->fetchFinalizedInstances(instances, PREP_FLAGS);
 	
 	convertGeometry(instances, cb);
+	mMaterialAttributeMaps.clear();
 	
 	cb->finish();
 }
@@ -706,6 +773,7 @@ UnrealGeometryEncoderFactory* UnrealGeometryEncoderFactory::createInstance()
 	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
 	amb->setBool(EO_EMIT_ATTRIBUTES, true);
 	amb->setBool(EO_EMIT_MATERIALS, true);
+	amb->setBool(EO_EMIT_REPORTS, false);
 	encoderInfoBuilder.setDefaultOptions(amb->createAttributeMap());
 
 	return new UnrealGeometryEncoderFactory(encoderInfoBuilder.create());
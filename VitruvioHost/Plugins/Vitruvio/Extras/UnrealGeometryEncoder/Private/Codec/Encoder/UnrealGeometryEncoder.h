@@ -21,6 +21,7 @@
 #include "prtx/Encoder.h"
 #include "prtx/EncoderFactory.h"
 #include "prtx/EncoderInfoBuilder.h"
+#include "prtx/Material.h"
 #include "prtx/PRTUtils.h"
 #include "prtx/ResolveMap.h"
 #include "prtx/Singleton.h"
@@ -37,11 +38,31 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 
 class IUnrealCallbacks;
 
 using InstanceVectorPtr = std::shared_ptr<prtx::EncodePreparator::InstanceVector>;
 
+/**
+ * \brief Converts prtx materials to attribute maps and keeps the result for the duration of a generate call.
+ *
+ * Materials are shared between many instances (e.g. windows) so each distinct material is only converted once.
+ */
+class MaterialAttributeMapCache
+{
+public:
+	const prt::AttributeMap* get(const prtx::MaterialPtr& material);
+	void clear();
+
+private:
+	const prtx::WStringVector& getFilteredKeys(const prtx::WStringVector& keys);
+
+	prtx::PRTUtils::AttributeMapBuilderPtr mBuilder;
+	std::unordered_map<prtx::MaterialPtr, prtx::PRTUtils::AttributeMapPtr> mAttributeMaps;
+	std::unordered_map<const prtx::WStringVector*, prtx::WStringVector> mFilteredKeys;
+};
+
 class UnrealGeometryEncoder final : public prtx::GeometryEncoder
 {
 public:
@@ -60,7 +81,8 @@ private:
     prtx::EncodePreparatorPtr mEncPrep;
     prtx::NamePreparator::NamespacePtr mNsMesh;
     prtx::NamePreparator::NamespacePtr mNsMaterial;
-    	
+
+	MaterialAttributeMapCache mMaterialAttributeMaps;
 	std::set<std::wstring> serializedPrototypes;
 };
 
@@ -20,6 +20,9 @@
 
 constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_ID = L"UnrealGeometryEncoder";
 
+// encoder option to enable the (costly) collection of CGA reports, disabled by default
+constexpr const wchar_t* EO_EMIT_REPORTS = L"emitReports";
+
 class IUnrealCallbacks : public prt::Callbacks
 {
 public:
@@ -66,6 +69,9 @@ public:
 	/**
 	 * Add a new instance with the given id, transform and an optional set of overriding attributes for this instance
 	 *
+	 * Superseded by @ref addInstances. It stays in its original vtable slot so that encoder binaries built against the
+	 * previous version of this interface keep working, new encoders only call addInstances.
+	 *
 	 * @param prototypeId the id of the prototype. An @ref addMesh call with the specified prototype id will be called before
 	 *                    the call to addInstance and addReport
 	 * @param meshId unique identifier of this mesh
@@ -80,4 +86,37 @@ public:
 	virtual void init() = 0;
 	virtual void finish() = 0;
 	virtual void addReport(const prt::AttributeMap* reports) = 0;
+
+	/**
+	 * Add all instances of a mesh with their transforms and optional sets of overriding materials
+	 *
+	 * Appended after all other callbacks to keep the vtable layout of the previous interface version (see @ref addInstance).
+	 *
+	 * @param prototypeId the id of the prototype. An @ref addMesh call with the specified prototype id will be called before
+	 *                    the call to addInstances and addReport unless @ref isCachedPrototype returned true for the mesh id
+	 * @param meshId unique identifier of the instanced mesh
+	 * @param name either the name of the inserted asset or the shape name
+	 * @param transforms contiguous array of numInstances 4x4 transformation matrices (16 values per instance)
+	 * @param numInstances number of instances
+	 * @param materialOverrideIndices index into the material override table per instance (numInstances entries)
+	 * @param materialOverrides deduplicated material override table, contains numMaterialOverrides consecutive sets of
+	 *                          numInstanceMaterials attribute maps
+	 * @param numMaterialOverrides number of distinct material override sets
+	 * @param numInstanceMaterials number of materials per override set. Is either 0 or is equal to the number
+	 *                             of materials of the original mesh (by prototypeId)
+	 */
+	virtual void addInstances(int32_t prototypeId, const wchar_t* meshId, const wchar_t* name, const double* transforms, size_t numInstances,
+							  const uint32_t* materialOverrideIndices, const prt::AttributeMap* const* materialOverrides,
+							  size_t numMaterialOverrides, size_t numInstanceMaterials) = 0;
+
+	/**
+	 * Asks whether the client already has the prototype with the given mesh id, in which case it is neither serialized nor
+	 * passed to addMesh. Called at most once per mesh id and generate call, before the first instance of the mesh is added.
+	 *
+	 * Appended after all other callbacks to keep the vtable layout of the previous interface version (see @ref addInstance).
+	 *
+	 * @param meshId unique identifier of the instanced mesh
+	 * @return true if the client has the prototype and addMesh can be skipped
+	 */
+	virtual bool isCachedPrototype(const wchar_t* meshId) = 0;
 };
@@ -0,0 +1,106 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ApplyScheduler.h"
+
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+TAutoConsoleVariable<float> CVarApplyBudgetMs(TEXT("vitruvio.ApplyBudgetMs"), 5.0f,
+											  TEXT("Game thread time in milliseconds per frame used to apply generate results."));
+} // namespace
+
+void FApplyScheduler::Schedule(const UObject* Owner, FApplyStep Step, FDroppedHandler OnDropped)
+{
+	check(IsInGameThread());
+
+	Jobs.Add(MakeShared<FJob>(FJob {Owner, MoveTemp(Step), MoveTemp(OnDropped)}));
+}
+
+void FApplyScheduler::Cancel(const UObject* Owner)
+{
+	check(IsInGameThread());
+
+	for (const TSharedRef<FJob>& Job : Jobs)
+	{
+		if (Job->Owner == Owner)
+		{
+			Job->Owner.Reset();
+		}
+	}
+}
+
+void FApplyScheduler::Start()
+{
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FApplyScheduler::Tick));
+}
+
+void FApplyScheduler::Stop()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	TickerHandle.Reset();
+
+	const TArray<TSharedRef<FJob>> DroppedJobs = MoveTemp(Jobs);
+	for (const TSharedRef<FJob>& Job : DroppedJobs)
+	{
+		if (Job->OnDropped)
+		{
+			Job->OnDropped();
+		}
+	}
+}
+
+bool FApplyScheduler::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ApplyScheduler_Tick);
+
+	const double EndTime = FPlatformTime::Seconds() + CVarApplyBudgetMs.GetValueOnGameThread() / 1000.0;
+	bool bFirstStep = true;
+
+	int32 JobIndex = 0;
+	while (JobIndex < Jobs.Num())
+	{
+		const TSharedRef<FJob> Job = Jobs[JobIndex];
+		if (!Job->Owner.IsValid())
+		{
+			Jobs.RemoveAt(JobIndex);
+			if (Job->OnDropped)
+			{
+				Job->OnDropped();
+			}
+			continue;
+		}
+
+		// Always run at least one step so that results are applied even if a single step exceeds the budget
+		if (!bFirstStep && FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+		bFirstStep = false;
+
+		const EApplyStepResult Result = Job->Step();
+		if (Result == EApplyStepResult::Done)
+		{
+			Jobs.RemoveAt(JobIndex);
+		}
+		else if (Result == EApplyStepResult::Wait)
+		{
+			++JobIndex;
+		}
+	}
+
+	return true;
+}
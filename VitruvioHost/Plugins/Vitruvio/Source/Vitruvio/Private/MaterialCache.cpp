@@ -0,0 +1,153 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialCache.h"
+
+#include "HAL/IConsoleManager.h"
+#include "VitruvioModule.h"
+
+namespace
+{
+TAutoConsoleVariable<int32> CVarMaterialCacheBudget(TEXT("vitruvio.MaterialCache.Budget"), 1024,
+													TEXT("Number of generated materials kept in the material cache. Materials which are still "
+														 "referenced are never evicted. 0 disables eviction."));
+
+FAutoConsoleCommand MaterialCacheStatsCommand(TEXT("vitruvio.MaterialCache.Stats"), TEXT("Logs the statistics of the generated material cache."),
+											  FConsoleCommandDelegate::CreateLambda([]() {
+												  const FMaterialCacheStats Stats = VitruvioModule::Get().GetMaterialCache().GetStats();
+												  UE_LOG(LogUnrealPrt, Display,
+														 TEXT("Material cache: %d materials (%d referenced), %llu hits, %llu misses, %llu evictions, "
+															  "%d interned materials"),
+														 Stats.NumMaterials, Stats.NumReferencedMaterials, Stats.Hits, Stats.Misses, Stats.Evictions,
+														 VitruvioModule::Get().GetMaterialInternTable().Num());
+											  }));
+} // namespace
+
+UMaterialInstanceDynamic* FMaterialCache::Get(Vitruvio::FMaterialId Id, FMaterialReferencePtr& OutReference)
+{
+	check(IsInGameThread());
+
+	FEntry* Entry = Entries.Find(Id);
+	if (!Entry)
+	{
+		++Misses;
+		return nullptr;
+	}
+
+	OutReference = Entry->Reference.Pin();
+	if (!OutReference)
+	{
+		OutReference = MakeShared<FMaterialReference>(Id);
+		Entry->Reference = OutReference;
+	}
+
+	++Hits;
+	Entry->LastUsed = ++UseCounter;
+	return Entry->Material;
+}
+
+FMaterialReferencePtr FMaterialCache::Add(Vitruvio::FMaterialId Id, UMaterialInstanceDynamic* Material)
+{
+	check(IsInGameThread());
+
+	FMaterialReferencePtr Reference = MakeShared<FMaterialReference>(Id);
+
+	FEntry& Entry = Entries.Add(Id);
+	Entry.Material = Material;
+	Entry.Reference = Reference;
+	Entry.InternedMaterial = VitruvioModule::Get().GetMaterialInternTable().Get(Id);
+	Entry.LastUsed = ++UseCounter;
+
+	return Reference;
+}
+
+void FMaterialCache::EvictUnreferenced()
+{
+	check(IsInGameThread());
+
+	const int32 Budget = CVarMaterialCacheBudget.GetValueOnGameThread();
+	if (Budget <= 0 || Entries.Num() <= Budget)
+	{
+		return;
+	}
+
+	TArray<TPair<uint64, Vitruvio::FMaterialId>> LeastRecentlyUsed;
+	for (const auto& [Id, Entry] : Entries)
+	{
+		if (!Entry.Reference.IsValid())
+		{
+			LeastRecentlyUsed.Emplace(Entry.LastUsed, Id);
+		}
+	}
+	LeastRecentlyUsed.Sort([](const TPair<uint64, Vitruvio::FMaterialId>& Lhs, const TPair<uint64, Vitruvio::FMaterialId>& Rhs) {
+		return Lhs.Key < Rhs.Key;
+	});
+
+	int32 NumEvicted = 0;
+	for (const auto& [LastUsed, Id] : LeastRecentlyUsed)
+	{
+		if (Entries.Num() <= Budget)
+		{
+			break;
+		}
+
+		Entries.Remove(Id);
+		++NumEvicted;
+	}
+	Evictions += NumEvicted;
+
+	// The evicted entries may have held the last references to their interned materials
+	if (NumEvicted > 0)
+	{
+		VitruvioModule::Get().GetMaterialInternTable().RemoveUnreferenced();
+	}
+
+	UE_LOG(LogUnrealPrt, Verbose, TEXT("Evicted %d materials from the material cache, %d remaining"), NumEvicted, Entries.Num());
+}
+
+void FMaterialCache::ForEachMaterial(TFunctionRef<void(const UMaterialInstanceDynamic*)> Function) const
+{
+	for (const auto& [Id, Entry] : Entries)
+	{
+		Function(Entry.Material);
+	}
+}
+
+FMaterialCacheStats FMaterialCache::GetStats() const
+{
+	FMaterialCacheStats Stats;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	Stats.NumMaterials = Entries.Num();
+	for (const auto& [Id, Entry] : Entries)
+	{
+		Stats.NumReferencedMaterials += Entry.Reference.IsValid() ? 1 : 0;
+	}
+	return Stats;
+}
+
+void FMaterialCache::Empty()
+{
+	Entries.Empty();
+}
+
+void FMaterialCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& [Id, Entry] : Entries)
+	{
+		Collector.AddReferencedObject(Entry.Material);
+	}
+}
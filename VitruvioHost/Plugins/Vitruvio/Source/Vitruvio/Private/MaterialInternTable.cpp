@@ -0,0 +1,70 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialInternTable.h"
+
+TSharedRef<const Vitruvio::FMaterialAttributeContainer> FMaterialInternTable::Intern(const Vitruvio::FMaterialAttributeContainer& Material)
+{
+	FScopeLock Lock(&MaterialInternTableCriticalSection);
+
+	TWeakPtr<const Vitruvio::FMaterialAttributeContainer>& Entry = Materials.FindOrAdd(Material.Id);
+	if (const TSharedPtr<const Vitruvio::FMaterialAttributeContainer> Result = Entry.Pin())
+	{
+		ensureMsgf(Result->HasEqualProperties(Material), TEXT("Material id collision for %s"), *Material.Name);
+		return Result.ToSharedRef();
+	}
+
+	TSharedRef<const Vitruvio::FMaterialAttributeContainer> Result = MakeShared<const Vitruvio::FMaterialAttributeContainer>(Material);
+	Entry = Result;
+
+	if (Materials.Num() >= RemoveUnreferencedThreshold)
+	{
+		RemoveUnreferencedLocked();
+		RemoveUnreferencedThreshold = FMath::Max(256, Materials.Num() * 2);
+	}
+
+	return Result;
+}
+
+TSharedPtr<const Vitruvio::FMaterialAttributeContainer> FMaterialInternTable::Get(Vitruvio::FMaterialId Id) const
+{
+	FScopeLock Lock(&MaterialInternTableCriticalSection);
+	const auto Result = Materials.Find(Id);
+
+	return Result ? Result->Pin() : TSharedPtr<const Vitruvio::FMaterialAttributeContainer>{};
+}
+
+void FMaterialInternTable::RemoveUnreferenced()
+{
+	FScopeLock Lock(&MaterialInternTableCriticalSection);
+	RemoveUnreferencedLocked();
+}
+
+int32 FMaterialInternTable::Num() const
+{
+	FScopeLock Lock(&MaterialInternTableCriticalSection);
+	return Materials.Num();
+}
+
+void FMaterialInternTable::RemoveUnreferencedLocked()
+{
+	for (auto It = Materials.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -35,8 +35,44 @@ TSharedPtr<FVitruvioMesh> FMeshCache::InsertOrGet(const FString& Id, const TShar
 	return Mesh;
 }
 
+TSharedPtr<FVitruvioMesh> FMeshCache::GetModel(const FModelKey& Key)
+{
+	FScopeLock Lock(&MeshCacheCriticalSection);
+	const auto Result = ModelCache.Find(Key);
+
+	return Result ? Result->Pin() : TSharedPtr<FVitruvioMesh>{};
+}
+
+TSharedPtr<FVitruvioMesh> FMeshCache::InsertOrGetModel(const FModelKey& Key, const TSharedPtr<FVitruvioMesh>& Mesh)
+{
+	FScopeLock Lock(&MeshCacheCriticalSection);
+	TWeakPtr<FVitruvioMesh>& Entry = ModelCache.FindOrAdd(Key);
+	if (TSharedPtr<FVitruvioMesh> CachedMesh = Entry.Pin())
+	{
+		return CachedMesh;
+	}
+
+	Entry = Mesh;
+
+	if (ModelCache.Num() >= RemoveReleasedModelsThreshold)
+	{
+		for (auto It = ModelCache.CreateIterator(); It; ++It)
+		{
+			if (!It->Value.IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		RemoveReleasedModelsThreshold = FMath::Max(256, ModelCache.Num() * 2);
+	}
+
+	return Mesh;
+}
+
 void FMeshCache::Empty()
 {
 	FScopeLock Lock(&MeshCacheCriticalSection);
 	Cache.Empty();
+	ModelCache.Empty();
+	RemoveReleasedModelsThreshold = 256;
 }
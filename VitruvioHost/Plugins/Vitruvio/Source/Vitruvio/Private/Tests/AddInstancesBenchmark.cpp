@@ -0,0 +1,146 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UnrealCallbacks.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 NumBenchmarkInstances = 100000;
+constexpr int32 NumMaterialVariants = 4;
+
+const wchar_t* BenchmarkMeshId = L"BenchmarkMesh";
+
+// Column major transforms with a uniform scale and translations on a grid, like scattered vegetation
+TArray<double> CreateTransforms(int32 NumInstances)
+{
+	TArray<double> Transforms;
+	Transforms.SetNumZeroed(NumInstances * 16);
+	for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+	{
+		double* Transform = Transforms.GetData() + InstanceIndex * 16;
+		const double Scale = 0.5 + (InstanceIndex % 7) * 0.1;
+		Transform[0] = Scale;
+		Transform[5] = Scale;
+		Transform[10] = Scale;
+		Transform[12] = (InstanceIndex % 1000) * 2.0;
+		Transform[14] = (InstanceIndex / 1000) * 2.0;
+		Transform[15] = 1.0;
+	}
+	return Transforms;
+}
+
+AttributeMapUPtr CreateMaterial(int32 Variant)
+{
+	const AttributeMapBuilderUPtr Builder(prt::AttributeMapBuilder::create());
+	const double DiffuseColor[] = {0.2, 0.3 + Variant * 0.1, 0.1};
+	Builder->setFloatArray(L"diffuseColor", DiffuseColor, 3);
+	Builder->setFloat(L"roughness", 0.8);
+	return AttributeMapUPtr(Builder->createAttributeMap());
+}
+
+int32 CountTransforms(const Vitruvio::FInstanceMap& Instances)
+{
+	int32 NumTransforms = 0;
+	for (const auto& [Key, InstanceData] : Instances)
+	{
+		NumTransforms += InstanceData.Transforms.Num();
+	}
+	return NumTransforms;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioAddInstancesBenchmark, "Vitruvio.Benchmarks.AddInstances",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FVitruvioAddInstancesBenchmark::RunTest(const FString& Parameters)
+{
+	const TArray<double> Transforms = CreateTransforms(NumBenchmarkInstances);
+
+	AttributeMapVector Materials;
+	AttributeMapNOPtrVector MaterialOverrides;
+	for (int32 Variant = 0; Variant < NumMaterialVariants; ++Variant)
+	{
+		Materials.push_back(CreateMaterial(Variant));
+		MaterialOverrides.push_back(Materials.back().get());
+	}
+
+	TArray<uint32_t> MaterialOverrideIndices;
+	MaterialOverrideIndices.SetNum(NumBenchmarkInstances);
+	for (int32 InstanceIndex = 0; InstanceIndex < NumBenchmarkInstances; ++InstanceIndex)
+	{
+		MaterialOverrideIndices[InstanceIndex] = InstanceIndex % NumMaterialVariants;
+	}
+
+	// The prototype mesh itself is irrelevant for the instance conversion
+	TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
+	const TSharedPtr<FVitruvioMesh> BenchmarkMesh =
+		MakeShared<FVitruvioMesh>(BenchmarkMeshId, FMeshDescription(), TArray<Vitruvio::FMaterialAttributeContainer>());
+	const UnrealCallbacks::FCachedPrototypeLookup FindCachedPrototype = [&BenchmarkMesh](const FString&) { return BenchmarkMesh; };
+
+	// One callback per instance, as emitted by encoders before addInstances
+	UnrealCallbacks PerInstanceCallbacks(AttributeMapBuilders, FindCachedPrototype);
+	TestTrue(TEXT("Prototype is cached"), PerInstanceCallbacks.isCachedPrototype(BenchmarkMeshId));
+	const double PerInstanceStart = FPlatformTime::Seconds();
+	for (int32 InstanceIndex = 0; InstanceIndex < NumBenchmarkInstances; ++InstanceIndex)
+	{
+		const prt::AttributeMap* InstanceMaterial = MaterialOverrides[MaterialOverrideIndices[InstanceIndex]];
+		PerInstanceCallbacks.addInstance(0, BenchmarkMeshId, Transforms.GetData() + InstanceIndex * 16, &InstanceMaterial, 1);
+	}
+	const double PerInstanceSeconds = FPlatformTime::Seconds() - PerInstanceStart;
+
+	// One batch for all instances of the mesh
+	UnrealCallbacks BatchCallbacks(AttributeMapBuilders, FindCachedPrototype);
+	TestTrue(TEXT("Prototype is cached"), BatchCallbacks.isCachedPrototype(BenchmarkMeshId));
+	const double BatchStart = FPlatformTime::Seconds();
+	BatchCallbacks.addInstances(0, BenchmarkMeshId, L"", Transforms.GetData(), NumBenchmarkInstances, MaterialOverrideIndices.GetData(),
+								MaterialOverrides.data(), NumMaterialVariants, 1);
+	const double BatchSeconds = FPlatformTime::Seconds() - BatchStart;
+
+	AddInfo(FString::Printf(TEXT("%d instances: addInstance %.1f ms, addInstances %.1f ms (%.1fx)"), NumBenchmarkInstances,
+							PerInstanceSeconds * 1000.0, BatchSeconds * 1000.0, PerInstanceSeconds / FMath::Max(BatchSeconds, UE_SMALL_NUMBER)));
+
+	const Vitruvio::FInstanceMap& PerInstanceResult = PerInstanceCallbacks.GetInstances();
+	const Vitruvio::FInstanceMap& BatchResult = BatchCallbacks.GetInstances();
+	TestEqual(TEXT("Number of instance groups"), BatchResult.Num(), PerInstanceResult.Num());
+	TestEqual(TEXT("Number of batched instances"), CountTransforms(BatchResult), NumBenchmarkInstances);
+	TestEqual(TEXT("Number of single instances"), CountTransforms(PerInstanceResult), NumBenchmarkInstances);
+
+	for (const auto& [Key, InstanceData] : BatchResult)
+	{
+		const Vitruvio::FInstanceData* PerInstanceData = PerInstanceResult.Find(Key);
+		if (!TestNotNull(TEXT("Instance group of single instances"), PerInstanceData))
+		{
+			continue;
+		}
+
+		TestEqual(TEXT("Instances per group"), InstanceData.Transforms.Num(), PerInstanceData->Transforms.Num());
+		for (int32 InstanceIndex = 0; InstanceIndex < FMath::Min(InstanceData.Transforms.Num(), PerInstanceData->Transforms.Num()); ++InstanceIndex)
+		{
+			if (!InstanceData.Transforms[InstanceIndex].Equals(PerInstanceData->Transforms[InstanceIndex]))
+			{
+				AddError(FString::Printf(TEXT("Transform %d differs between addInstance and addInstances"), InstanceIndex));
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,221 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UnrealCallbacks.h"
+
+#include "Hash/xxhash.h"
+#include "Misc/AutomationTest.h"
+#include "StaticMeshAttributes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+// 1000 x 1000 quads split into face ranges with different materials
+constexpr int32 GridSize = 1000;
+constexpr int32 NumFaceRanges = 16;
+
+struct FSyntheticMesh
+{
+	TArray<double> Vertices;
+	TArray<double> Normals;
+	TArray<uint32_t> FaceVertexCounts;
+	TArray<uint32_t> VertexIndices;
+	TArray<uint32_t> NormalIndices;
+
+	// A single (colorMap) uv set with one uv per vertex
+	TArray<double> UVs;
+	TArray<uint32_t> UVCounts;
+	TArray<uint32_t> UVIndices;
+
+	TArray<uint32_t> FaceRanges;
+	AttributeMapVector Materials;
+	AttributeMapNOPtrVector MaterialPtrs;
+};
+
+FSyntheticMesh CreateGridMesh()
+{
+	FSyntheticMesh Mesh;
+
+	const int32 NumVerticesPerSide = GridSize + 1;
+	Mesh.Vertices.Reserve(NumVerticesPerSide * NumVerticesPerSide * 3);
+	Mesh.UVs.Reserve(NumVerticesPerSide * NumVerticesPerSide * 2);
+	for (int32 Y = 0; Y < NumVerticesPerSide; ++Y)
+	{
+		for (int32 X = 0; X < NumVerticesPerSide; ++X)
+		{
+			Mesh.Vertices.Append({static_cast<double>(X), 0.0, static_cast<double>(Y)});
+			Mesh.UVs.Append({static_cast<double>(X) / GridSize, static_cast<double>(Y) / GridSize});
+		}
+	}
+	Mesh.Normals = {0.0, 1.0, 0.0};
+
+	const int32 NumFaces = GridSize * GridSize;
+	Mesh.FaceVertexCounts.Init(4, NumFaces);
+	Mesh.UVCounts.Init(4, NumFaces);
+	Mesh.NormalIndices.Init(0, NumFaces * 4);
+	Mesh.VertexIndices.Reserve(NumFaces * 4);
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const uint32_t Base = Y * NumVerticesPerSide + X;
+			Mesh.VertexIndices.Append({Base, Base + NumVerticesPerSide, Base + NumVerticesPerSide + 1, Base + 1});
+		}
+	}
+	Mesh.UVIndices = Mesh.VertexIndices;
+
+	for (int32 RangeIndex = 0; RangeIndex < NumFaceRanges; ++RangeIndex)
+	{
+		Mesh.FaceRanges.Add(NumFaces / NumFaceRanges + (RangeIndex < NumFaces % NumFaceRanges ? 1 : 0));
+
+		const AttributeMapBuilderUPtr Builder(prt::AttributeMapBuilder::create());
+		const double DiffuseColor[] = {static_cast<double>(RangeIndex) / NumFaceRanges, 0.5, 0.5};
+		Builder->setFloatArray(L"diffuseColor", DiffuseColor, 3);
+		Mesh.Materials.push_back(AttributeMapUPtr(Builder->createAttributeMap()));
+		Mesh.MaterialPtrs.push_back(Mesh.Materials.back().get());
+	}
+
+	return Mesh;
+}
+
+// The conversion before it was made table driven and parallel, one vertex instance and uv set lookup at a time
+FMeshDescription ConvertMeshReference(const FSyntheticMesh& Mesh)
+{
+	const TMap<Vitruvio::EPrtUvSetType, Vitruvio::EUnrealUvSetType> PRTToUnrealUVSetMap = {
+		{Vitruvio::EPrtUvSetType::ColorMap, Vitruvio::EUnrealUvSetType::ColorMap}};
+
+	FMeshDescription Description;
+	FStaticMeshAttributes Attributes(Description);
+	Attributes.Register();
+
+	const auto VertexUVs = Attributes.GetVertexInstanceUVs();
+	VertexUVs.SetNumChannels(8);
+
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	for (int32 VertexIndex = 0; VertexIndex < Mesh.Vertices.Num(); VertexIndex += 3)
+	{
+		const FVertexID VertexID = Description.CreateVertex();
+		VertexPositions[VertexID] = FVector3f(Mesh.Vertices[VertexIndex], Mesh.Vertices[VertexIndex + 2], Mesh.Vertices[VertexIndex + 1]) * 100.0f;
+	}
+
+	const auto Normals = Attributes.GetVertexInstanceNormals();
+	int32 Face = 0;
+	int32 BaseVertexIndex = 0;
+	int32 BaseUVIndex = 0;
+	for (const uint32_t FaceRange : Mesh.FaceRanges)
+	{
+		const FPolygonGroupID PolygonGroupId = Description.CreatePolygonGroup();
+		for (uint32_t FaceIndex = 0; FaceIndex < FaceRange; ++FaceIndex, ++Face)
+		{
+			const uint32_t FaceVertexCount = Mesh.FaceVertexCounts[Face];
+			TArray<FVertexInstanceID> PolygonVertexInstances;
+			for (uint32_t FaceVertexIndex = 0; FaceVertexIndex < FaceVertexCount; ++FaceVertexIndex)
+			{
+				const uint32_t VertexIndex = Mesh.VertexIndices[BaseVertexIndex + FaceVertexIndex];
+				const uint32_t NormalIndex = Mesh.NormalIndices[BaseVertexIndex + FaceVertexIndex] * 3;
+				const FVertexInstanceID InstanceId = Description.CreateVertexInstance(FVertexID(VertexIndex));
+				PolygonVertexInstances.Add(InstanceId);
+				Normals[InstanceId] = FVector3f(Mesh.Normals[NormalIndex], Mesh.Normals[NormalIndex + 2], Mesh.Normals[NormalIndex + 1]);
+
+				if (const Vitruvio::EUnrealUvSetType* UnrealUVSet = PRTToUnrealUVSetMap.Find(Vitruvio::EPrtUvSetType::ColorMap))
+				{
+					const uint32_t UVIndex = Mesh.UVIndices[BaseUVIndex + FaceVertexIndex] * 2;
+					VertexUVs.Set(InstanceId, static_cast<int32>(*UnrealUVSet), FVector2f(Mesh.UVs[UVIndex], -Mesh.UVs[UVIndex + 1]));
+				}
+			}
+
+			Description.CreatePolygon(PolygonGroupId, PolygonVertexInstances);
+			BaseVertexIndex += FaceVertexCount;
+			BaseUVIndex += Mesh.UVCounts[Face];
+		}
+	}
+
+	return Description;
+}
+
+uint64 HashVertexInstances(const FMeshDescription& Description)
+{
+	FXxHash64Builder Builder;
+	const auto UpdateArray = [&Builder](const auto& Array) { Builder.Update(Array.GetData(), Array.Num() * sizeof(Array[0])); };
+
+	FStaticMeshConstAttributes Attributes(Description);
+	UpdateArray(Attributes.GetVertexPositions().GetRawArray());
+	UpdateArray(Attributes.GetVertexInstanceNormals().GetRawArray());
+	UpdateArray(Attributes.GetVertexInstanceUVs().GetRawArray(0));
+	for (const FVertexInstanceID VertexInstanceID : Description.VertexInstances().GetElementIDs())
+	{
+		const int32 VertexIndex = Description.GetVertexInstanceVertex(VertexInstanceID).GetValue();
+		Builder.Update(&VertexIndex, sizeof(VertexIndex));
+	}
+	for (const FTriangleID TriangleID : Description.Triangles().GetElementIDs())
+	{
+		const int32 PolygonGroupIndex = Description.GetTrianglePolygonGroup(TriangleID).GetValue();
+		Builder.Update(&PolygonGroupIndex, sizeof(PolygonGroupIndex));
+	}
+	return Builder.Finalize().Hash;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioConvertMeshBenchmark, "Vitruvio.Benchmarks.ConvertMesh",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FVitruvioConvertMeshBenchmark::RunTest(const FString& Parameters)
+{
+	const FSyntheticMesh Mesh = CreateGridMesh();
+
+	// Run one conversion after the other so that only one of the large mesh descriptions is alive at a time
+	double ReferenceSeconds;
+	uint64 ReferenceHash;
+	{
+		const double Start = FPlatformTime::Seconds();
+		const FMeshDescription Description = ConvertMeshReference(Mesh);
+		ReferenceSeconds = FPlatformTime::Seconds() - Start;
+		ReferenceHash = HashVertexInstances(Description);
+	}
+
+	double ConvertSeconds;
+	uint64 ConvertHash;
+	{
+		const double* UVs[] = {Mesh.UVs.GetData()};
+		const size_t UVsSizes[] = {static_cast<size_t>(Mesh.UVs.Num())};
+		const uint32_t* UVCounts[] = {Mesh.UVCounts.GetData()};
+		const size_t UVCountsSizes[] = {static_cast<size_t>(Mesh.UVCounts.Num())};
+		const uint32_t* UVIndices[] = {Mesh.UVIndices.GetData()};
+		const size_t UVIndicesSizes[] = {static_cast<size_t>(Mesh.UVIndices.Num())};
+
+		TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
+		UnrealCallbacks Callbacks(AttributeMapBuilders);
+		Callbacks.init();
+
+		const double Start = FPlatformTime::Seconds();
+		Callbacks.addMesh(L"", L"", UnrealCallbacks::NoPrototypeIndex, L"", Mesh.Vertices.GetData(), Mesh.Vertices.Num(), Mesh.Normals.GetData(),
+						  Mesh.Normals.Num(), Mesh.FaceVertexCounts.GetData(), Mesh.FaceVertexCounts.Num(), Mesh.VertexIndices.GetData(),
+						  Mesh.VertexIndices.Num(), Mesh.NormalIndices.GetData(), Mesh.NormalIndices.Num(), UVs, UVsSizes, UVCounts, UVCountsSizes,
+						  UVIndices, UVIndicesSizes, 1, Mesh.FaceRanges.GetData(), Mesh.FaceRanges.Num(),
+						  const_cast<const prt::AttributeMap**>(Mesh.MaterialPtrs.data()));
+		ConvertSeconds = FPlatformTime::Seconds() - Start;
+		ConvertHash = HashVertexInstances(Callbacks.GetModelDescription().MeshDescription);
+	}
+
+	AddInfo(FString::Printf(TEXT("%d faces: reference %.1f ms, ConvertMesh %.1f ms (%.1fx)"), GridSize * GridSize, ReferenceSeconds * 1000.0,
+							ConvertSeconds * 1000.0, ReferenceSeconds / FMath::Max(ConvertSeconds, UE_SMALL_NUMBER)));
+
+	TestEqual(TEXT("Converted vertices, normals, uvs and polygon groups"), ConvertHash, ReferenceHash);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
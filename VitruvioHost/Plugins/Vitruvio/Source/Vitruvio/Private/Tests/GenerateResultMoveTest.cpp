@@ -0,0 +1,138 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UnrealCallbacks.h"
+#include "VitruvioComponent.h"
+
+#include "Async/Async.h"
+#include "Containers/Queue.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 NumInstances = 10000;
+
+const wchar_t* MeshId = L"MoveTestMesh";
+
+// A copied transform array gets its own allocation while a moved one keeps it, so copies are counted by comparing the buffers
+using FTransformBuffers = TMap<Vitruvio::FInstanceCacheKey, const FTransform*>;
+
+FTransformBuffers GetTransformBuffers(const Vitruvio::FInstanceMap& Instances)
+{
+	FTransformBuffers Buffers;
+	for (const auto& [Key, InstanceData] : Instances)
+	{
+		Buffers.Add(Key, InstanceData.Transforms.GetData());
+	}
+	return Buffers;
+}
+
+int32 CountCopies(const FTransformBuffers& Original, const FTransformBuffers& Current)
+{
+	int32 NumCopies = 0;
+	for (const auto& [Key, Buffer] : Original)
+	{
+		const FTransform* const* CurrentBuffer = Current.Find(Key);
+		if (!CurrentBuffer || *CurrentBuffer != Buffer)
+		{
+			++NumCopies;
+		}
+	}
+	return NumCopies;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioGenerateResultMoveTest, "Vitruvio.GenerateResult.Move",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioGenerateResultMoveTest::RunTest(const FString& Parameters)
+{
+	TArray<double> Transforms;
+	Transforms.SetNumZeroed(NumInstances * 16);
+	for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+	{
+		double* Transform = Transforms.GetData() + InstanceIndex * 16;
+		Transform[0] = Transform[5] = Transform[10] = Transform[15] = 1.0;
+		Transform[12] = InstanceIndex * 2.0;
+	}
+	TArray<uint32_t> MaterialOverrideIndices;
+	MaterialOverrideIndices.SetNumZeroed(NumInstances);
+
+	// Collect the instances like generate does, the prototype mesh itself is never built
+	TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
+	const TSharedPtr<FVitruvioMesh> Mesh = MakeShared<FVitruvioMesh>(MeshId, FMeshDescription(), TArray<Vitruvio::FMaterialAttributeContainer>());
+	UnrealCallbacks Callbacks(AttributeMapBuilders, [&Mesh](const FString&) { return Mesh; });
+	TestTrue(TEXT("Prototype is cached"), Callbacks.isCachedPrototype(MeshId));
+	Callbacks.addInstances(0, MeshId, L"MoveTestMesh", Transforms.GetData(), NumInstances, MaterialOverrideIndices.GetData(), nullptr, 1, 0);
+
+	const FTransformBuffers Original = GetTransformBuffers(Callbacks.GetInstances());
+	if (!TestEqual(TEXT("Instance groups"), Original.Num(), 1))
+	{
+		return false;
+	}
+
+	// Hand the result over through a future and the generate queue like GenerateAsync and UVitruvioComponent::Generate do
+	const FGenerateResult::FTokenPtr Token = MakeShared<FGenerateToken>();
+	FGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::TaskGraph, [&Callbacks, Token]() {
+		FGenerateResultDescription Result = Callbacks.TakeGenerateResult();
+		return FGenerateResult::ResultType{Token, MoveTemp(Result)};
+	});
+
+	TQueue<FGenerateQueueItem> GenerateQueue;
+	ResultFuture.Next([&GenerateQueue](FGenerateResult::ResultType Result) { GenerateQueue.Enqueue({MoveTemp(Result.Value), {}, nullptr}); }).Wait();
+
+	FPendingGenerateResult PendingGenerateResult;
+	if (!TestTrue(TEXT("Result is enqueued"), GenerateQueue.Dequeue(PendingGenerateResult.Item)))
+	{
+		return false;
+	}
+
+	FGenerateResultDescription& GenerateResult = PendingGenerateResult.Item.GenerateResultDescription;
+	const int32 QueueCopies = CountCopies(Original, GetTransformBuffers(GenerateResult.Instances));
+
+	// Convert the instances without building any meshes, this moves the transforms into the converted result
+	FApplyGenerateResultState& State = PendingGenerateResult.State;
+	GenerateResult.Instances.GenerateKeyArray(State.InstanceKeys);
+	State.Stage = EApplyGenerateResultStage::ConvertInstances;
+
+	FMaterialCache MaterialCache;
+	FTextureCache TextureCache;
+	TMap<UMaterialInterface*, FString> MaterialIdentifiers;
+	TMap<FString, int32> UniqueMaterialIdentifiers;
+	while (State.Stage == EApplyGenerateResultStage::ConvertInstances)
+	{
+		BuildGenerateResultStep(GenerateResult, State, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers, nullptr,
+								nullptr, nullptr, nullptr);
+	}
+
+	const TArray<FInstance>& ConvertedInstances = State.ConvertedResult.Instances;
+	if (!TestEqual(TEXT("Converted instances"), ConvertedInstances.Num(), 1))
+	{
+		return false;
+	}
+
+	const int32 ConvertCopies = CountCopies(Original, {{State.InstanceKeys[0], ConvertedInstances[0].Transforms.GetData()}});
+	AddInfo(FString::Printf(TEXT("%d instance transforms: %d copies until dequeued, %d copies until converted"), NumInstances, QueueCopies,
+							ConvertCopies));
+	TestEqual(TEXT("Transforms are not copied until dequeued"), QueueCopies, 0);
+	TestEqual(TEXT("Transforms are not copied when converted"), ConvertCopies, 0);
+	TestEqual(TEXT("Converted transforms"), ConvertedInstances[0].Transforms.Num(), NumInstances);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
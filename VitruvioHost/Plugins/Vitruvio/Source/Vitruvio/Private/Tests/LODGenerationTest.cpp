@@ -0,0 +1,144 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Util/LODGeneration.h"
+
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAABBTree3.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "Misc/AutomationTest.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+// A 64 x 64 quad grid (25 cm spacing) with smooth bumps of 50 cm, like a curved roof
+FMeshDescription CreateBumpyGrid()
+{
+	constexpr int32 GridSize = 64;
+	constexpr float Spacing = 25.0f;
+	constexpr float Amplitude = 50.0f;
+
+	FMeshDescription Description;
+	FStaticMeshAttributes Attributes(Description);
+	Attributes.Register();
+
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	TArray<FVertexID> Vertices;
+	for (int32 Y = 0; Y <= GridSize; ++Y)
+	{
+		for (int32 X = 0; X <= GridSize; ++X)
+		{
+			const FVertexID VertexID = Description.CreateVertex();
+			const float Height = Amplitude * FMath::Sin(X * PI / 16.0f) * FMath::Cos(Y * PI / 16.0f);
+			VertexPositions[VertexID] = FVector3f(X * Spacing, Y * Spacing, Height);
+			Vertices.Add(VertexID);
+		}
+	}
+
+	const FPolygonGroupID PolygonGroupID = Description.CreatePolygonGroup();
+	Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupID] = TEXT("Material");
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const int32 Base = Y * (GridSize + 1) + X;
+			TArray<FVertexInstanceID> VertexInstances;
+			for (const int32 VertexIndex : {Base, Base + 1, Base + GridSize + 2, Base + GridSize + 1})
+			{
+				VertexInstances.Add(Description.CreateVertexInstance(Vertices[VertexIndex]));
+			}
+			Description.CreatePolygon(PolygonGroupID, VertexInstances);
+		}
+	}
+
+	FStaticMeshOperations::ComputeTriangleTangentsAndNormals(Description, THRESH_POINTS_ARE_SAME);
+	FStaticMeshOperations::ComputeTangentsAndNormals(Description, EComputeNTBsFlags::Normals | EComputeNTBsFlags::Tangents);
+	return Description;
+}
+
+// Largest distance of any vertex of the LOD from the surface of the source mesh
+double MaxVertexDistance(const FMeshDescription& LOD, const UE::Geometry::FDynamicMeshAABBTree3& SourceSpatial)
+{
+	double MaxDistance = 0.0;
+	const FStaticMeshConstAttributes Attributes(LOD);
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	for (const FVertexID VertexID : LOD.Vertices().GetElementIDs())
+	{
+		double DistanceSquared = 0.0;
+		SourceSpatial.FindNearestTriangle(FVector3d(VertexPositions[VertexID]), DistanceSquared);
+		MaxDistance = FMath::Max(MaxDistance, FMath::Sqrt(DistanceSquared));
+	}
+	return MaxDistance;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioLODGenerationTest, "Vitruvio.LODGeneration",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioLODGenerationTest::RunTest(const FString& Parameters)
+{
+	const FMeshDescription Source = CreateBumpyGrid();
+
+	UE::Geometry::FDynamicMesh3 SourceMesh;
+	FMeshDescriptionToDynamicMesh ToDynamicMesh;
+	ToDynamicMesh.Convert(&Source, SourceMesh);
+	const UE::Geometry::FDynamicMeshAABBTree3 SourceSpatial(&SourceMesh, true);
+
+	Vitruvio::FLODSettings Settings;
+	Settings.ScreenSizes = {0.5f, 0.25f, 0.125f};
+	Settings.TriangleRatio = 0.5f;
+	Settings.MinTriangles = 64;
+
+	for (const float MaxGeometricError : {0.0f, 2.0f})
+	{
+		Settings.MaxGeometricError = MaxGeometricError;
+		const TArray<FMeshDescription> LODs = Vitruvio::GenerateLODs(Source, Settings);
+
+		if (!TestTrue(FString::Printf(TEXT("LODs generated with error bound %.1f"), MaxGeometricError), LODs.Num() > 0))
+		{
+			continue;
+		}
+		TestTrue(TEXT("At most one LOD per screen size"), LODs.Num() <= Settings.ScreenSizes.Num());
+
+		int32 PreviousTriangles = Source.Triangles().Num();
+		for (int32 LODIndex = 0; LODIndex < LODs.Num(); ++LODIndex)
+		{
+			const int32 Triangles = LODs[LODIndex].Triangles().Num();
+			AddInfo(FString::Printf(TEXT("Error bound %.1f cm, LOD%d: %d triangles, max vertex error %.2f cm"), MaxGeometricError, LODIndex + 1,
+									Triangles, MaxVertexDistance(LODs[LODIndex], SourceSpatial)));
+
+			TestTrue(FString::Printf(TEXT("LOD%d has fewer triangles than the previous LOD"), LODIndex + 1), Triangles < PreviousTriangles);
+			TestTrue(FString::Printf(TEXT("LOD%d keeps the minimum number of triangles"), LODIndex + 1), Triangles >= Settings.MinTriangles);
+			TestEqual(FString::Printf(TEXT("LOD%d keeps the polygon groups"), LODIndex + 1), LODs[LODIndex].PolygonGroups().Num(),
+					  Source.PolygonGroups().Num());
+
+			const float Bound = Settings.GetMaxGeometricError(LODIndex + 1);
+			if (Bound > 0.0f)
+			{
+				TestTrue(FString::Printf(TEXT("LOD%d is within its error bound of %.1f cm"), LODIndex + 1, Bound),
+						 MaxVertexDistance(LODs[LODIndex], SourceSpatial) <= Bound + UE_KINDA_SMALL_NUMBER);
+			}
+
+			PreviousTriangles = Triangles;
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
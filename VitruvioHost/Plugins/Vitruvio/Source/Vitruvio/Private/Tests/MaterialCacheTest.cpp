@@ -0,0 +1,119 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialCache.h"
+
+#include "Algo/Count.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Materials/Material.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/GCObject.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 Budget = 64;
+constexpr int32 NumModels = 8;
+constexpr int32 NumMaterialsPerModel = 4;
+constexpr int32 NumEdits = 1000;
+constexpr int32 GarbageCollectionInterval = 100;
+
+// Reports the materials of the cache to the garbage collector like VitruvioModule does for its cache
+class FTestMaterialCache : public FGCObject
+{
+public:
+	FMaterialCache Cache;
+
+	void AddReferencedObjects(FReferenceCollector& Collector) override
+	{
+		Cache.AddReferencedObjects(Collector);
+	}
+
+	FString GetReferencerName() const override
+	{
+		return TEXT("FTestMaterialCache");
+	}
+};
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioMaterialCacheEditLoopTest, "Vitruvio.MaterialCache.EditLoop",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioMaterialCacheEditLoopTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* BudgetVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("vitruvio.MaterialCache.Budget"));
+	if (!TestNotNull(TEXT("Material cache budget variable"), BudgetVariable))
+	{
+		return false;
+	}
+	const int32 PreviousBudget = BudgetVariable->GetInt();
+	BudgetVariable->Set(Budget);
+
+	UMaterial* Parent = UMaterial::GetDefaultMaterial(MD_Surface);
+	FTestMaterialCache TestCache;
+	FMaterialCache& Cache = TestCache.Cache;
+
+	// Every edit changes an attribute of one model, which replaces all its materials (new ids) and drops the references to the old ones
+	TArray<TArray<FMaterialReferencePtr>> ModelReferences;
+	ModelReferences.SetNum(NumModels);
+	TArray<TWeakObjectPtr<UMaterialInstanceDynamic>> CreatedMaterials;
+	Vitruvio::FMaterialId NextId = 1;
+
+	const uint64 UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	int32 MaxCachedMaterials = 0;
+	for (int32 Edit = 0; Edit < NumEdits; ++Edit)
+	{
+		TArray<FMaterialReferencePtr>& References = ModelReferences[Edit % NumModels];
+		References.Reset();
+		for (int32 MaterialIndex = 0; MaterialIndex < NumMaterialsPerModel; ++MaterialIndex)
+		{
+			UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(Parent, GetTransientPackage());
+			CreatedMaterials.Add(Material);
+			References.Add(Cache.Add(NextId++, Material));
+		}
+		Cache.EvictUnreferenced();
+
+		const FMaterialCacheStats Stats = Cache.GetStats();
+		MaxCachedMaterials = FMath::Max(MaxCachedMaterials, Stats.NumMaterials);
+		TestEqual(FString::Printf(TEXT("Edit %d: the materials of all models are kept"), Edit), Stats.NumReferencedMaterials,
+				  FMath::Min(Edit + 1, NumModels) * NumMaterialsPerModel);
+
+		if ((Edit + 1) % GarbageCollectionInterval == 0)
+		{
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+			// Evicted materials are released by the garbage collector, only the cached ones stay alive
+			const int32 NumAliveMaterials =
+				Algo::CountIf(CreatedMaterials, [](const TWeakObjectPtr<UMaterialInstanceDynamic>& Material) { return Material.IsValid(); });
+			AddInfo(FString::Printf(TEXT("After %d edits: %d materials cached, %d alive"), Edit + 1, Stats.NumMaterials, NumAliveMaterials));
+			TestTrue(FString::Printf(TEXT("After %d edits at most %d materials are alive"), Edit + 1, Budget), NumAliveMaterials <= Budget);
+		}
+	}
+	const uint64 UsedMemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	AddInfo(FString::Printf(TEXT("%d edits created %d materials, at most %d were cached, used physical memory %lld KiB -> %lld KiB"), NumEdits,
+							CreatedMaterials.Num(), MaxCachedMaterials, static_cast<int64>(UsedMemoryBefore / 1024),
+							static_cast<int64>(UsedMemoryAfter / 1024)));
+	TestTrue(TEXT("The material cache stays within its budget"), MaxCachedMaterials <= FMath::Max(Budget, NumModels * NumMaterialsPerModel));
+
+	Cache.Empty();
+	BudgetVariable->Set(PreviousBudget);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
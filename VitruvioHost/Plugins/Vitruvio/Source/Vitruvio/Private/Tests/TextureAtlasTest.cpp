@@ -0,0 +1,139 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PRTTypes.h"
+#include "PRTUtils.h"
+#include "Util/TextureAtlas.h"
+#include "VitruvioModule.h"
+
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "StaticMeshAttributes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 NumTexturedQuads = 4;
+constexpr int32 TextureSize = 32;
+
+// Writes a single colored BGRA8 png and returns its file uri
+FString WriteTexture(const FString& Directory, int32 Index)
+{
+	TArray<FColor> Pixels;
+	Pixels.Init(FColor(static_cast<uint8>(Index * 60), static_cast<uint8>(255 - Index * 60), 128, 255), TextureSize * TextureSize);
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+	const TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), TextureSize, TextureSize, ERGBFormat::BGRA, 8);
+
+	const FString Path = FPaths::ConvertRelativePathToFull(Directory / FString::Printf(TEXT("Facade%d.png"), Index));
+	FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *Path);
+	return FString(WCHAR_TO_TCHAR(prtu::toFileURI(TCHAR_TO_WCHAR(*Path)).c_str()));
+}
+
+// One quad per material next to each other, with uvs covering the whole texture like a facade tile
+FMeshDescription CreateQuads(int32 NumQuads)
+{
+	FMeshDescription Description;
+	FStaticMeshAttributes Attributes(Description);
+	Attributes.Register();
+	Attributes.GetVertexInstanceUVs().SetNumChannels(1);
+
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	const auto VertexInstanceUVs = Attributes.GetVertexInstanceUVs();
+	const FVector2f Corners[] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+	for (int32 QuadIndex = 0; QuadIndex < NumQuads; ++QuadIndex)
+	{
+		const FPolygonGroupID PolygonGroupID = Description.CreatePolygonGroup();
+		TArray<FVertexInstanceID> VertexInstances;
+		for (const FVector2f& Corner : Corners)
+		{
+			const FVertexID VertexID = Description.CreateVertex();
+			VertexPositions[VertexID] = FVector3f((QuadIndex + Corner.X) * 100.0f, 0.0f, Corner.Y * 100.0f);
+			const FVertexInstanceID VertexInstanceID = Description.CreateVertexInstance(VertexID);
+			VertexInstanceUVs.Set(VertexInstanceID, 0, Corner);
+			VertexInstances.Add(VertexInstanceID);
+		}
+		Description.CreatePolygon(PolygonGroupID, VertexInstances);
+	}
+	return Description;
+}
+
+Vitruvio::FMaterialAttributeContainer CreateMaterial(double Roughness, const FString& ColorMap)
+{
+	const AttributeMapBuilderUPtr Builder(prt::AttributeMapBuilder::create());
+	Builder->setFloat(L"roughness", Roughness);
+	const AttributeMapUPtr AttributeMap(Builder->createAttributeMap());
+
+	Vitruvio::FMaterialAttributeContainer Material(AttributeMap.get());
+	if (!ColorMap.IsEmpty())
+	{
+		Material.TextureProperties.Add(TEXT("colorMap"), ColorMap);
+		Material.UpdateId();
+	}
+	return Material;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioTextureAtlasTest, "Vitruvio.TextureAtlas",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioTextureAtlasTest::RunTest(const FString& Parameters)
+{
+	// Texture metadata is read through PRT
+	if (!TestTrue(TEXT("PRT is initialized"), VitruvioModule::Get().IsInitialized()))
+	{
+		return false;
+	}
+
+	// Facade quads with their own textures but otherwise identical materials and one untextured quad which is not packed
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("TextureAtlas");
+	TArray<Vitruvio::FMaterialAttributeContainer> Materials;
+	for (int32 Index = 0; Index < NumTexturedQuads; ++Index)
+	{
+		Materials.Add(CreateMaterial(0.8, WriteTexture(Directory, Index)));
+	}
+	Materials.Add(CreateMaterial(0.2, FString()));
+
+	FMeshDescription Description = CreateQuads(Materials.Num());
+	TArray<Vitruvio::FTextureAtlasPagePtr> Pages;
+	const Vitruvio::FTextureAtlasStats Stats = Vitruvio::BuildTextureAtlases(Description, Materials, Pages);
+
+	AddInfo(FString::Printf(TEXT("%d textures packed into %d pages, %d -> %d materials, %d -> %d sections"), Stats.NumPackedTextures,
+							Stats.NumPages, Stats.NumMaterialsBefore, Stats.NumMaterialsAfter, Stats.NumSectionsBefore, Stats.NumSectionsAfter));
+	TestEqual(TEXT("Materials before"), Stats.NumMaterialsBefore, NumTexturedQuads + 1);
+	TestEqual(TEXT("Sections before"), Stats.NumSectionsBefore, NumTexturedQuads + 1);
+	TestEqual(TEXT("Packed textures"), Stats.NumPackedTextures, NumTexturedQuads);
+	TestEqual(TEXT("Pages"), Stats.NumPages, 1);
+	TestEqual(TEXT("Materials after"), Stats.NumMaterialsAfter, 2);
+	TestEqual(TEXT("Sections after"), Stats.NumSectionsAfter, 2);
+
+	// The reported counts match the mesh and materials which are built afterwards
+	TestEqual(TEXT("Remaining materials"), Materials.Num(), Stats.NumMaterialsAfter);
+	TestEqual(TEXT("Remaining polygon groups"), Description.PolygonGroups().Num(), Stats.NumSectionsAfter);
+	TestEqual(TEXT("Pages are held"), Pages.Num(), Stats.NumPages);
+	if (Materials.Num() > 0 && Materials[0].TextureProperties.Contains(TEXT("colorMap")))
+	{
+		TestTrue(TEXT("Merged material uses the atlas page"), Vitruvio::IsTextureAtlasPage(Materials[0].TextureProperties[TEXT("colorMap")]));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
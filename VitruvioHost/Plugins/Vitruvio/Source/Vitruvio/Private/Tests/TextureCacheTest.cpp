@@ -0,0 +1,169 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCache.h"
+#include "Util/TextureDecoding.h"
+#include "VitruvioModule.h"
+
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 TextureSize = 16;
+constexpr int32 EvictionTextureSize = 256;
+constexpr int32 MaxEvictionTextures = 64;
+
+// Decodes a synthetic RGB8 gradient like the texture cache does for the given file and material property, the seed changes its pixels
+Vitruvio::FTextureData DecodeSyntheticTexture(FTextureCache& Cache, const FString& Path, const FString& Key, int32 MaxResolution,
+											  int32 Size = TextureSize, uint8 Seed = 0)
+{
+	Vitruvio::FTextureMetadata Metadata;
+	Metadata.Width = Size;
+	Metadata.Height = Size;
+	Metadata.BytesPerBand = 1;
+	Metadata.Bands = 3;
+	Metadata.PixelFormat = Vitruvio::EPRTPixelFormat::RGB8;
+
+	const size_t BufferSize = Size * Size * 3;
+	auto Buffer = std::make_unique<uint8_t[]>(BufferSize);
+	for (size_t Index = 0; Index < BufferSize; ++Index)
+	{
+		Buffer[Index] = static_cast<uint8_t>(Index * 7 + Seed);
+	}
+
+	const uint64 Generation = Cache.GetGeneration();
+	const Vitruvio::FTextureData TextureData =
+		Vitruvio::DecodeTexture(GetTransientPackage(), Key, Path, Metadata, MoveTemp(Buffer), BufferSize, MaxResolution,
+								[&Cache](uint64 ContentHash) { return Cache.FindByContentHash(ContentHash); });
+	return Cache.InsertOrGet(Path, Key, MaxResolution, Generation, TextureData);
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioTextureCacheTest, "Vitruvio.TextureCache",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioTextureCacheTest::RunTest(const FString& Parameters)
+{
+	FTextureCache Cache;
+	const FString Path = TEXT("/Synthetic/Texture.png");
+	const FString CopyPath = TEXT("/Synthetic/TextureCopy.png");
+	const int32 MaxResolution = VitruvioModule::Get().GetMaxTextureResolution(Path);
+
+	const Vitruvio::FTextureData ColorMap = DecodeSyntheticTexture(Cache, Path, TEXT("colorMap"), MaxResolution);
+	const Vitruvio::FTextureData RoughnessMap = DecodeSyntheticTexture(Cache, Path, TEXT("roughnessMap"), MaxResolution);
+	if (!TestNotNull(TEXT("Color map decoded"), ColorMap.Texture) || !TestNotNull(TEXT("Roughness map decoded"), RoughnessMap.Texture))
+	{
+		return false;
+	}
+
+	// The same file used for two material properties results in two textures with their own settings
+	TestNotEqual(TEXT("Different properties have different textures"), ColorMap.Texture, RoughnessMap.Texture);
+	TestTrue(TEXT("Color map is sRGB"), static_cast<bool>(ColorMap.Texture->SRGB));
+	TestFalse(TEXT("Roughness map is linear"), static_cast<bool>(RoughnessMap.Texture->SRGB));
+
+	const TOptional<Vitruvio::FTextureData> CachedColorMap = Cache.Get(Path, TEXT("colorMap"));
+	const TOptional<Vitruvio::FTextureData> CachedRoughnessMap = Cache.Get(Path, TEXT("roughnessMap"));
+	TestTrue(TEXT("Color map is found by path and property"), CachedColorMap.IsSet() && CachedColorMap->Texture == ColorMap.Texture);
+	TestTrue(TEXT("Roughness map is found by path and property"),
+			 CachedRoughnessMap.IsSet() && CachedRoughnessMap->Texture == RoughnessMap.Texture);
+	TestFalse(TEXT("Other properties of the file are not cached"), Cache.Get(Path, TEXT("normalMap")).IsSet());
+
+	// Another file with identical pixels used for the same property shares the texture
+	const Vitruvio::FTextureData CopyColorMap = DecodeSyntheticTexture(Cache, CopyPath, TEXT("colorMap"), MaxResolution);
+	TestEqual(TEXT("Identical pixels share the texture"), CopyColorMap.Texture, ColorMap.Texture);
+
+	// A lower resolution cap results in its own texture, downsampled exactly to the cap
+	const int32 LowMaxResolution = TextureSize / 2;
+	const Vitruvio::FTextureData LowColorMap = DecodeSyntheticTexture(Cache, Path, TEXT("colorMap"), LowMaxResolution);
+	if (TestNotNull(TEXT("Capped color map decoded"), LowColorMap.Texture))
+	{
+		TestNotEqual(TEXT("Different caps have different textures"), LowColorMap.Texture, ColorMap.Texture);
+		TestEqual(TEXT("Capped width"), LowColorMap.Texture->GetSizeX(), LowMaxResolution);
+		TestEqual(TEXT("Capped height"), LowColorMap.Texture->GetSizeY(), LowMaxResolution);
+	}
+
+	const FTextureCacheStats Stats = Cache.GetStats();
+	TestEqual(TEXT("Cached textures"), Stats.NumTextures, 3);
+	TestEqual(TEXT("Deduplicated textures"), Stats.DeduplicatedTextures, static_cast<uint64>(1));
+
+	// Textures whose decoding started before the cache was emptied are not inserted anymore
+	const uint64 GenerationBeforeEmpty = Cache.GetGeneration();
+	Cache.Empty();
+	const Vitruvio::FTextureData LateColorMap = Cache.InsertOrGet(Path, TEXT("colorMap"), MaxResolution, GenerationBeforeEmpty, ColorMap);
+	TestEqual(TEXT("Late texture is still returned"), LateColorMap.Texture, ColorMap.Texture);
+	TestFalse(TEXT("Late texture is not cached"), Cache.Get(Path, TEXT("colorMap")).IsSet());
+	TestEqual(TEXT("Emptied cache has no textures"), Cache.GetStats().NumTextures, 0);
+	TestEqual(TEXT("Emptied cache has no pending loads"), Cache.GetStats().NumPendingLoads, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioTextureCacheEvictionTest, "Vitruvio.TextureCache.Eviction",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioTextureCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* BudgetVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("vitruvio.TextureCache.BudgetMB"));
+	if (!TestNotNull(TEXT("Texture cache budget variable"), BudgetVariable))
+	{
+		return false;
+	}
+	const int32 PreviousBudget = BudgetVariable->GetInt();
+	BudgetVariable->Set(1);
+
+	// Distinct textures are inserted until they exceed the budget of 1 MB, every one is smaller than half of it
+	FTextureCache Cache;
+	TArray<FString> Paths;
+	TArray<Vitruvio::FTextureData> Textures;
+	while (!Cache.IsOverBudget() && Textures.Num() < MaxEvictionTextures)
+	{
+		const FString Path = FString::Printf(TEXT("/Synthetic/Eviction%d.png"), Textures.Num());
+		const int32 MaxResolution = VitruvioModule::Get().GetMaxTextureResolution(Path);
+		Paths.Add(Path);
+		Textures.Add(DecodeSyntheticTexture(Cache, Path, TEXT("colorMap"), MaxResolution, EvictionTextureSize,
+											  static_cast<uint8>(Textures.Num())));
+	}
+
+	if (!TestTrue(TEXT("Textures exceed the budget"), Cache.IsOverBudget()) || !TestTrue(TEXT("Enough textures"), Textures.Num() >= 3))
+	{
+		BudgetVariable->Set(PreviousBudget);
+		return false;
+	}
+
+	// The oldest texture becomes the most recently used one, the second oldest is still referenced
+	TestTrue(TEXT("Oldest texture is cached"), Cache.Get(Paths[0], TEXT("colorMap")).IsSet());
+	const UTexture2D* ReferencedTexture = Textures[1].Texture;
+	Cache.EvictUnreferenced([ReferencedTexture](const UTexture2D* Texture) { return Texture == ReferencedTexture; });
+
+	const FTextureCacheStats Stats = Cache.GetStats();
+	AddInfo(FString::Printf(TEXT("%d textures inserted, %llu evicted, %llu KiB remaining"), Textures.Num(), Stats.Evictions,
+							static_cast<uint64>(Stats.SizeBytes / 1024)));
+	TestFalse(TEXT("The cache is within its budget after eviction"), Cache.IsOverBudget());
+	TestTrue(TEXT("Textures have been evicted"), Stats.Evictions > 0);
+	TestTrue(TEXT("The most recently used texture is kept"), Cache.Get(Paths[0], TEXT("colorMap")).IsSet());
+	TestTrue(TEXT("The referenced texture is kept"), Cache.Get(Paths[1], TEXT("colorMap")).IsSet());
+	TestFalse(TEXT("The least recently used texture is evicted"), Cache.Get(Paths[2], TEXT("colorMap")).IsSet());
+
+	Cache.Empty();
+	BudgetVariable->Set(PreviousBudget);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,119 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCompression.h"
+
+#include "Misc/AutomationTest.h"
+#include "RenderUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 TextureSize = 256;
+
+// Pixels are stored as B, G, R, A (PF_B8G8R8A8)
+constexpr int32 ChannelB = 0;
+constexpr int32 ChannelG = 1;
+constexpr int32 ChannelR = 2;
+constexpr int32 ChannelA = 3;
+
+// Smooth gradients in red and green, a low frequency pattern in blue and a radial falloff in alpha, like typical building textures
+TArray64<uint8> CreateSyntheticTexture()
+{
+	TArray64<uint8> Pixels;
+	Pixels.SetNumUninitialized(static_cast<int64>(TextureSize) * TextureSize * 4);
+	for (int32 Y = 0; Y < TextureSize; ++Y)
+	{
+		for (int32 X = 0; X < TextureSize; ++X)
+		{
+			uint8* Pixel = Pixels.GetData() + (static_cast<int64>(Y) * TextureSize + X) * 4;
+			const float Pattern = 0.5f + 0.5f * FMath::Sin(X * PI / 32.0f) * FMath::Cos(Y * PI / 32.0f);
+			const float Distance = FVector2f(X - TextureSize / 2, Y - TextureSize / 2).Size() / (TextureSize / 2);
+			Pixel[ChannelR] = static_cast<uint8>(X * 255 / (TextureSize - 1));
+			Pixel[ChannelG] = static_cast<uint8>(Y * 255 / (TextureSize - 1));
+			Pixel[ChannelB] = static_cast<uint8>(Pattern * 255.0f + 0.5f);
+			Pixel[ChannelA] = static_cast<uint8>(FMath::Clamp(1.0f - Distance, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+	return Pixels;
+}
+
+// Peak signal to noise ratio in dB over the given channels, infinite for identical images
+double ComputePSNR(const TArray64<uint8>& Expected, const TArray64<uint8>& Actual, TConstArrayView<int32> Channels)
+{
+	double SquaredError = 0.0;
+	for (int64 Pixel = 0; Pixel < Expected.Num() / 4; ++Pixel)
+	{
+		for (const int32 Channel : Channels)
+		{
+			const double Delta = static_cast<double>(Expected[Pixel * 4 + Channel]) - Actual[Pixel * 4 + Channel];
+			SquaredError += Delta * Delta;
+		}
+	}
+
+	const double MeanSquaredError = SquaredError / (Expected.Num() / 4 * Channels.Num());
+	return MeanSquaredError > 0.0 ? 10.0 * FMath::LogX(10.0, 255.0 * 255.0 / MeanSquaredError) : TNumericLimits<double>::Max();
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioTextureCompressionTest, "Vitruvio.TextureCompression",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioTextureCompressionTest::RunTest(const FString& Parameters)
+{
+	// Color roughness and metallic maps may pack other masks into green and blue, only grayscale ones are single channel
+	TestNotEqual(TEXT("Color roughness maps keep all channels"),
+				 Vitruvio::GetCompressedPixelFormat(TEXT("roughnessMap"), PF_B8G8R8A8, 3, TextureSize, TextureSize), PF_BC4);
+	TestNotEqual(TEXT("Color metallic maps keep all channels"),
+				 Vitruvio::GetCompressedPixelFormat(TEXT("metallicMap"), PF_B8G8R8A8, 4, TextureSize, TextureSize), PF_BC4);
+	if (GPixelFormats[PF_BC4].Supported)
+	{
+		TestEqual(TEXT("Grayscale roughness maps are BC4"),
+				  Vitruvio::GetCompressedPixelFormat(TEXT("roughnessMap"), PF_B8G8R8A8, 1, TextureSize, TextureSize), PF_BC4);
+	}
+
+	struct FFormatCase
+	{
+		EPixelFormat Format;
+		const TCHAR* Name;
+		TArray<int32> Channels;
+		double MinPSNR;
+	};
+	const FFormatCase Formats[] = {
+		{PF_DXT1, TEXT("BC1"), {ChannelR, ChannelG, ChannelB}, 30.0},
+		{PF_DXT5, TEXT("BC3"), {ChannelR, ChannelG, ChannelB, ChannelA}, 30.0},
+		{PF_BC4, TEXT("BC4"), {ChannelR}, 40.0},
+		{PF_BC5, TEXT("BC5"), {ChannelR, ChannelG}, 40.0},
+	};
+
+	const TArray64<uint8> Pixels = CreateSyntheticTexture();
+	for (const FFormatCase& Format : Formats)
+	{
+		const TArray64<uint8> Blocks = Vitruvio::CompressBlocks(Pixels.GetData(), TextureSize, TextureSize, Format.Format);
+		TestEqual(FString::Printf(TEXT("%s size"), Format.Name), Blocks.Num(),
+				  static_cast<int64>(CalculateImageBytes(TextureSize, TextureSize, 0, Format.Format)));
+
+		const TArray64<uint8> RoundTrip = Vitruvio::DecompressBlocks(Blocks.GetData(), TextureSize, TextureSize, Format.Format);
+		const double PSNR = ComputePSNR(Pixels, RoundTrip, Format.Channels);
+		AddInfo(FString::Printf(TEXT("%s round trip: %.2f dB PSNR"), Format.Name, PSNR));
+		TestTrue(FString::Printf(TEXT("%s round trip PSNR of %.2f dB is at least %.0f dB"), Format.Name, PSNR, Format.MinPSNR),
+				 PSNR >= Format.MinPSNR);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
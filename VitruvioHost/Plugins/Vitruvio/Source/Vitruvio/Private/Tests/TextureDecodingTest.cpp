@@ -0,0 +1,128 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Util/TextureDecoding.h"
+
+#include "Math/Float16Color.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+struct FFormatCase
+{
+	Vitruvio::EPRTPixelFormat PixelFormat;
+	const TCHAR* Name;
+	int32 Bands;
+	int32 BytesPerBand;
+};
+
+// The per pixel conversion DecodeTexture used before the row kernels were introduced
+void ConvertRowReference(const FFormatCase& Format, const uint8* Src, uint8* Dst, int32 Width)
+{
+	if (Format.PixelFormat == Vitruvio::EPRTPixelFormat::FLOAT32)
+	{
+		const float* FloatSrc = reinterpret_cast<const float*>(Src);
+		FFloat16Color* Float16Dst = reinterpret_cast<FFloat16Color*>(Dst);
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const FFloat16 Float16Value(FloatSrc[X]);
+			FFloat16Color Color;
+			Color.R = Float16Value;
+			Color.G = Float16Value;
+			Color.B = Float16Value;
+			Color.A = FFloat16(1.0f);
+			Float16Dst[X] = Color;
+		}
+		return;
+	}
+
+	const int32 BytesPerBand = Format.BytesPerBand;
+	const bool bIsColor = Format.Bands >= 3;
+	for (int32 X = 0; X < Width; ++X)
+	{
+		const int32 OldOffset = X * Format.Bands * BytesPerBand;
+		const int32 NewOffset = X * 4 * BytesPerBand;
+		for (int32 B = 0; B < BytesPerBand; ++B)
+		{
+			Dst[NewOffset + 0 * BytesPerBand + B] = bIsColor ? Src[OldOffset + 2 + B] : Src[OldOffset + B];
+			Dst[NewOffset + 1 * BytesPerBand + B] = bIsColor ? Src[OldOffset + 1 + B] : Src[OldOffset + B];
+			Dst[NewOffset + 2 * BytesPerBand + B] = bIsColor ? Src[OldOffset + 0 + B] : Src[OldOffset + B];
+			Dst[NewOffset + 3 * BytesPerBand + B] = (Format.Bands == 4) ? Src[OldOffset + 3 + B] : 0;
+		}
+	}
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioTextureDecodingTest, "Vitruvio.TextureDecoding",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioTextureDecodingTest::RunTest(const FString& Parameters)
+{
+	const FFormatCase Formats[] = {
+		{Vitruvio::EPRTPixelFormat::GREY8, TEXT("GREY8"), 1, 1},
+		{Vitruvio::EPRTPixelFormat::GREY16, TEXT("GREY16"), 1, 2},
+		{Vitruvio::EPRTPixelFormat::RGB8, TEXT("RGB8"), 3, 1},
+		{Vitruvio::EPRTPixelFormat::RGBA8, TEXT("RGBA8"), 4, 1},
+		{Vitruvio::EPRTPixelFormat::FLOAT32, TEXT("FLOAT32"), 1, 4},
+	};
+
+	// Widths below, at and around the vector widths of the kernels so both the vector loops and the scalar tails are covered
+	const int32 Widths[] = {1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 127, 1001};
+
+	FRandomStream Random(0x5EED);
+	for (const FFormatCase& Format : Formats)
+	{
+		const int32 DstBytesPerPixel = Format.PixelFormat == Vitruvio::EPRTPixelFormat::FLOAT32 ? sizeof(FFloat16Color) : 4 * Format.BytesPerBand;
+		for (const int32 Width : Widths)
+		{
+			// The source row is followed by the next row in a texture, it is exactly sized here to catch reads past its end
+			TArray<uint8> Src;
+			Src.SetNumUninitialized(Width * Format.Bands * Format.BytesPerBand);
+			if (Format.PixelFormat == Vitruvio::EPRTPixelFormat::FLOAT32)
+			{
+				float* FloatSrc = reinterpret_cast<float*>(Src.GetData());
+				for (int32 X = 0; X < Width; ++X)
+				{
+					FloatSrc[X] = Random.FRandRange(-2.0f, 2.0f);
+				}
+			}
+			else
+			{
+				for (uint8& Byte : Src)
+				{
+					Byte = static_cast<uint8>(Random.RandHelper(256));
+				}
+			}
+
+			TArray<uint8> Expected;
+			Expected.SetNumZeroed(Width * DstBytesPerPixel);
+			ConvertRowReference(Format, Src.GetData(), Expected.GetData(), Width);
+
+			TArray<uint8> Actual;
+			Actual.SetNumZeroed(Width * DstBytesPerPixel);
+			Vitruvio::ConvertTextureRow(Format.PixelFormat, Src.GetData(), Actual.GetData(), Width);
+
+			TestTrue(FString::Printf(TEXT("%s row of width %d matches the scalar conversion byte for byte"), Format.Name, Width),
+					 FMemory::Memcmp(Expected.GetData(), Actual.GetData(), Expected.Num()) == 0);
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
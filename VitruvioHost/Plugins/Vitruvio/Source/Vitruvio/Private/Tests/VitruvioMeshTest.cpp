@@ -0,0 +1,155 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PRTTypes.h"
+#include "VitruvioMesh.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/Material.h"
+#include "Misc/AutomationTest.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+constexpr int32 GridSize = 32;
+constexpr double BuildTimeoutSeconds = 30.0;
+
+// A flat GridSize x GridSize quad grid with a single material
+FMeshDescription CreateGrid()
+{
+	FMeshDescription Description;
+	FStaticMeshAttributes Attributes(Description);
+	Attributes.Register();
+
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	TArray<FVertexID> Vertices;
+	for (int32 Y = 0; Y <= GridSize; ++Y)
+	{
+		for (int32 X = 0; X <= GridSize; ++X)
+		{
+			const FVertexID VertexID = Description.CreateVertex();
+			VertexPositions[VertexID] = FVector3f(X * 100.0f, Y * 100.0f, 0.0f);
+			Vertices.Add(VertexID);
+		}
+	}
+
+	const FPolygonGroupID PolygonGroupID = Description.CreatePolygonGroup();
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const int32 Base = Y * (GridSize + 1) + X;
+			TArray<FVertexInstanceID> VertexInstances;
+			for (const int32 VertexIndex : {Base, Base + 1, Base + GridSize + 2, Base + GridSize + 1})
+			{
+				VertexInstances.Add(Description.CreateVertexInstance(Vertices[VertexIndex]));
+			}
+			Description.CreatePolygon(PolygonGroupID, VertexInstances);
+		}
+	}
+
+	FStaticMeshOperations::ComputeTriangleTangentsAndNormals(Description, THRESH_POINTS_ARE_SAME);
+	FStaticMeshOperations::ComputeTangentsAndNormals(Description, EComputeNTBsFlags::Normals | EComputeNTBsFlags::Tangents);
+	return Description;
+}
+
+TArray<Vitruvio::FMaterialAttributeContainer> CreateMaterials()
+{
+	const AttributeMapBuilderUPtr Builder(prt::AttributeMapBuilder::create());
+	Builder->setFloat(L"roughness", 0.8);
+	const AttributeMapUPtr AttributeMap(Builder->createAttributeMap());
+	return {Vitruvio::FMaterialAttributeContainer(AttributeMap.get())};
+}
+
+// Builds the mesh like applying a generate result does and waits until it could be assigned to components
+bool BuildMesh(FVitruvioMesh& Mesh, FMaterialCache& MaterialCache, FTextureCache& TextureCache, UWorld* World)
+{
+	UMaterial* Parent = UMaterial::GetDefaultMaterial(MD_Surface);
+	TMap<UMaterialInterface*, FString> MaterialIdentifiers;
+	TMap<FString, int32> UniqueMaterialNames;
+	Mesh.Build(TEXT("MemoryTestMesh"), MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialNames, Parent, Parent, Parent, World);
+
+	const double StartTime = FPlatformTime::Seconds();
+	while (!Mesh.FinishBuild())
+	{
+		if (FPlatformTime::Seconds() - StartTime > BuildTimeoutSeconds)
+		{
+			return false;
+		}
+
+		// Collision is cooked asynchronously and finished on the game thread
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::Sleep(0.01f);
+	}
+	return true;
+}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVitruvioMeshMemoryLeanTest, "Vitruvio.Mesh.MemoryLean",
+								 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVitruvioMeshMemoryLeanTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* MemoryLeanVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("vitruvio.MemoryLean"));
+	if (!TestNotNull(TEXT("Memory lean variable"), MemoryLeanVariable))
+	{
+		return false;
+	}
+	const bool bPreviousMemoryLean = MemoryLeanVariable->GetBool();
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Inactive, false);
+	FMaterialCache MaterialCache;
+	FTextureCache TextureCache;
+
+	const FMeshDescription Description = CreateGrid();
+	const TArray<Vitruvio::FMaterialAttributeContainer> Materials = CreateMaterials();
+
+	// The same mesh built with and without releasing its source data
+	MemoryLeanVariable->Set(false);
+	TSharedPtr<FVitruvioMesh> FullMesh = MakeShared<FVitruvioMesh>(TEXT("FullMesh"), Description, Materials);
+	const SIZE_T SizeBeforeBuild = FullMesh->GetSourceDataSize();
+	const bool bFullMeshBuilt = BuildMesh(*FullMesh, MaterialCache, TextureCache, World);
+	const SIZE_T FullSizeAfterBuild = FullMesh->GetSourceDataSize();
+
+	MemoryLeanVariable->Set(true);
+	TSharedPtr<FVitruvioMesh> LeanMesh = MakeShared<FVitruvioMesh>(TEXT("LeanMesh"), Description, Materials);
+	const bool bLeanMeshBuilt = BuildMesh(*LeanMesh, MaterialCache, TextureCache, World);
+	const SIZE_T LeanSizeAfterBuild = LeanMesh->GetSourceDataSize();
+
+	AddInfo(FString::Printf(TEXT("Source data of a %d x %d grid: %llu KiB before build, %llu KiB after build, %llu KiB after memory lean build"),
+							GridSize, GridSize, static_cast<uint64>(SizeBeforeBuild / 1024), static_cast<uint64>(FullSizeAfterBuild / 1024),
+							static_cast<uint64>(LeanSizeAfterBuild / 1024)));
+
+	TestTrue(TEXT("Mesh is built"), bFullMeshBuilt);
+	TestTrue(TEXT("Memory lean mesh is built"), bLeanMeshBuilt);
+	if (bFullMeshBuilt && bLeanMeshBuilt)
+	{
+		TestTrue(TEXT("Memory lean mesh uses less source data"), LeanSizeAfterBuild < FullSizeAfterBuild);
+		TestTrue(TEXT("Memory lean mesh keeps at most one source representation"), LeanSizeAfterBuild <= SizeBeforeBuild);
+	}
+
+	// The meshes reference the world through their collision, release them first
+	FullMesh.Reset();
+	LeanMesh.Reset();
+	World->DestroyWorld(false);
+	MemoryLeanVariable->Set(bPreviousMemoryLean);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
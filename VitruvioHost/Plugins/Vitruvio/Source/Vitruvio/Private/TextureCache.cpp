@@ -0,0 +1,422 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCache.h"
+
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "TextureResource.h"
+#include "UObject/Package.h"
+#include "VitruvioModule.h"
+
+namespace
+{
+TAutoConsoleVariable<int32> CVarTextureCacheBudgetMB(TEXT("vitruvio.TextureCache.BudgetMB"), 1024,
+													 TEXT("Memory budget of the decoded texture cache in MB. Textures which are still referenced are "
+														  "never evicted. 0 disables eviction."));
+
+TAutoConsoleVariable<float> CVarTextureCacheRevalidateInterval(TEXT("vitruvio.TextureCache.RevalidateInterval"), 1.0f,
+															   TEXT("Minimum time in seconds between checks for changed texture files."));
+
+TAutoConsoleVariable<bool> CVarTextureCachePrefetch(TEXT("vitruvio.TextureCache.Prefetch"), true,
+													TEXT("Whether textures start decoding as soon as generate emits the first material using them."));
+
+FAutoConsoleCommand TextureCacheStatsCommand(TEXT("vitruvio.TextureCache.Stats"), TEXT("Logs the statistics of the decoded texture cache."),
+											 FConsoleCommandDelegate::CreateLambda([]() {
+												 const FTextureCacheStats Stats = VitruvioModule::Get().GetTextureCache().GetStats();
+												 UE_LOG(LogUnrealPrt, Display,
+														TEXT("Texture cache: %d textures, %llu KiB, %llu hits, %llu misses, %llu evictions, %llu "
+															 "prefetches, %d pending loads, %llu deduplicated textures (%llu KiB saved)"),
+														Stats.NumTextures, static_cast<uint64>(Stats.SizeBytes / 1024), Stats.Hits, Stats.Misses,
+														Stats.Evictions, Stats.Prefetches, Stats.NumPendingLoads, Stats.DeduplicatedTextures,
+														static_cast<uint64>(Stats.SavedBytes / 1024));
+											 }));
+
+SIZE_T GetTextureSize(const UTexture2D* Texture)
+{
+	SIZE_T Size = 0;
+	if (const FTexturePlatformData* PlatformData = Texture ? Texture->GetPlatformData() : nullptr)
+	{
+		for (const FTexture2DMipMap& Mip : PlatformData->Mips)
+		{
+			Size += Mip.BulkData.GetBulkDataSize();
+		}
+	}
+	return Size;
+}
+
+SIZE_T GetBudgetBytes()
+{
+	return static_cast<SIZE_T>(FMath::Max(0, CVarTextureCacheBudgetMB.GetValueOnAnyThread())) * 1024 * 1024;
+}
+
+TSharedFuture<Vitruvio::FTextureData> MakeReadyFuture(const Vitruvio::FTextureData& TextureData)
+{
+	TPromise<Vitruvio::FTextureData> Promise;
+	Promise.SetValue(TextureData);
+	return Promise.GetFuture().Share();
+}
+
+class FLoadTextureTask
+{
+	TPromise<Vitruvio::FTextureData> Promise;
+	FTextureCache& Cache;
+
+	FString ImagePath;
+	FString TextureKey;
+	int32 MaxResolution;
+	uint64 Generation;
+
+public:
+	FLoadTextureTask(TPromise<Vitruvio::FTextureData>&& InPromise, FTextureCache& Cache, const FString& ImagePath, const FString& TextureKey,
+					 int32 MaxResolution, uint64 Generation)
+		: Promise(MoveTemp(InPromise)), Cache(Cache), ImagePath(ImagePath), TextureKey(TextureKey), MaxResolution(MaxResolution),
+		  Generation(Generation)
+	{
+	}
+
+	static const TCHAR* GetTaskName()
+	{
+		return TEXT("FLoadTextureTask");
+	}
+	FORCEINLINE static TStatId GetStatId()
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FLoadTextureTask, STATGROUP_TaskGraphTasks);
+	}
+
+	static ENamedThreads::Type GetDesiredThread()
+	{
+		return ENamedThreads::AnyBackgroundThreadNormalTask;
+	}
+
+	static ESubsequentsMode::Type GetSubsequentsMode()
+	{
+		return ESubsequentsMode::FireAndForget;
+	}
+
+	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_TextureCache_LoadTexture);
+		FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
+		const Vitruvio::FTextureData TextureData =
+			VitruvioModule::Get().DecodeTexture(GetTransientPackage(), ImagePath, TextureKey, MaxResolution);
+
+		Promise.SetValue(Cache.InsertOrGet(ImagePath, TextureKey, MaxResolution, Generation, TextureData));
+	}
+};
+} // namespace
+
+TOptional<Vitruvio::FTextureData> FTextureCache::Get(const FString& Path, const FString& Key)
+{
+	// The cap can change with the rule package or the console variable, textures decoded with a different one are not reused
+	const FPathKey PathKey {Path, Key, VitruvioModule::Get().GetMaxTextureResolution(Path)};
+
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	FEntry* Entry = FindEntry(PathKey);
+	if (!Entry)
+	{
+		++Misses;
+		return {};
+	}
+
+	++Hits;
+	Entry->LastUsed = ++UseCounter;
+	return Entry->TextureData;
+}
+
+TSharedFuture<Vitruvio::FTextureData> FTextureCache::Load(const FString& Path, const FString& Key)
+{
+	if (Path.IsEmpty())
+	{
+		return MakeReadyFuture({});
+	}
+
+	const FPathKey PathKey {Path, Key, VitruvioModule::Get().GetMaxTextureResolution(Path)};
+
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	if (FEntry* Entry = FindEntry(PathKey))
+	{
+		++Hits;
+		Entry->LastUsed = ++UseCounter;
+		return MakeReadyFuture(Entry->TextureData);
+	}
+
+	// A prefetched texture which is still being decoded counts as hit since its file is only read once
+	if (const TSharedFuture<Vitruvio::FTextureData>* PendingLoad = PendingLoads.Find(PathKey))
+	{
+		++Hits;
+		return *PendingLoad;
+	}
+
+	++Misses;
+	return StartLoad(PathKey);
+}
+
+TOptional<Vitruvio::FTextureData> FTextureCache::FindByContentHash(uint64 ContentHash)
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	FEntry* Entry = Entries.Find(ContentHash);
+	if (!Entry)
+	{
+		return {};
+	}
+
+	// Marked as used so it is not evicted before the file it was found for is inserted
+	Entry->LastUsed = ++UseCounter;
+	return Entry->TextureData;
+}
+
+void FTextureCache::Prefetch(const FString& Path, const FString& Key)
+{
+	if (Path.IsEmpty() || !CVarTextureCachePrefetch.GetValueOnAnyThread())
+	{
+		return;
+	}
+
+	const FPathKey PathKey {Path, Key, VitruvioModule::Get().GetMaxTextureResolution(Path)};
+
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	if (!FindEntry(PathKey) && !PendingLoads.Contains(PathKey))
+	{
+		++Prefetches;
+		StartLoad(PathKey);
+	}
+}
+
+Vitruvio::FTextureData FTextureCache::InsertOrGet(const FString& Path, const FString& Key, int32 MaxResolution, uint64 LoadGeneration,
+												 const Vitruvio::FTextureData& TextureData)
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	// Loads started before the cache was emptied neither own the pending load of their key anymore nor may they insert stale paths
+	if (LoadGeneration != Generation)
+	{
+		return TextureData;
+	}
+
+	// The texture is found in the cache from now on, no need to wait for its load anymore
+	const FPathKey PathKey {Path, Key, MaxResolution};
+	PendingLoads.Remove(PathKey);
+	if (!TextureData.Texture)
+	{
+		// Textures which could not be read are not cached, they are read again the next time they are requested
+		return TextureData;
+	}
+	const FPathEntry* PreviousPathEntry = Paths.Find(PathKey);
+	const bool bIsNewPath = !PreviousPathEntry || PreviousPathEntry->ContentHash != TextureData.ContentHash;
+	Paths.Add(PathKey, {TextureData.ContentHash, TextureData.LoadTime});
+
+	if (FEntry* Entry = Entries.Find(TextureData.ContentHash))
+	{
+		// Another file with identical content already uses this texture
+		if (bIsNewPath)
+		{
+			++DeduplicatedTextures;
+			SavedBytes += Entry->SizeBytes;
+		}
+
+		Entry->LastUsed = ++UseCounter;
+		return Entry->TextureData;
+	}
+
+	FEntry& Entry = Entries.Add(TextureData.ContentHash);
+	Entry.TextureData = TextureData;
+	Entry.Texture = TextureData.Texture;
+	Entry.SizeBytes = GetTextureSize(TextureData.Texture);
+	Entry.LastUsed = ++UseCounter;
+	SizeBytes += Entry.SizeBytes;
+
+	return TextureData;
+}
+
+void FTextureCache::Revalidate()
+{
+	TArray<TPair<FPathKey, FDateTime>> LoadTimes;
+	{
+		FScopeLock Lock(&TextureCacheCriticalSection);
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - LastRevalidateTime < CVarTextureCacheRevalidateInterval.GetValueOnAnyThread())
+		{
+			return;
+		}
+		LastRevalidateTime = Now;
+
+		// Files with identical content share an entry but each one is checked against its own load time
+		LoadTimes.Reserve(Paths.Num());
+		for (const auto& [PathKey, PathEntry] : Paths)
+		{
+			if (Entries.Contains(PathEntry.ContentHash))
+			{
+				LoadTimes.Emplace(PathKey, PathEntry.LoadTime);
+			}
+		}
+	}
+
+	// Query the file system without holding the lock
+	TArray<FPathKey> ChangedPaths;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for (const auto& [PathKey, LoadTime] : LoadTimes)
+	{
+		if (PlatformFile.GetTimeStamp(*PathKey.Path) > LoadTime)
+		{
+			ChangedPaths.Add(PathKey);
+		}
+	}
+
+	FScopeLock Lock(&TextureCacheCriticalSection);
+	for (const FPathKey& PathKey : ChangedPaths)
+	{
+		FPathEntry PathEntry;
+		if (Paths.RemoveAndCopyValue(PathKey, PathEntry))
+		{
+			RemoveEntry(PathEntry.ContentHash);
+		}
+	}
+}
+
+bool FTextureCache::IsOverBudget() const
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	const SIZE_T BudgetBytes = GetBudgetBytes();
+	return BudgetBytes > 0 && SizeBytes > BudgetBytes;
+}
+
+void FTextureCache::EvictUnreferenced(TFunctionRef<bool(const UTexture2D*)> IsReferenced)
+{
+	check(IsInGameThread());
+
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	const SIZE_T BudgetBytes = GetBudgetBytes();
+	if (BudgetBytes == 0 || SizeBytes <= BudgetBytes)
+	{
+		return;
+	}
+
+	TArray<TPair<uint64, uint64>> LeastRecentlyUsed;
+	LeastRecentlyUsed.Reserve(Entries.Num());
+	for (const auto& [ContentHash, Entry] : Entries)
+	{
+		LeastRecentlyUsed.Emplace(Entry.LastUsed, ContentHash);
+	}
+	LeastRecentlyUsed.Sort([](const TPair<uint64, uint64>& Lhs, const TPair<uint64, uint64>& Rhs) { return Lhs.Key < Rhs.Key; });
+
+	TSet<uint64> Evicted;
+	for (const auto& [LastUsed, ContentHash] : LeastRecentlyUsed)
+	{
+		if (SizeBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		if (!IsReferenced(Entries[ContentHash].Texture))
+		{
+			RemoveEntry(ContentHash);
+			Evicted.Add(ContentHash);
+			++Evictions;
+		}
+	}
+
+	for (auto It = Paths.CreateIterator(); It; ++It)
+	{
+		if (Evicted.Contains(It.Value().ContentHash))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	UE_LOG(LogUnrealPrt, Verbose, TEXT("Evicted %d textures from the texture cache, %llu KiB remaining"), Evicted.Num(),
+		   static_cast<uint64>(SizeBytes / 1024));
+}
+
+FTextureCacheStats FTextureCache::GetStats() const
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	FTextureCacheStats Stats;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	Stats.Prefetches = Prefetches;
+	Stats.DeduplicatedTextures = DeduplicatedTextures;
+	Stats.SavedBytes = SavedBytes;
+	Stats.NumTextures = Entries.Num();
+	Stats.NumPendingLoads = PendingLoads.Num();
+	Stats.SizeBytes = SizeBytes;
+	return Stats;
+}
+
+uint64 FTextureCache::GetGeneration() const
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+	return Generation;
+}
+
+void FTextureCache::Empty()
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	// Textures still being decoded are delivered to their waiters but not inserted anymore
+	++Generation;
+	Entries.Empty();
+	Paths.Empty();
+	PendingLoads.Empty();
+	SizeBytes = 0;
+}
+
+void FTextureCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	FScopeLock Lock(&TextureCacheCriticalSection);
+
+	for (auto& [ContentHash, Entry] : Entries)
+	{
+		Collector.AddReferencedObject(Entry.Texture);
+	}
+}
+
+FTextureCache::FEntry* FTextureCache::FindEntry(const FPathKey& PathKey)
+{
+	const FPathEntry* PathEntry = Paths.Find(PathKey);
+	return PathEntry ? Entries.Find(PathEntry->ContentHash) : nullptr;
+}
+
+TSharedFuture<Vitruvio::FTextureData> FTextureCache::StartLoad(const FPathKey& PathKey)
+{
+	// Registered before the task is dispatched, the task removes it again under the same lock once the texture is inserted
+	TPromise<Vitruvio::FTextureData> Promise;
+	TSharedFuture<Vitruvio::FTextureData> Future = Promise.GetFuture().Share();
+	PendingLoads.Add(PathKey, Future);
+
+	TGraphTask<FLoadTextureTask>::CreateTask().ConstructAndDispatchWhenReady(MoveTemp(Promise), *this, PathKey.Path, PathKey.Key,
+																			 PathKey.MaxResolution, Generation);
+	return Future;
+}
+
+void FTextureCache::RemoveEntry(uint64 ContentHash)
+{
+	FEntry Entry;
+	if (Entries.RemoveAndCopyValue(ContentHash, Entry))
+	{
+		SizeBytes -= Entry.SizeBytes;
+	}
+}
@@ -18,6 +18,7 @@
 #include "UnrealCallbacks.h"
 
 #include "Util/MaterialConversion.h"
+#include "Util/TextureAtlas.h"
 
 #include "Engine/StaticMesh.h"
 #include "IImageWrapper.h"
@@ -27,6 +28,8 @@
 #include "StaticMeshOperations.h"
 #include "Util/AsyncHelpers.h"
 #include "VitruvioModule.h"
+#include "Async/ParallelFor.h"
+#include "Hash/xxhash.h"
 #include "prtx/Mesh.h"
 
 DEFINE_LOG_CATEGORY(LogUnrealCallbacks);
@@ -54,15 +57,44 @@ constexpr float PRT_TO_UE_SCALE = 100.0f;
 // Note that we use the same tolerance (1e-25f) as in PRT to avoid numerical issues when converting planar geometry
 constexpr float PRT_DIVISOR_LIMIT = 1e-25f;
 
+FTransform ConvertTransform(const double* Transform)
+{
+	const FMatrix TransformationMat(GetColumn(Transform, 0), GetColumn(Transform, 1), GetColumn(Transform, 2), GetColumn(Transform, 3));
+	const int32 SignumDet = FMath::Sign(TransformationMat.Determinant());
+
+	// Create proper rotation matrix (remove scaling and translation and det == 1)
+	FMatrix RotationMat = TransformationMat.GetMatrixWithoutScale(PRT_DIVISOR_LIMIT).RemoveTranslation();
+	RotationMat = RotationMat * SignumDet;
+	RotationMat.M[3][3] = 1;
+
+	const FQuat Rotation =
+		Conjugate(RotationMat.ToQuat()); // Conjugate because we want the quaternion to describe a transformation to basis vectors of RotationMat
+	const FVector Scale = TransformationMat.GetScaleVector() * SignumDet;
+	const FVector Translation = TransformationMat.GetOrigin();
+
+	// Convert from right-handed y-up (CE) to left-handed z-up (Unreal) (see
+	// https://stackoverflow.com/questions/16099979/can-i-switch-x-y-z-in-a-quaternion)
+	const FQuat CERotation = FQuat(Rotation.X, Rotation.Z, Rotation.Y, Rotation.W);
+	const FVector CEScale = FVector(Scale.X, Scale.Z, Scale.Y);
+	const FVector CETranslation = FVector(Translation.X, Translation.Z, Translation.Y) * PRT_TO_UE_SCALE;
+
+	return FTransform(CERotation.GetNormalized(), CETranslation, CEScale);
+}
+
+// Unreal uv channel per PRT uv set (indexed by EPrtUvSetType), INDEX_NONE if the uv set is not used in Unreal
 // clang-format off
-const TMap<Vitruvio::EPrtUvSetType, Vitruvio::EUnrealUvSetType> PRTToUnrealUVSetMap = {
-	{Vitruvio::EPrtUvSetType::ColorMap,     Vitruvio::EUnrealUvSetType::ColorMap},
-	{Vitruvio::EPrtUvSetType::OpacityMap,   Vitruvio::EUnrealUvSetType::OpacityMap},
-	{Vitruvio::EPrtUvSetType::NormalMap,    Vitruvio::EUnrealUvSetType::NormalMap},
-	{Vitruvio::EPrtUvSetType::EmissiveMap,  Vitruvio::EUnrealUvSetType::EmissiveMap},
-	{Vitruvio::EPrtUvSetType::RoughnessMap, Vitruvio::EUnrealUvSetType::RoughnessMap},
-	{Vitruvio::EPrtUvSetType::MetallicMap,  Vitruvio::EUnrealUvSetType::MetallicMap},
-	{Vitruvio::EPrtUvSetType::DirtMap,      Vitruvio::EUnrealUvSetType::DirtMap}};
+constexpr int32 PRTToUnrealUVChannel[] = {
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::ColorMap),     // ColorMap
+	INDEX_NONE,                                                   // BumpMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::DirtMap),      // DirtMap
+	INDEX_NONE,                                                   // SpecularMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::OpacityMap),   // OpacityMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::NormalMap),    // NormalMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::EmissiveMap),  // EmissiveMap
+	INDEX_NONE,                                                   // OcclusionMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::RoughnessMap), // RoughnessMap
+	static_cast<int32>(Vitruvio::EUnrealUvSetType::MetallicMap)   // MetallicMap
+};
 
 const TMap<Vitruvio::EUnrealUvSetType, FString> UnrealUVSetToMaterialParamStringMap = {
 	{Vitruvio::EUnrealUvSetType::DirtMap,      TEXT("HasDirtMapUV")},
@@ -74,6 +106,11 @@ const TMap<Vitruvio::EUnrealUvSetType, FString> UnrealUVSetToMaterialParamString
 };
 // clang-format on
 
+int32 GetUnrealUVChannel(size_t PrtUvSet)
+{
+	return PrtUvSet < UE_ARRAY_COUNT(PRTToUnrealUVChannel) ? PRTToUnrealUVChannel[PrtUvSet] : INDEX_NONE;
+}
+
 TMap<FString, double> CreateAvailableUVSetMaterialParameterMap(uint32_t const* const* UVCounts, size_t UVSets)
 {
 	TMap<FString, double> AvailableUvSetAttributeMap;
@@ -81,156 +118,316 @@ TMap<FString, double> CreateAvailableUVSetMaterialParameterMap(uint32_t const* c
 	// Check which uv sets are available and set the corresponding information in the MaterialContainer
 	for (size_t PrtUvSet = 0; PrtUvSet < UVSets; ++PrtUvSet)
 	{
-		const Vitruvio::EUnrealUvSetType* UnrealUVSetPtr = PRTToUnrealUVSetMap.Find(static_cast<Vitruvio::EPrtUvSetType>(PrtUvSet));
-		bool bIsValidUnrealUVSet = (UnrealUVSetPtr != nullptr);
-
-		if (bIsValidUnrealUVSet)
+		const int32 UnrealUVChannel = GetUnrealUVChannel(PrtUvSet);
+		if (UnrealUVChannel == INDEX_NONE || UVCounts[PrtUvSet] == nullptr)
 		{
-			bool bHasUVSet = UVCounts[PrtUvSet] != nullptr;
-
-			const Vitruvio::EUnrealUvSetType UnrealUVSet = *UnrealUVSetPtr;
-			if (UnrealUVSet != Vitruvio::EUnrealUvSetType::ColorMap && UnrealUVSet != Vitruvio::EUnrealUvSetType::None)
-			{
-				const FString UVSetMaterialParamString(UnrealUVSetToMaterialParamStringMap.FindRef(UnrealUVSet));
+			continue;
+		}
 
-				if (bHasUVSet)
-				{
-					AvailableUvSetAttributeMap.Add(UVSetMaterialParamString, 1.0);
-				}
-			}
+		const Vitruvio::EUnrealUvSetType UnrealUVSet = static_cast<Vitruvio::EUnrealUvSetType>(UnrealUVChannel);
+		if (UnrealUVSet != Vitruvio::EUnrealUvSetType::ColorMap)
+		{
+			AvailableUvSetAttributeMap.Add(UnrealUVSetToMaterialParamStringMap.FindRef(UnrealUVSet), 1.0);
 		}
 	}
 	return AvailableUvSetAttributeMap;
 }
 
+// Starts decoding the textures of a material while the rest of the model is still being generated
+void PrefetchTextures(const Vitruvio::FMaterialAttributeContainer& Material)
+{
+	FTextureCache& TextureCache = VitruvioModule::Get().GetTextureCache();
+	for (const auto& [Key, Path] : Material.TextureProperties)
+	{
+		TextureCache.Prefetch(Path, Key);
+	}
+}
+
+// Start indices of a face range (faces with the same material) into the PRT index arrays and the created vertex instances
+struct FFaceRangeStart
+{
+	size_t Face = 0;
+	size_t VertexIndex = 0;
+	TArray<size_t, TInlineAllocator<10>> UVIndices;
+	size_t VertexInstance = 0;
+};
+
 FModelDescription ConvertMesh(const double* vtx, size_t vtxSize, const double* nrm, size_t nrmSize, const uint32_t* faceVertexCounts, size_t faceVertexCountsSize, const uint32_t* vertexIndices, size_t vertexIndicesSize, const uint32_t* normalIndices, size_t normalIndicesSize,
-	double const* const* uvs, uint32_t const* const* uvCounts, uint32_t const* const* uvIndices, size_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials)
+	double const* const* uvs, uint32_t const* const* uvCounts, uint32_t const* const* uvIndices, size_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials,
+	const Vitruvio::FCustomDataSettings& CustomDataSettings, bool bPrefetchTextures)
 {
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_UnrealCallbacks_ConvertMesh);
+
 	FModelDescription ModelDescription;
-    FStaticMeshAttributes Attributes(ModelDescription.MeshDescription);
+	FMeshDescription& MeshDescription = ModelDescription.MeshDescription;
+    FStaticMeshAttributes Attributes(MeshDescription);
     Attributes.Register();
 
     const auto VertexUVs = Attributes.GetVertexInstanceUVs();
     VertexUVs.SetNumChannels(8);
-    		
-	// Convert vertices and vertex instances
+
+	MeshDescription.ReserveNewVertices(vtxSize / 3);
+	MeshDescription.ReserveNewVertexInstances(vertexIndicesSize);
+	MeshDescription.ReserveNewPolygons(faceVertexCountsSize);
+	MeshDescription.ReserveNewPolygonGroups(faceRangesSize);
+
+	// Convert vertices
 	const auto VertexPositions = Attributes.GetVertexPositions();
 	for (size_t VertexIndex = 0; VertexIndex < vtxSize; VertexIndex += 3)
 	{
-		const FVertexID VertexID = ModelDescription.MeshDescription.CreateVertex();
+		const FVertexID VertexID = MeshDescription.CreateVertex();
 		VertexPositions[VertexID] = FVector3f(vtx[VertexIndex], vtx[VertexIndex + 2], vtx[VertexIndex + 1]) * PRT_TO_UE_SCALE;
 	}
-	
-	size_t BaseVertexIndex = 0;
-	TArray<size_t> BaseUVIndex;
-	BaseUVIndex.Init(0, uvSets);
 
-	size_t PolygonGroupStartIndex = 0;
-	
+	// The available uv sets are the same for all materials of this mesh
+	const TMap<FString, double> AvailableUvSetAttributeMap = CreateAvailableUVSetMaterialParameterMap(uvCounts, uvSets);
+
+	// Diffuse color and opacity can be moved to vertex colors so that more face ranges share their material
+	TArray<FVector4f> FaceRangeColors;
+	if (CustomDataSettings.UsesVertexColors())
+	{
+		FaceRangeColors.SetNum(faceRangesSize);
+	}
+
+	// Create the topology (not thread safe) and remember where each face range starts
+	TArray<FFaceRangeStart> FaceRangeStarts;
+	FaceRangeStarts.SetNum(faceRangesSize);
+
+	FFaceRangeStart Current;
+	Current.UVIndices.Init(0, uvSets);
+	TArray<FVertexInstanceID> PolygonVertexInstances;
 	for (size_t PolygonGroupIndex = 0; PolygonGroupIndex < faceRangesSize; ++PolygonGroupIndex)
 	{
+		FaceRangeStarts[PolygonGroupIndex] = Current;
 		const size_t PolygonFaceCount = faceRanges[PolygonGroupIndex];
 
-		Vitruvio::FMaterialAttributeContainer MaterialContainer(materials[PolygonGroupIndex]);
-		TMap<FString, double> AvailableUvSetAttributeMap = CreateAvailableUVSetMaterialParameterMap(uvCounts, uvSets);
-		for (auto& AvailableUvSetAttribute : AvailableUvSetAttributeMap)
+		Vitruvio::FMaterialAttributeContainer MaterialContainer(materials[PolygonGroupIndex], AvailableUvSetAttributeMap);
+		if (CustomDataSettings.UsesVertexColors())
 		{
-			MaterialContainer.ScalarProperties.Add(AvailableUvSetAttribute);
+			FaceRangeColors[PolygonGroupIndex] = FVector4f(Vitruvio::ExtractVertexColor(MaterialContainer, CustomDataSettings));
 		}
 
 		FPolygonGroupID PolygonGroupId;
-		if (ModelDescription.MaterialToPolygonMap.Contains(MaterialContainer))
+		if (const FPolygonGroupID* ExistingPolygonGroupId = ModelDescription.MaterialToPolygonMap.Find(MaterialContainer.Id))
 		{
-			PolygonGroupId = ModelDescription.MaterialToPolygonMap[MaterialContainer];
+			PolygonGroupId = *ExistingPolygonGroupId;
 		}
 		else
 		{
+			if (bPrefetchTextures)
+			{
+				PrefetchTextures(MaterialContainer);
+			}
 			ModelDescription.Materials.Add(MaterialContainer);
-			PolygonGroupId = ModelDescription.MeshDescription.CreatePolygonGroup();
-			ModelDescription.MaterialToPolygonMap.Add(MaterialContainer, PolygonGroupId);
+			PolygonGroupId = MeshDescription.CreatePolygonGroup();
+			ModelDescription.MaterialToPolygonMap.Add(MaterialContainer.Id, PolygonGroupId);
 		}
 
-		// Create Geometry
-		const auto Normals = Attributes.GetVertexInstanceNormals();
-		int PolygonFaces = 0;
+		size_t PolygonFaces = 0;
 		for (size_t FaceIndex = 0; FaceIndex < PolygonFaceCount; ++FaceIndex)
 		{
-			check(PolygonGroupStartIndex + FaceIndex < faceVertexCountsSize);
+			check(Current.Face + FaceIndex < faceVertexCountsSize);
+
+			const size_t FaceVertexCount = faceVertexCounts[Current.Face + FaceIndex];
+			if (FaceVertexCount < 3)
+			{
+				continue;
+			}
 
-			const size_t FaceVertexCount = faceVertexCounts[PolygonGroupStartIndex + FaceIndex];
-			TArray<FVertexInstanceID> PolygonVertexInstances;
+			PolygonVertexInstances.Reset(FaceVertexCount);
+			for (size_t FaceVertexIndex = 0; FaceVertexIndex < FaceVertexCount; ++FaceVertexIndex)
+			{
+				check(Current.VertexIndex + FaceVertexIndex < vertexIndicesSize);
+
+				const uint32_t VertexIndex = vertexIndices[Current.VertexIndex + FaceVertexIndex];
+				PolygonVertexInstances.Add(MeshDescription.CreateVertexInstance(FVertexID(VertexIndex + ModelDescription.VertexIndexOffset)));
+			}
 
-			if (FaceVertexCount >= 3)
+			MeshDescription.CreatePolygon(PolygonGroupId, PolygonVertexInstances);
+			PolygonFaces++;
+			Current.VertexIndex += FaceVertexCount;
+			Current.VertexInstance += FaceVertexCount;
+			for (size_t PrtUVSet = 0; PrtUVSet < uvSets; ++PrtUVSet)
 			{
-				for (size_t FaceVertexIndex = 0; FaceVertexIndex < FaceVertexCount; ++FaceVertexIndex)
+				if (uvCounts[PrtUVSet] != nullptr)
 				{
-					check(BaseVertexIndex + FaceVertexIndex < vertexIndicesSize);
-					check(BaseVertexIndex + FaceVertexIndex < normalIndicesSize);
+					Current.UVIndices[PrtUVSet] += uvCounts[PrtUVSet][Current.Face + FaceIndex];
+				}
+			}
+		}
 
-					const uint32_t VertexIndex = vertexIndices[BaseVertexIndex + FaceVertexIndex];
-					const uint32_t NormalIndex = normalIndices[BaseVertexIndex + FaceVertexIndex] * 3;
-					FVertexInstanceID InstanceId = ModelDescription.MeshDescription.CreateVertexInstance(FVertexID(VertexIndex + ModelDescription.VertexIndexOffset));
-					PolygonVertexInstances.Add(InstanceId);
+		Current.Face += PolygonFaces;
+	}
 
-					check(NormalIndex + 2 < nrmSize);
-					Normals[InstanceId] = FVector3f(nrm[NormalIndex], nrm[NormalIndex + 2], nrm[NormalIndex + 1]);
+	// Vertex instances were created in order, so each face range can fill its normals and uvs independently
+	const auto Normals = Attributes.GetVertexInstanceNormals();
+	const auto Colors = Attributes.GetVertexInstanceColors();
+	ParallelFor(static_cast<int32>(faceRangesSize), [&](int32 PolygonGroupIndex)
+	{
+		const FFaceRangeStart& Start = FaceRangeStarts[PolygonGroupIndex];
+		const size_t PolygonFaceCount = faceRanges[PolygonGroupIndex];
 
-					for (size_t PrtUVSet = 0; PrtUVSet < uvSets; ++PrtUVSet)
-					{
-						const Vitruvio::EUnrealUvSetType* UnrealUVSetPtr = PRTToUnrealUVSetMap.Find(static_cast<Vitruvio::EPrtUvSetType>(PrtUVSet));
-
-						bool bIsValidUnrealUvSet = (UnrealUVSetPtr != nullptr);
-						bool bFaceHasUvs = uvCounts[PrtUVSet] != nullptr && uvCounts[PrtUVSet][PolygonGroupStartIndex + FaceIndex] > 0;
-
-						if (bIsValidUnrealUvSet && bFaceHasUvs)
-						{
-							check(uvCounts[PrtUVSet][PolygonGroupStartIndex + FaceIndex] == FaceVertexCount);
-							const uint32_t UVIndex = uvIndices[PrtUVSet][BaseUVIndex[PrtUVSet] + FaceVertexIndex] * 2;
-							FVector2f UVCoords = FVector2f(uvs[PrtUVSet][UVIndex], -uvs[PrtUVSet][UVIndex + 1]);
-							VertexUVs.Set(InstanceId, static_cast<int32>(*UnrealUVSetPtr), UVCoords);
-						}
-					}
+		size_t BaseVertexIndex = Start.VertexIndex;
+		TArray<size_t, TInlineAllocator<10>> BaseUVIndex = Start.UVIndices;
+		size_t VertexInstance = Start.VertexInstance;
+
+		for (size_t FaceIndex = 0; FaceIndex < PolygonFaceCount; ++FaceIndex)
+		{
+			const size_t Face = Start.Face + FaceIndex;
+			const size_t FaceVertexCount = faceVertexCounts[Face];
+			if (FaceVertexCount < 3)
+			{
+				continue;
+			}
+
+			for (size_t FaceVertexIndex = 0; FaceVertexIndex < FaceVertexCount; ++FaceVertexIndex)
+			{
+				check(BaseVertexIndex + FaceVertexIndex < normalIndicesSize);
+
+				const FVertexInstanceID InstanceId(static_cast<int32>(VertexInstance + FaceVertexIndex));
+				const uint32_t NormalIndex = normalIndices[BaseVertexIndex + FaceVertexIndex] * 3;
+				check(NormalIndex + 2 < nrmSize);
+				Normals[InstanceId] = FVector3f(nrm[NormalIndex], nrm[NormalIndex + 2], nrm[NormalIndex + 1]);
+
+				if (!FaceRangeColors.IsEmpty())
+				{
+					Colors[InstanceId] = FaceRangeColors[PolygonGroupIndex];
 				}
+			}
 
-				ModelDescription.MeshDescription.CreatePolygon(PolygonGroupId, PolygonVertexInstances);
-				PolygonFaces++;
-				BaseVertexIndex += FaceVertexCount;
-				for (size_t PrtUVSet = 0; PrtUVSet < uvSets; ++PrtUVSet)
+			for (size_t PrtUVSet = 0; PrtUVSet < uvSets; ++PrtUVSet)
+			{
+				if (uvCounts[PrtUVSet] == nullptr)
 				{
-					if (uvCounts[PrtUVSet] != nullptr)
+					continue;
+				}
+
+				const uint32_t FaceUVCount = uvCounts[PrtUVSet][Face];
+				const int32 UnrealUVChannel = GetUnrealUVChannel(PrtUVSet);
+				if (UnrealUVChannel != INDEX_NONE && FaceUVCount > 0)
+				{
+					check(FaceUVCount == FaceVertexCount);
+					for (size_t FaceVertexIndex = 0; FaceVertexIndex < FaceVertexCount; ++FaceVertexIndex)
 					{
-						BaseUVIndex[PrtUVSet] += uvCounts[PrtUVSet][PolygonGroupStartIndex + FaceIndex];
+						const uint32_t UVIndex = uvIndices[PrtUVSet][BaseUVIndex[PrtUVSet] + FaceVertexIndex] * 2;
+						const FVector2f UVCoords(uvs[PrtUVSet][UVIndex], -uvs[PrtUVSet][UVIndex + 1]);
+						VertexUVs.Set(FVertexInstanceID(static_cast<int32>(VertexInstance + FaceVertexIndex)), UnrealUVChannel, UVCoords);
 					}
 				}
+				BaseUVIndex[PrtUVSet] += FaceUVCount;
 			}
-		}
 
-		PolygonGroupStartIndex += PolygonFaces;
-	}
+			BaseVertexIndex += FaceVertexCount;
+			VertexInstance += FaceVertexCount;
+		}
+	});
 
 	ModelDescription.VertexIndexOffset += vtxSize / 3;
 
 	return ModelDescription;
 }
 
+bool UsesNormalMaps(const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
+{
+	return Materials.ContainsByPredicate(
+		[](const Vitruvio::FMaterialAttributeContainer& Material) { return Material.TextureProperties.Contains(TEXT("normalMap")); });
+}
+
+uint64 ComputeContentHash(const FMeshDescription& Description, const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_UnrealCallbacks_ComputeContentHash);
+
+	FXxHash64Builder Builder;
+	const auto UpdateArray = [&Builder](const auto& Array) { Builder.Update(Array.GetData(), Array.Num() * sizeof(Array[0])); };
+
+	FStaticMeshConstAttributes Attributes(Description);
+	UpdateArray(Attributes.GetVertexPositions().GetRawArray());
+	UpdateArray(Attributes.GetVertexInstanceNormals().GetRawArray());
+	UpdateArray(Attributes.GetVertexInstanceColors().GetRawArray());
+
+	const auto VertexInstanceUVs = Attributes.GetVertexInstanceUVs();
+	for (int32 UVChannel = 0; UVChannel < VertexInstanceUVs.GetNumChannels(); ++UVChannel)
+	{
+		UpdateArray(VertexInstanceUVs.GetRawArray(UVChannel));
+	}
+
+	for (const FVertexInstanceID VertexInstanceID : Description.VertexInstances().GetElementIDs())
+	{
+		const int32 VertexIndex = Description.GetVertexInstanceVertex(VertexInstanceID).GetValue();
+		Builder.Update(&VertexIndex, sizeof(VertexIndex));
+	}
+
+	for (const FTriangleID TriangleID : Description.Triangles().GetElementIDs())
+	{
+		const TArrayView<const FVertexInstanceID> TriangleVertexInstances = Description.GetTriangleVertexInstances(TriangleID);
+		UpdateArray(TriangleVertexInstances);
+
+		const int32 PolygonGroupIndex = Description.GetTrianglePolygonGroup(TriangleID).GetValue();
+		Builder.Update(&PolygonGroupIndex, sizeof(PolygonGroupIndex));
+	}
+
+	for (const Vitruvio::FMaterialAttributeContainer& Material : Materials)
+	{
+		Builder.Update(&Material.Id, sizeof(Material.Id));
+	}
+
+	return Builder.Finalize().Hash;
+}
+
+FModelKey CreateModelKey(const FMeshDescription& Description, const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
+{
+	FModelKey Key;
+	Key.ContentHash = ComputeContentHash(Description, Materials);
+	Key.NumVertexInstances = Description.VertexInstances().Num();
+	Key.NumTriangles = Description.Triangles().Num();
+
+	Key.MaterialIds.Reserve(Materials.Num());
+	for (const Vitruvio::FMaterialAttributeContainer& Material : Materials)
+	{
+		Key.MaterialIds.Add(Material.Id);
+	}
+
+	// The vertex count is compared along with the positions
+	const FStaticMeshConstAttributes Attributes(Description);
+	Key.VertexPositions.Append(Attributes.GetVertexPositions().GetRawArray());
+	return Key;
+}
+
 TSharedPtr<FVitruvioMesh> CreateVitruvioMesh(const FString& Identifier, FMeshDescription Description, TArray<Vitruvio::FMaterialAttributeContainer> ModelMaterials)
 {
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_UnrealCallbacks_CreateVitruvioMesh);
+
 	bool bHasInvalidNormals;
 	bool bHasInvalidTangents;
 
 	FStaticMeshOperations::HasInvalidVertexInstanceNormalsOrTangents(Description, bHasInvalidNormals, bHasInvalidTangents);
 
+	// MikkTSpace tangents are only needed for normal mapping, otherwise the much cheaper averaged triangle tangents are sufficient
+	const bool bUseMikkTSpace = UsesNormalMaps(ModelMaterials);
+
 	// If normals are invalid, compute normals and tangents at polygon level then vertex level
 	if (bHasInvalidNormals)
 	{
 		FStaticMeshOperations::ComputeTriangleTangentsAndNormals(Description, THRESH_POINTS_ARE_SAME);
 
-		const EComputeNTBsFlags ComputeFlags = EComputeNTBsFlags::Normals | EComputeNTBsFlags::Tangents | EComputeNTBsFlags::UseMikkTSpace;
+		EComputeNTBsFlags ComputeFlags = EComputeNTBsFlags::Normals | EComputeNTBsFlags::Tangents;
+		if (bUseMikkTSpace)
+		{
+			ComputeFlags |= EComputeNTBsFlags::UseMikkTSpace;
+		}
 		FStaticMeshOperations::ComputeTangentsAndNormals(Description, ComputeFlags);
 	}
 	else if (bHasInvalidTangents)
 	{
-		FStaticMeshOperations::ComputeMikktTangents(Description, true);
+		if (bUseMikkTSpace)
+		{
+			FStaticMeshOperations::ComputeMikktTangents(Description, true);
+		}
+		else
+		{
+			FStaticMeshOperations::ComputeTriangleTangentsAndNormals(Description, THRESH_POINTS_ARE_SAME);
+			FStaticMeshOperations::ComputeTangentsAndNormals(Description, EComputeNTBsFlags::Tangents);
+		}
 	}
 
 	return MakeShared<FVitruvioMesh>(Identifier, Description, ModelMaterials);
@@ -301,8 +498,10 @@ void UnrealCallbacks::addMesh(const wchar_t* name, const wchar_t* meshId, int32_
 {
 	if (prototypeId == NoPrototypeIndex)
 	{
+		// Textures packed into atlases are prefetched as atlas pages once the atlases are built in finish
 		ModelDescription = ConvertMesh(vtx, vtxSize, nrm, nrmSize, faceVertexCounts, faceVertexCountsSize, vertexIndices, vertexIndicesSize,
-			normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials);
+			normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials, CustomDataSettings,
+			!Vitruvio::IsTextureAtlasingEnabled());
 	}
 	else
 	{
@@ -317,7 +516,8 @@ void UnrealCallbacks::addMesh(const wchar_t* name, const wchar_t* meshId, int32_
 		}
 		
 		FModelDescription InstanceModelDescription = ConvertMesh(vtx, vtxSize, nrm, nrmSize, faceVertexCounts, faceVertexCountsSize,
-			vertexIndices, vertexIndicesSize, normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials);
+			vertexIndices, vertexIndicesSize, normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials,
+			CustomDataSettings, true);
 
 		if (!InstanceModelDescription.MeshDescription.IsEmpty())
 		{
@@ -336,7 +536,28 @@ void UnrealCallbacks::finish()
 {
 	if (!ModelDescription.MeshDescription.IsEmpty())
 	{
-		GeneratedModel = CreateVitruvioMesh(TEXT("GeneratedMesh"), ModelDescription.MeshDescription, ModelDescription.Materials);
+		TArray<Vitruvio::FTextureAtlasPagePtr> AtlasPages;
+		if (Vitruvio::IsTextureAtlasingEnabled())
+		{
+			Vitruvio::BuildTextureAtlases(ModelDescription.MeshDescription, ModelDescription.Materials, AtlasPages);
+
+			for (const Vitruvio::FMaterialAttributeContainer& Material : ModelDescription.Materials)
+			{
+				PrefetchTextures(Material);
+			}
+		}
+
+		// Identical generated models share the same mesh as long as it is referenced anywhere
+		FMeshCache& MeshCache = VitruvioModule::Get().GetMeshCache();
+		const FModelKey ModelKey = CreateModelKey(ModelDescription.MeshDescription, ModelDescription.Materials);
+
+		GeneratedModel = MeshCache.GetModel(ModelKey);
+		if (!GeneratedModel)
+		{
+			TSharedPtr<FVitruvioMesh> Mesh = CreateVitruvioMesh(TEXT("GeneratedMesh"), ModelDescription.MeshDescription, ModelDescription.Materials);
+			Mesh->SetTextureAtlasPages(MoveTemp(AtlasPages));
+			GeneratedModel = MeshCache.InsertOrGetModel(ModelKey, Mesh);
+		}
 	}
 }
 
@@ -351,47 +572,147 @@ void UnrealCallbacks::addReport(const prt::AttributeMap* reports)
 	Reports = ExtractReports(reports);
 }
 
-void UnrealCallbacks::addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterials,
-                                  size_t numInstanceMaterials)
+bool UnrealCallbacks::isCachedPrototype(const wchar_t* meshId)
 {
-	const FMatrix TransformationMat(GetColumn(transform, 0), GetColumn(transform, 1), GetColumn(transform, 2), GetColumn(transform, 3));
-	const int32 SignumDet = FMath::Sign(TransformationMat.Determinant());
+	if (!FindCachedPrototype)
+	{
+		return false;
+	}
 
-	// Create proper rotation matrix (remove scaling and translation and det == 1)
-	FMatrix RotationMat = TransformationMat.GetMatrixWithoutScale(PRT_DIVISOR_LIMIT).RemoveTranslation();
-	RotationMat = RotationMat * SignumDet;
-	RotationMat.M[3][3] = 1;
+	// Keep the mesh alive until the instances are added, it might be evicted from the mesh cache in the meantime
+	TSharedPtr<FVitruvioMesh> CachedPrototype = FindCachedPrototype(meshId);
+	if (!CachedPrototype)
+	{
+		return false;
+	}
 
-	const FQuat Rotation =
-		Conjugate(RotationMat.ToQuat()); // Conjugate because we want the quaternion to describe a transformation to basis vectors of RotationMat
-	const FVector Scale = TransformationMat.GetScaleVector() * SignumDet;
-	const FVector Translation = TransformationMat.GetOrigin();
+	CachedPrototypes.Add(meshId, MoveTemp(CachedPrototype));
+	return true;
+}
 
-	// Convert from right-handed y-up (CE) to left-handed z-up (Unreal) (see
-	// https://stackoverflow.com/questions/16099979/can-i-switch-x-y-z-in-a-quaternion)
-	const FQuat CERotation = FQuat(Rotation.X, Rotation.Z, Rotation.Y, Rotation.W);
-	const FVector CEScale = FVector(Scale.X, Scale.Z, Scale.Y);
-	const FVector CETranslation = FVector(Translation.X, Translation.Z, Translation.Y) * PRT_TO_UE_SCALE;
+bool UnrealCallbacks::ResolveInstanceMesh(const wchar_t* meshId, const wchar_t* name)
+{
+	if (InstanceMeshes.Contains(meshId))
+	{
+		return true;
+	}
 
-	if (!InstanceMeshes.Contains(meshId))
+	const TSharedPtr<FVitruvioMesh>* CachedPrototype = CachedPrototypes.Find(meshId);
+	if (!CachedPrototype)
 	{
 		UE_LOG(LogUnrealCallbacks, Warning, TEXT("No mesh found for meshId %s"), meshId);
-		return;
+		return false;
+	}
+
+	InstanceMeshes.Add(meshId, *CachedPrototype);
+	InstanceNames.Add(meshId, name);
+	return true;
+}
+
+TSharedRef<const Vitruvio::FMaterialAttributeContainer> UnrealCallbacks::InternMaterial(const Vitruvio::FMaterialAttributeContainer& Material)
+{
+	if (const TSharedRef<const Vitruvio::FMaterialAttributeContainer>* InternedMaterial = InternedMaterials.Find(Material.Id))
+	{
+		return *InternedMaterial;
+	}
+
+	PrefetchTextures(Material);
+	TSharedRef<const Vitruvio::FMaterialAttributeContainer> InternedMaterial = VitruvioModule::Get().GetMaterialInternTable().Intern(Material);
+	InternedMaterials.Add(Material.Id, InternedMaterial);
+	return InternedMaterial;
+}
+
+Vitruvio::FInstanceData& UnrealCallbacks::FindOrAddInstances(const wchar_t* meshId,
+															 TArray<Vitruvio::FMaterialAttributeContainer>& MaterialContainers, int32 NumInstances)
+{
+	// Instances which only differ in their custom data attributes share their materials and therefore their component
+	const TArray<float> CustomData =
+		CustomDataSettings.IsEnabled() ? Vitruvio::ExtractInstanceCustomData(MaterialContainers, CustomDataSettings) : TArray<float>();
+
+	TArray<Vitruvio::FMaterialId> MaterialOverrides;
+	MaterialOverrides.Reserve(MaterialContainers.Num());
+	for (const Vitruvio::FMaterialAttributeContainer& MaterialContainer : MaterialContainers)
+	{
+		MaterialOverrides.Add(MaterialContainer.Id);
+	}
+
+	// Only the first instances of every mesh and material combination intern their materials
+	Vitruvio::FInstanceData& InstanceData = Instances.FindOrAdd({meshId, MoveTemp(MaterialOverrides)});
+	if (InstanceData.MaterialOverrides.IsEmpty())
+	{
+		InstanceData.MaterialOverrides.Reserve(MaterialContainers.Num());
+		for (const Vitruvio::FMaterialAttributeContainer& MaterialContainer : MaterialContainers)
+		{
+			InstanceData.MaterialOverrides.Add(InternMaterial(MaterialContainer));
+		}
+	}
+
+	if (!CustomData.IsEmpty())
+	{
+		InstanceData.NumCustomDataFloats = CustomData.Num();
+		for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+		{
+			InstanceData.CustomData.Append(CustomData);
+		}
 	}
+	return InstanceData;
+}
 
-	const FTransform Transform(CERotation.GetNormalized(), CETranslation, CEScale);
+void UnrealCallbacks::addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterials,
+								  size_t numInstanceMaterials)
+{
+	// Encoder binaries which predate addInstances call this once per instance, so it does no more work per instance than necessary
+	if (!ResolveInstanceMesh(meshId, TEXT("")))
+	{
+		return;
+	}
 
-	TArray<Vitruvio::FMaterialAttributeContainer> MaterialOverrides;
+	TArray<Vitruvio::FMaterialAttributeContainer> MaterialContainers;
 	if (instanceMaterials)
 	{
+		MaterialContainers.Reserve(numInstanceMaterials);
 		for (size_t MatIndex = 0; MatIndex < numInstanceMaterials; ++MatIndex)
 		{
-			Vitruvio::FMaterialAttributeContainer MaterialContainer(instanceMaterials[MatIndex]);
-			MaterialOverrides.Add(MaterialContainer);
+			MaterialContainers.Emplace(instanceMaterials[MatIndex]);
 		}
 	}
 
-	Instances.FindOrAdd({meshId, MaterialOverrides}).Add(Transform);
+	FindOrAddInstances(meshId, MaterialContainers, 1).Transforms.Add(ConvertTransform(transform));
+}
+
+void UnrealCallbacks::addInstances(int32_t prototypeId, const wchar_t* meshId, const wchar_t* name, const double* transforms, size_t numInstances,
+								   const uint32_t* materialOverrideIndices, const prt::AttributeMap* const* materialOverrides,
+								   size_t numMaterialOverrides, size_t numInstanceMaterials)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_UnrealCallbacks_AddInstances);
+
+	if (!ResolveInstanceMesh(meshId, name))
+	{
+		return;
+	}
+
+	// Collect the transforms per distinct material override set and only look up the instance map once per set
+	TArray<TArray<FTransform>> TransformsByOverride;
+	TransformsByOverride.SetNum(numMaterialOverrides);
+	for (size_t InstanceIndex = 0; InstanceIndex < numInstances; ++InstanceIndex)
+	{
+		const uint32_t OverrideIndex = materialOverrideIndices[InstanceIndex];
+		check(OverrideIndex < numMaterialOverrides);
+		TransformsByOverride[OverrideIndex].Add(ConvertTransform(transforms + InstanceIndex * 16));
+	}
+
+	for (size_t OverrideIndex = 0; OverrideIndex < numMaterialOverrides; ++OverrideIndex)
+	{
+		TArray<Vitruvio::FMaterialAttributeContainer> MaterialContainers;
+		MaterialContainers.Reserve(numInstanceMaterials);
+		for (size_t MatIndex = 0; MatIndex < numInstanceMaterials; ++MatIndex)
+		{
+			MaterialContainers.Emplace(materialOverrides[OverrideIndex * numInstanceMaterials + MatIndex]);
+		}
+
+		TArray<FTransform>& OverrideTransforms = TransformsByOverride[OverrideIndex];
+		FindOrAddInstances(meshId, MaterialContainers, OverrideTransforms.Num()).Transforms.Append(MoveTemp(OverrideTransforms));
+	}
 }
 
 prt::Status UnrealCallbacks::attrBool(size_t isIndex, int32_t shapeID, const wchar_t* key, bool value)
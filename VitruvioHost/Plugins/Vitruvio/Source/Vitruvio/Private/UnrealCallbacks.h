@@ -19,12 +19,14 @@
 
 #include "Codec/Encoder/IUnrealCallbacks.h"
 #include "Report.h"
+#include "VitruvioModule.h"
 #include "VitruvioTypes.h"
 
 #include "Engine/StaticMesh.h"
 #include "MeshDescription.h"
 #include "StaticMeshAttributes.h"
 #include "Modules/ModuleManager.h"
+#include "Util/MaterialConversion.h"
 #include "VitruvioMesh.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealCallbacks, Log, All);
@@ -34,13 +36,23 @@ struct FModelDescription
 	FMeshDescription MeshDescription;
 	size_t VertexIndexOffset = 0;
 	TArray<Vitruvio::FMaterialAttributeContainer> Materials;
-	TMap<Vitruvio::FMaterialAttributeContainer, FPolygonGroupID> MaterialToPolygonMap;
+	TMap<Vitruvio::FMaterialId, FPolygonGroupID> MaterialToPolygonMap;
 };
 
 class UnrealCallbacks final : public IUnrealCallbacks
 {
 	TArray<AttributeMapBuilderUPtr>& AttributeMapBuilders;
 
+public:
+	using FCachedPrototypeLookup = TFunction<TSharedPtr<FVitruvioMesh>(const FString& MeshId)>;
+
+private:
+	// Looks up prototypes in the mesh cache when the encoder asks for them (see isCachedPrototype)
+	FCachedPrototypeLookup FindCachedPrototype;
+
+	// Prototypes from the mesh cache which are not sent by the encoder again, only the ones used by this generate call
+	TMap<FString, TSharedPtr<FVitruvioMesh>> CachedPrototypes;
+
 	Vitruvio::FInstanceMap Instances;
 	TMap<FString, TSharedPtr<FVitruvioMesh>> InstanceMeshes;
 	TMap<FString, FString> InstanceNames;
@@ -48,10 +60,29 @@ class UnrealCallbacks final : public IUnrealCallbacks
 	FModelDescription ModelDescription;
 	TSharedPtr<FVitruvioMesh> GeneratedModel;
 	TMap<FString, FReport> Reports;
-	
+
+	// Read once per generate instead of once per instance
+	Vitruvio::FCustomDataSettings CustomDataSettings;
+
+	// Instance materials interned so far, every distinct material is only interned and prefetched once per generate
+	TMap<Vitruvio::FMaterialId, TSharedRef<const Vitruvio::FMaterialAttributeContainer>> InternedMaterials;
+
+	// Returns whether the instanced mesh is known, either added by addMesh or one of the CachedPrototypes
+	bool ResolveInstanceMesh(const wchar_t* meshId, const wchar_t* name);
+
+	TSharedRef<const Vitruvio::FMaterialAttributeContainer> InternMaterial(const Vitruvio::FMaterialAttributeContainer& Material);
+
+	// Finds or adds the instance entry of the mesh with the given override materials and appends the custom data of NumInstances instances
+	Vitruvio::FInstanceData& FindOrAddInstances(const wchar_t* meshId, TArray<Vitruvio::FMaterialAttributeContainer>& MaterialContainers,
+												int32 NumInstances);
+
 public:
 	virtual ~UnrealCallbacks() override = default;
-	UnrealCallbacks(TArray<AttributeMapBuilderUPtr>& AttributeMapBuilders) : AttributeMapBuilders(AttributeMapBuilders) {}
+	UnrealCallbacks(TArray<AttributeMapBuilderUPtr>& AttributeMapBuilders, FCachedPrototypeLookup FindCachedPrototype = {})
+		: AttributeMapBuilders(AttributeMapBuilders), FindCachedPrototype(MoveTemp(FindCachedPrototype)),
+		  CustomDataSettings(Vitruvio::GetCustomDataSettings())
+	{
+	}
 
 	static constexpr int32 NoPrototypeIndex = -1;
 
@@ -65,6 +96,11 @@ public:
 		return InstanceMeshes;
 	}
 
+	const FModelDescription& GetModelDescription() const
+	{
+		return ModelDescription;
+	}
+
 	const TSharedPtr<FVitruvioMesh>& GetGeneratedModel() const
 	{
 		return GeneratedModel;
@@ -80,6 +116,20 @@ public:
 		return InstanceNames;
 	}
 
+	/**
+	 * \brief Moves the collected result out of this handler. Only call this once generate has finished.
+	 */
+	FGenerateResultDescription TakeGenerateResult()
+	{
+		FGenerateResultDescription Result;
+		Result.GeneratedModel = MoveTemp(GeneratedModel);
+		Result.Instances = MoveTemp(Instances);
+		Result.InstanceMeshes = MoveTemp(InstanceMeshes);
+		Result.InstanceNames = MoveTemp(InstanceNames);
+		Result.Reports = MoveTemp(Reports);
+		return Result;
+	}
+
 	/**
 	 * @param name either the name of the inserted asset or the shape name
 	 * @param identifier unique identifier of this mesh if originates from an inserted asset or empty otherwise
@@ -119,18 +169,46 @@ public:
 	// clang-format on
 
 	/**
-	 * Add a new instance with a given id, transform and optional set of overriding attributes for this instance
+	 * Add a single instance, only called by encoder binaries which predate @ref addInstances
 	 *
 	 * @param prototypeId the id of the prorotype. An @ref addMesh call with the specified prorotypeId will be called before
 	 *                    the call to addInstance
+	 * @param meshId unique identifier of this mesh
 	 * @param transform the transformation matrix of this instance
-	 * @param instanceMaterial override materials for this instance
+	 * @param instanceMaterials override materials for this instance
 	 * @param numInstanceMaterials number of instance material overrides. Is either 0 or is equal to the number
 	 *                             of materials of the original mesh (by prototypeId)
 	 */
-	virtual void addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterial,
+	virtual void addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterials,
 							 size_t numInstanceMaterials) override;
 
+	/**
+	 * Add all instances of a mesh with their transforms and optional sets of overriding materials
+	 *
+	 * @param prototypeId the id of the prorotype. An @ref addMesh call with the specified prorotypeId will be called before
+	 *                    the call to addInstances unless the prototype is one of the CachedPrototypes
+	 * @param meshId unique identifier of the instanced mesh
+	 * @param name either the name of the inserted asset or the shape name
+	 * @param transforms contiguous array of numInstances 4x4 transformation matrices
+	 * @param numInstances number of instances
+	 * @param materialOverrideIndices index into the material override table per instance
+	 * @param materialOverrides deduplicated material override table (numMaterialOverrides * numInstanceMaterials entries)
+	 * @param numMaterialOverrides number of distinct material override sets
+	 * @param numInstanceMaterials number of materials per override set. Is either 0 or is equal to the number
+	 *                             of materials of the original mesh (by prototypeId)
+	 */
+	virtual void addInstances(int32_t prototypeId, const wchar_t* meshId, const wchar_t* name, const double* transforms, size_t numInstances,
+							  const uint32_t* materialOverrideIndices, const prt::AttributeMap* const* materialOverrides,
+							  size_t numMaterialOverrides, size_t numInstanceMaterials) override;
+
+	/**
+	 * Asks whether the prototype with the given mesh id is in the mesh cache, in which case the encoder skips addMesh for it
+	 *
+	 * @param meshId unique identifier of the instanced mesh
+	 * @return true if the prototype is cached and has been kept for this generate call
+	 */
+	virtual bool isCachedPrototype(const wchar_t* meshId) override;
+
 	/**
 	 * Add a new report
 	 *
@@ -0,0 +1,163 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LODGeneration.h"
+
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAABBTree3.h"
+#include "DynamicMeshToMeshDescription.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "MeshSimplification.h"
+#include "ProjectionTargets.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+
+namespace
+{
+TAutoConsoleVariable<FString> CVarLODScreenSizes(TEXT("vitruvio.LOD.ScreenSizes"), TEXT(""),
+												 TEXT("Comma separated screen sizes of the generated LODs in descending order, eg \"0.5,0.2\". "
+													  "No LODs are generated if empty."));
+
+TAutoConsoleVariable<float> CVarLODTriangleRatio(TEXT("vitruvio.LOD.TriangleRatio"), 0.5f,
+												 TEXT("Fraction of triangles kept by each generated LOD relative to the previous one."));
+
+TAutoConsoleVariable<int32> CVarLODMinTriangles(TEXT("vitruvio.LOD.MinTriangles"), 64,
+												TEXT("Generated LODs are not simplified below this number of triangles."));
+
+TAutoConsoleVariable<float> CVarLODMaxGeometricError(TEXT("vitruvio.LOD.MaxGeometricError"), 5.0f,
+													 TEXT("Maximum distance in cm of the vertices of LOD1 from the original mesh, 0 for no bound. The bound of "
+														  "further LODs grows with their screen size relative to LOD1."));
+} // namespace
+
+namespace Vitruvio
+{
+
+float FLODSettings::GetMaxGeometricError(int32 LODIndex) const
+{
+	if (MaxGeometricError <= 0.0f || !ScreenSizes.IsValidIndex(LODIndex - 1))
+	{
+		return 0.0f;
+	}
+	return MaxGeometricError * ScreenSizes[0] / ScreenSizes[LODIndex - 1];
+}
+
+FLODSettings GetLODSettings()
+{
+	FLODSettings Settings;
+	Settings.TriangleRatio = FMath::Clamp(CVarLODTriangleRatio.GetValueOnAnyThread(), 0.0f, 1.0f);
+	Settings.MinTriangles = CVarLODMinTriangles.GetValueOnAnyThread();
+	Settings.MaxGeometricError = FMath::Max(CVarLODMaxGeometricError.GetValueOnAnyThread(), 0.0f);
+
+	TArray<FString> ScreenSizeStrings;
+	CVarLODScreenSizes.GetValueOnAnyThread().ParseIntoArray(ScreenSizeStrings, TEXT(","));
+
+	float PreviousScreenSize = 1.0f;
+	for (const FString& ScreenSizeString : ScreenSizeStrings)
+	{
+		const float ScreenSize = FCString::Atof(*ScreenSizeString.TrimStartAndEnd());
+		if (ScreenSize <= 0.0f || ScreenSize >= PreviousScreenSize || Settings.ScreenSizes.Num() == MAX_STATIC_MESH_LODS - 1)
+		{
+			break;
+		}
+
+		Settings.ScreenSizes.Add(ScreenSize);
+		PreviousScreenSize = ScreenSize;
+	}
+
+	return Settings;
+}
+
+TArray<FMeshDescription> GenerateLODs(const FMeshDescription& MeshDescription, const FLODSettings& Settings)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_LODGeneration_GenerateLODs);
+
+	TArray<FMeshDescription> LODs;
+	if (Settings.ScreenSizes.IsEmpty())
+	{
+		return LODs;
+	}
+
+	UE::Geometry::FDynamicMesh3 DynamicMesh;
+	FMeshDescriptionToDynamicMesh ToDynamicMesh;
+	ToDynamicMesh.Convert(&MeshDescription, DynamicMesh);
+
+	const FStaticMeshConstAttributes SourceAttributes(MeshDescription);
+	const auto SourceMaterialSlotNames = SourceAttributes.GetPolygonGroupMaterialSlotNames();
+
+	// The error of every LOD is measured against the source mesh and not the previous LOD, so errors do not add up
+	TUniquePtr<UE::Geometry::FDynamicMesh3> SourceMesh;
+	TUniquePtr<UE::Geometry::FDynamicMeshAABBTree3> SourceSpatial;
+	TUniquePtr<UE::Geometry::FMeshProjectionTarget> SourceProjectionTarget;
+	if (Settings.MaxGeometricError > 0.0f)
+	{
+		SourceMesh = MakeUnique<UE::Geometry::FDynamicMesh3>(DynamicMesh);
+		SourceSpatial = MakeUnique<UE::Geometry::FDynamicMeshAABBTree3>(SourceMesh.Get(), true);
+		SourceProjectionTarget = MakeUnique<UE::Geometry::FMeshProjectionTarget>(SourceMesh.Get(), SourceSpatial.Get());
+	}
+
+	for (int32 LODIndex = 0; LODIndex < Settings.ScreenSizes.Num(); ++LODIndex)
+	{
+		const int32 TriangleCount = DynamicMesh.TriangleCount();
+		const int32 TargetTriangleCount = FMath::FloorToInt32(TriangleCount * Settings.TriangleRatio);
+		if (TargetTriangleCount < Settings.MinTriangles)
+		{
+			break;
+		}
+
+		// Keep open borders (eg roof edges) in place, otherwise the silhouette of the model shrinks
+		UE::Geometry::FAttrMeshSimplification Simplifier(&DynamicMesh);
+		Simplifier.MeshBoundaryConstraint = UE::Geometry::EEdgeRefineFlags::NoFlip;
+
+		// Collapses which would move a vertex further than the bound from the source surface are rejected
+		if (SourceProjectionTarget)
+		{
+			Simplifier.SetProjectionTarget(SourceProjectionTarget.Get());
+			Simplifier.ProjectionMode = UE::Geometry::FAttrMeshSimplification::ETargetProjectionMode::NoProjection;
+			Simplifier.GeometricErrorConstraint = UE::Geometry::FAttrMeshSimplification::EGeometricErrorCriteria::PredictedPointToProjectionTarget;
+			Simplifier.GeometricErrorTolerance = Settings.GetMaxGeometricError(LODIndex + 1);
+		}
+
+		Simplifier.SimplifyToTriangleCount(TargetTriangleCount);
+
+		if (DynamicMesh.TriangleCount() >= TriangleCount)
+		{
+			break;
+		}
+
+		FMeshDescription& LODDescription = LODs.AddDefaulted_GetRef();
+		FStaticMeshAttributes LODAttributes(LODDescription);
+		LODAttributes.Register();
+
+		FDynamicMeshToMeshDescription ToMeshDescription;
+		ToMeshDescription.Convert(&DynamicMesh, LODDescription, false);
+
+		for (const FPolygonGroupID PolygonGroupID : LODDescription.PolygonGroups().GetElementIDs())
+		{
+			if (MeshDescription.IsPolygonGroupValid(PolygonGroupID))
+			{
+				LODAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupID] = SourceMaterialSlotNames[PolygonGroupID];
+			}
+		}
+
+		FStaticMeshOperations::ComputeTriangleTangentsAndNormals(LODDescription, THRESH_POINTS_ARE_SAME);
+		FStaticMeshOperations::ComputeTangentsAndNormals(LODDescription, EComputeNTBsFlags::Tangents);
+	}
+
+	return LODs;
+}
+
+} // namespace Vitruvio
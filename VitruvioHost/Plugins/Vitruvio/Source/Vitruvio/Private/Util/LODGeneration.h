@@ -0,0 +1,60 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "MeshDescription.h"
+
+namespace Vitruvio
+{
+
+struct FLODSettings
+{
+	/** Screen sizes of the simplified LODs (LOD1 and up) in descending order. No LODs are generated if empty. */
+	TArray<float> ScreenSizes;
+
+	/** Fraction of triangles kept by each LOD relative to the previous one. */
+	float TriangleRatio = 0.5f;
+
+	/** LODs are not simplified below this number of triangles. */
+	int32 MinTriangles = 0;
+
+	/**
+	 * Maximum distance in cm between the vertices of LOD1 and the surface of LOD0, 0 for no bound. The bound of further LODs grows with
+	 * their screen size relative to LOD1, so that the error stays about the same on screen.
+	 */
+	float MaxGeometricError = 0.0f;
+
+	/** Returns the geometric error bound of the given LOD (1 for LOD1) or 0 if unbounded. */
+	float GetMaxGeometricError(int32 LODIndex) const;
+};
+
+/**
+ * Returns the LOD settings configured by the vitruvio.LOD.* console variables.
+ */
+FLODSettings GetLODSettings();
+
+/**
+ * Generates simplified LODs for the given mesh using quadric error metric simplification. Each LOD is simplified from the previous one
+ * towards its triangle ratio, but only as far as its vertices stay within the geometric error bound of the LOD from the source mesh. LODs
+ * keep the material slots of the source mesh. Fewer LODs than configured are returned if the mesh cannot be simplified further.
+ *
+ * @param MeshDescription	the LOD0 mesh
+ * @param Settings			the LOD settings
+ * @return the mesh descriptions of LOD1 and up.
+ */
+TArray<FMeshDescription> GenerateLODs(const FMeshDescription& MeshDescription, const FLODSettings& Settings);
+
+} // namespace Vitruvio
@@ -23,93 +23,125 @@
 #include "VitruvioModule.h"
 #include "VitruvioTypes.h"
 #include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
 #include "UObject/Package.h"
 
+#include <atomic>
+
 DEFINE_LOG_CATEGORY(LogMaterialConversion);
 
 namespace
 {
 
-constexpr double BlackColorThreshold = 0.02;
-constexpr double WhiteColorThreshold = 1.0 - BlackColorThreshold;
 constexpr double OpacityThreshold = 0.98;
 
-const FString CityEngineDefaultShaderName("CityEngineShader");
-const FString CityEnginePBRShaderName("CityEnginePBRShader");
+// Opacity left in translucent materials whose opacity has been moved to custom data. It keeps them translucent and, being just below the
+// threshold, the custom data values stay within [0, 1] as required by vertex colors.
+constexpr double TranslucentCustomDataOpacity = OpacityThreshold - UE_DOUBLE_KINDA_SMALL_NUMBER;
 
-template <typename T, typename F>
-void CountOpacityMapPixels(const T* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels, F Accessor)
-{
-	BlackPixels = 0;
-	WhitePixels = 0;
+TAutoConsoleVariable<FString> CVarCustomDataAttributes(
+	TEXT("vitruvio.CustomData.Attributes"), TEXT(""),
+	TEXT("Comma separated material attributes (diffuseColor, opacity, metallic, roughness, emissiveColor) which are moved to per-instance "
+		 "custom data and vertex colors so that more instances and sections share their materials. Only takes effect together with the "
+		 "parent materials vitruvio.CustomData.OpaqueParent, MaskedParent and TranslucentParent. Empty disables custom data."));
 
-	const T* LastColor = SrcColors + (SizeX * SizeY);
-	while (SrcColors < LastColor)
-	{
-		const float Value = Accessor(SrcColors);
+// The default parent materials do not read custom data, materials whose attributes have been moved would render white with them
+TAutoConsoleVariable<FString> CVarCustomDataOpaqueParent(
+	TEXT("vitruvio.CustomData.OpaqueParent"), TEXT(""),
+	TEXT("Object path of the opaque parent material used with custom data (multiplies its parameters by PerInstanceCustomData and "
+		 "VertexColor). Replaces M_OpaqueParent while vitruvio.CustomData.Attributes is set."));
 
-		if (Value < BlackColorThreshold)
-		{
-			BlackPixels++;
-		}
-		else if (Value > WhiteColorThreshold)
-		{
-			WhitePixels++;
-		}
-		++SrcColors;
-	}
-}
+TAutoConsoleVariable<FString> CVarCustomDataMaskedParent(
+	TEXT("vitruvio.CustomData.MaskedParent"), TEXT(""),
+	TEXT("Object path of the masked parent material used with custom data. Replaces M_MaskedParent while vitruvio.CustomData.Attributes "
+		 "is set."));
 
-void CountOpacityMapPixels(const FColor* SrcColors, bool UseAlphaChannel, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [UseAlphaChannel](const FColor* Color) { return static_cast<float>(UseAlphaChannel ? Color->A : Color->R) / 0xFF; });
-}
+TAutoConsoleVariable<FString> CVarCustomDataTranslucentParent(
+	TEXT("vitruvio.CustomData.TranslucentParent"), TEXT(""),
+	TEXT("Object path of the translucent parent material used with custom data. Replaces M_TranslucentParent while "
+		 "vitruvio.CustomData.Attributes is set."));
 
-void CountOpacityMapPixels(const uint8* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint8* Color) { return static_cast<float>(*Color) / 0xFF; });
-}
+std::atomic<bool> bWarnedMissingCustomDataParents = false;
 
-void CountOpacityMapPixels(const uint16* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
+// Returns the custom data parent material for the blend mode, or nullptr if it is not configured or can not be loaded
+UMaterialInterface* LoadCustomDataParent(EBlendMode BlendMode)
 {
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint16* Color) { return static_cast<float>(*Color) / 0xFFFF; });
+	FString ParentPath;
+	switch (BlendMode)
+	{
+	case BLEND_Translucent:
+		ParentPath = CVarCustomDataTranslucentParent.GetValueOnGameThread();
+		break;
+	case BLEND_Masked:
+		ParentPath = CVarCustomDataMaskedParent.GetValueOnGameThread();
+		break;
+	default:
+		ParentPath = CVarCustomDataOpaqueParent.GetValueOnGameThread();
+		break;
+	}
+
+	UMaterialInterface* Parent = ParentPath.IsEmpty() ? nullptr : LoadObject<UMaterialInterface>(nullptr, *ParentPath);
+	if (!Parent && !ParentPath.IsEmpty())
+	{
+		UE_LOG(LogMaterialConversion, Error, TEXT("Could not load custom data parent material %s"), *ParentPath);
+	}
+	return Parent;
 }
 
-EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMapData, bool UseAlphaAsOpacity)
+// Moves a color property with the same value in all materials to the custom data and leaves white in the materials
+bool ExtractColor(TArrayView<Vitruvio::FMaterialAttributeContainer> Materials, const FString& Key, float* OutValues)
 {
-	const UTexture2D* OpacityMap = OpacityMapData.Texture;
-	const EPixelFormat PixelFormat = OpacityMap->GetPixelFormat();
-	check(PixelFormat == PF_B8G8R8A8 || PixelFormat == PF_A16B16G16R16 || PixelFormat == PF_FloatRGBA);
-
-	uint32 BlackPixels = 0;
-	uint32 WhitePixels = 0;
-
-	// Now count the black and white pixels of the appropriate opacity map channel to determine the opacity mode
-	const FTexturePlatformData* PlatformData = OpacityMap->GetPlatformData();
-	switch (PixelFormat)
+	const FLinearColor* Value = Materials.IsEmpty() ? nullptr : Materials[0].ColorProperties.Find(Key);
+	if (!Value || Materials.ContainsByPredicate([&Key, Value](const Vitruvio::FMaterialAttributeContainer& Material) {
+			const FLinearColor* MaterialValue = Material.ColorProperties.Find(Key);
+			return !MaterialValue || *MaterialValue != *Value;
+		}))
 	{
-	case PF_B8G8R8A8:
+		return false;
+	}
+
+	OutValues[0] = Value->R;
+	OutValues[1] = Value->G;
+	OutValues[2] = Value->B;
+	for (Vitruvio::FMaterialAttributeContainer& Material : Materials)
 	{
-		const FColor* ImageData = reinterpret_cast<const FColor*>(PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, UseAlphaAsOpacity, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
-		break;
+		Material.ColorProperties[Key] = FLinearColor::White;
 	}
-	case PF_A16B16G16R16:
+	return true;
+}
+
+// Moves a scalar property with the same value in all materials to the custom data and leaves a neutral value in the materials
+bool ExtractScalar(TArrayView<Vitruvio::FMaterialAttributeContainer> Materials, const FString& Key, float& OutValue)
+{
+	const double* Value = Materials.IsEmpty() ? nullptr : Materials[0].ScalarProperties.Find(Key);
+	if (!Value || Materials.ContainsByPredicate([&Key, Value](const Vitruvio::FMaterialAttributeContainer& Material) {
+			const double* MaterialValue = Material.ScalarProperties.Find(Key);
+			return !MaterialValue || *MaterialValue != *Value;
+		}))
 	{
-		const uint16* ImageData = reinterpret_cast<const uint16*>(PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
-		break;
+		return false;
 	}
-	default:
-		check(0)
+
+	// The opacity determines the blend mode, so translucent materials stay translucent and the custom data is scaled accordingly
+	const double Neutral = Key == TEXT("opacity") && *Value < OpacityThreshold ? TranslucentCustomDataOpacity : 1.0;
+	OutValue = static_cast<float>(FMath::Min(*Value / Neutral, 1.0));
+	for (Vitruvio::FMaterialAttributeContainer& Material : Materials)
+	{
+		Material.ScalarProperties[Key] = Neutral;
 	}
+	return true;
+}
 
-	OpacityMap->GetPlatformData()->Mips[0].BulkData.Unlock();
+const FString CityEngineDefaultShaderName("CityEngineShader");
+const FString CityEnginePBRShaderName("CityEnginePBRShader");
+
+EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMapData)
+{
+	// The black and white pixels of the opacity channel have been counted when the opacity map was decoded
+	const uint32 BlackPixels = OpacityMapData.OpacityBlackPixels;
+	const uint32 WhitePixels = OpacityMapData.OpacityWhitePixels;
 
-	const uint32 TotalPixels = OpacityMap->GetSizeX() * OpacityMap->GetSizeY();
+	const uint32 TotalPixels = OpacityMapData.Texture->GetSizeX() * OpacityMapData.Texture->GetSizeY();
 	if (WhitePixels >= TotalPixels * OpacityThreshold)
 	{
 		return BLEND_Opaque;
@@ -121,7 +153,7 @@ EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMa
 	return BLEND_Translucent;
 }
 
-EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double Opacity, EBlendMode BlendMode, bool UseAlphaAsOpacity)
+EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double Opacity, EBlendMode BlendMode)
 {
 	if (Opacity < OpacityThreshold)
 	{
@@ -136,7 +168,7 @@ EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double
 	{
 		// OpacityMap exists and opacitymap.mode is blend (which is the default value) so we need to check the content of the OpacityMap
 		// to really decide which material we need for Unreal
-		return ChooseBlendModeFromOpacityMap(OpacityMapData, UseAlphaAsOpacity);
+		return ChooseBlendModeFromOpacityMap(OpacityMapData);
 	}
 	else
 	{
@@ -170,137 +202,186 @@ UMaterialInterface* GetMaterialByBlendMode(EBlendMode Mode, UMaterialInterface*
 	}
 }
 
-class FLoadTextureTask
+struct FPendingTextureBindings
 {
-	TPromise<Vitruvio::FTextureData> Promise;
-	UObject* Outer;
-	TMap<FString, Vitruvio::FTextureData>& Cache;
-	FCriticalSection& CacheCriticalSection;
-
-	FString ImagePath;
-	FString TextureKey;
+	TWeakObjectPtr<UMaterialInstanceDynamic> MaterialInstance;
+	TArray<TPair<FName, TSharedFuture<Vitruvio::FTextureData>>> Textures;
 
-public:
-	FLoadTextureTask(TPromise<Vitruvio::FTextureData>&& InPromise, UObject* Outer, TMap<FString, Vitruvio::FTextureData>& Cache,
-					 FCriticalSection& CacheCriticalSection, const FString& ImagePath, const FString& TextureKey)
-		: Promise(MoveTemp(InPromise)), Outer(Outer), Cache(Cache), CacheCriticalSection(CacheCriticalSection), ImagePath(ImagePath),
-		  TextureKey(TextureKey)
+	// Binds the decoded textures (or all textures if bWait is set) and returns whether there are textures left to bind
+	bool Bind(bool bWait)
 	{
+		UMaterialInstanceDynamic* Material = MaterialInstance.Get();
+		for (int32 TextureIndex = Textures.Num() - 1; TextureIndex >= 0; --TextureIndex)
+		{
+			if (!bWait && !Textures[TextureIndex].Value.IsReady())
+			{
+				continue;
+			}
+
+			const Vitruvio::FTextureData TextureData = Textures[TextureIndex].Value.Get();
+			if (Material)
+			{
+				Material->SetTextureParameterValue(Textures[TextureIndex].Key, TextureData.Texture);
+			}
+			Textures.RemoveAtSwap(TextureIndex);
+		}
+		return Material && !Textures.IsEmpty();
 	}
 
-	static const TCHAR* GetTaskName()
+	void ForEachDecodedTexture(TFunctionRef<void(UTexture2D*)> Function) const
 	{
-		return TEXT("FLoadTextureTask");
+		for (const TPair<FName, TSharedFuture<Vitruvio::FTextureData>>& Texture : Textures)
+		{
+			if (Texture.Value.IsReady() && Texture.Value.Get().Texture)
+			{
+				Function(Texture.Value.Get().Texture);
+			}
+		}
 	}
-	FORCEINLINE static TStatId GetStatId()
+};
+
+// Materials whose textures are still being decoded, only accessed on the game thread
+TArray<TSharedRef<FPendingTextureBindings>> PendingTextureBindings;
+
+} // namespace
+
+namespace Vitruvio
+{
+void FlushPendingTextureBindings()
+{
+	check(IsInGameThread());
+
+	for (const TSharedRef<FPendingTextureBindings>& Bindings : PendingTextureBindings)
 	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(FLoadResolveMapTask, STATGROUP_TaskGraphTasks);
+		Bindings->Bind(true);
 	}
+	PendingTextureBindings.Empty();
+}
 
-	static ENamedThreads::Type GetDesiredThread()
+void ForEachPendingTexture(TFunctionRef<void(UTexture2D*)> Function)
+{
+	for (const TSharedRef<FPendingTextureBindings>& Bindings : PendingTextureBindings)
 	{
-		return ENamedThreads::AnyBackgroundThreadNormalTask;
+		Bindings->ForEachDecodedTexture(Function);
 	}
+}
+
+FCustomDataSettings GetCustomDataSettings()
+{
+	TArray<FString> Attributes;
+	CVarCustomDataAttributes.GetValueOnAnyThread().ParseIntoArray(Attributes, TEXT(","));
 
-	static ESubsequentsMode::Type GetSubsequentsMode()
+	FCustomDataSettings Settings;
+	if (Attributes.IsEmpty())
 	{
-		return ESubsequentsMode::TrackSubsequents;
+		return Settings;
 	}
 
-	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	// Attributes are only moved if all parents can read them back, otherwise the materials would lose them
+	if (CVarCustomDataOpaqueParent.GetValueOnAnyThread().IsEmpty() || CVarCustomDataMaskedParent.GetValueOnAnyThread().IsEmpty() ||
+		CVarCustomDataTranslucentParent.GetValueOnAnyThread().IsEmpty())
 	{
-		QUICK_SCOPE_CYCLE_COUNTER(STAT_MaterialConversion_LoadTexture);
-		FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
-		Vitruvio::FTextureData TextureData = VitruvioModule::Get().DecodeTexture(Outer, ImagePath, TextureKey);
+		if (!bWarnedMissingCustomDataParents.exchange(true))
 		{
-			FScopeLock CacheLock(&CacheCriticalSection);
-
-			Cache.Add(ImagePath, TextureData);
+			UE_LOG(LogMaterialConversion, Warning,
+				   TEXT("vitruvio.CustomData.Attributes is ignored since the default parent materials do not read custom data. Set "
+						"vitruvio.CustomData.OpaqueParent, MaskedParent and TranslucentParent to parent materials which do."));
 		}
+		return Settings;
+	}
 
-		Promise.SetValue(TextureData);
+	for (const FString& Attribute : Attributes)
+	{
+		const FString TrimmedAttribute = Attribute.TrimStartAndEnd();
+		Settings.bDiffuseColor |= TrimmedAttribute == TEXT("diffuseColor");
+		Settings.bOpacity |= TrimmedAttribute == TEXT("opacity");
+		Settings.bMetallic |= TrimmedAttribute == TEXT("metallic");
+		Settings.bRoughness |= TrimmedAttribute == TEXT("roughness");
+		Settings.bEmissiveColor |= TrimmedAttribute == TEXT("emissiveColor");
 	}
-};
+	return Settings;
+}
 
-} // namespace
+TArray<float> ExtractInstanceCustomData(TArray<FMaterialAttributeContainer>& Materials, const FCustomDataSettings& Settings)
+{
+	TArray<float> CustomData;
+	CustomData.Init(1.0f, NumCustomDataFloats);
 
-namespace Vitruvio
+	bool bExtracted = false;
+	if (Settings.bDiffuseColor)
+	{
+		bExtracted |= ExtractColor(Materials, TEXT("diffuseColor"), &CustomData[CustomDataDiffuseColorIndex]);
+	}
+	if (Settings.bOpacity)
+	{
+		bExtracted |= ExtractScalar(Materials, TEXT("opacity"), CustomData[CustomDataOpacityIndex]);
+	}
+	if (Settings.bMetallic)
+	{
+		bExtracted |= ExtractScalar(Materials, TEXT("metallic"), CustomData[CustomDataMetallicIndex]);
+	}
+	if (Settings.bRoughness)
+	{
+		bExtracted |= ExtractScalar(Materials, TEXT("roughness"), CustomData[CustomDataRoughnessIndex]);
+	}
+	if (Settings.bEmissiveColor)
+	{
+		bExtracted |= ExtractColor(Materials, TEXT("emissiveColor"), &CustomData[CustomDataEmissiveColorIndex]);
+	}
+
+	if (bExtracted)
+	{
+		for (FMaterialAttributeContainer& Material : Materials)
+		{
+			Material.UpdateId();
+		}
+	}
+
+	return CustomData;
+}
+
+FLinearColor ExtractVertexColor(FMaterialAttributeContainer& Material, const FCustomDataSettings& Settings)
 {
+	float Values[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+	bool bExtracted = false;
+	if (Settings.bDiffuseColor)
+	{
+		bExtracted |= ExtractColor(MakeArrayView(&Material, 1), TEXT("diffuseColor"), Values);
+	}
+	if (Settings.bOpacity)
+	{
+		bExtracted |= ExtractScalar(MakeArrayView(&Material, 1), TEXT("opacity"), Values[3]);
+	}
+
+	if (bExtracted)
+	{
+		Material.UpdateId();
+	}
+
+	return FLinearColor(Values[0], Values[1], Values[2], Values[3]);
+}
+
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FString& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
 															const FMaterialAttributeContainer& MaterialContainer,
-															TMap<FString, FTextureData>& TextureCache)
+															FTextureCache& TextureCache)
 {
 	check(IsInGameThread());
 
-	TMap<FString, FGraphEventRef> TexturePropertyTasks;
-	TMap<FString, TFuture<FTextureData>> TextureProperties;
-
-	FCriticalSection CacheCriticalSection;
-
+	// Most textures have already been prefetched while generating (see UnrealCallbacks), the others start decoding now
+	TMap<FString, TSharedFuture<FTextureData>> TextureProperties;
 	for (const auto& TextureProperty : MaterialContainer.TextureProperties)
 	{
-		const FString TexturePath = TextureProperty.Value;
-		TPromise<FTextureData> Promise;
-		TFuture<FTextureData> Future = Promise.GetFuture();
-
-		bool ValidCache = false;
-		{
-			FScopeLock CacheLock(&CacheCriticalSection);
-
-			auto Cached = TextureCache.Find(TexturePath);
-			if (Cached)
-			{
-				auto FileSystemTimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*TexturePath);
-				if (FileSystemTimeStamp > Cached->LoadTime)
-				{
-					// If the timestamp on the filesystem is newer than our cached version we have to evict it from the cache and reload the texture
-					// because it has changed
-					TextureCache.Remove(*TextureCache.FindKey(*Cached));
-				}
-				else
-				{
-					// Found a valid entry in the cache which we can just use
-					Promise.SetValue(*Cached);
-					ValidCache = true;
-				}
-			}
-		}
-
-		if (!ValidCache)
-		{
-			// No valid entry found in the cache so we have to load it from the disk
-			auto LoadTextureTask = TexturePropertyTasks.Find(TexturePath);
-			if (LoadTextureTask)
-			{
-				FGraphEventArray Prerequisites;
-				Prerequisites.Add(*LoadTextureTask);
-				TGraphTask<TAsyncGraphTask<FTextureData>>::CreateTask(&Prerequisites)
-					.ConstructAndDispatchWhenReady(
-						[&TextureCache, TexturePath, &CacheCriticalSection]() {
-							FScopeLock CacheLock(&CacheCriticalSection);
-							return TextureCache[TexturePath];
-						},
-						MoveTemp(Promise), ENamedThreads::AnyThread);
-			}
-			else if (!TexturePath.IsEmpty())
-			{
-				FGraphEventRef LoadTask = TGraphTask<FLoadTextureTask>::CreateTask().ConstructAndDispatchWhenReady(
-					MoveTemp(Promise), Outer, TextureCache, CacheCriticalSection, TextureProperty.Value, TextureProperty.Key);
-				TexturePropertyTasks.Add(TexturePath, LoadTask);
-			}
-			else
-			{
-				Promise.SetValue({});
-			}
-		}
-
-		TextureProperties.Add(TextureProperty.Key, MoveTemp(Future));
+		// Textures of changed files have already been removed from the cache off the game thread (see FTextureCache::Revalidate)
+		TextureProperties.Add(TextureProperty.Key, TextureCache.Load(TextureProperty.Value, TextureProperty.Key));
 	}
+
+	// Only the opacity map is waited for since the blend mode depends on its content
 	const float Opacity = MaterialContainer.ScalarProperties["opacity"];
 	const FTextureData OpacityMapData = TextureProperties.Contains("opacityMap") ? TextureProperties["opacityMap"].Get() : FTextureData{};
 	const bool UseAlphaAsOpacity = OpacityMapData.Texture && OpacityMapData.NumChannels == 4;
-	const EBlendMode ChosenBlendMode = ChooseBlendMode(OpacityMapData, Opacity, GetBlendMode(MaterialContainer.BlendMode), UseAlphaAsOpacity);
+	const EBlendMode ChosenBlendMode = ChooseBlendMode(OpacityMapData, Opacity, GetBlendMode(MaterialContainer.BlendMode));
 
 	const FString Shader = MaterialContainer.StringProperties["shader"];
 
@@ -312,6 +393,10 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 		const FString ParentMaterialPath = Shader + TEXT(".") + FileName;
 		Parent = LoadObject<UMaterialInterface>(Outer, *ParentMaterialPath);
 	}
+	if (!Parent && GetCustomDataSettings().IsEnabled())
+	{
+		Parent = LoadCustomDataParent(ChosenBlendMode);
+	}
 	if (!Parent)
 	{
 		Parent = GetMaterialByBlendMode(ChosenBlendMode, OpaqueParent, MaskedParent, TranslucentParent);
@@ -325,11 +410,32 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 
 	MaterialInstance->SetScalarParameterValue(FName(TEXT("opacitySource")), UseAlphaAsOpacity);
 
-	for (const TPair<FString, TFuture<FTextureData>>& TextureFuture : TextureProperties)
+	// Textures which are still being decoded keep the default of the parent material as placeholder until they are bound by the apply
+	// scheduler within its frame budget
+	const TSharedRef<FPendingTextureBindings> Bindings = MakeShared<FPendingTextureBindings>();
+	Bindings->MaterialInstance = MaterialInstance;
+	for (const TPair<FString, TSharedFuture<FTextureData>>& TextureFuture : TextureProperties)
+	{
+		Bindings->Textures.Emplace(FName(TextureFuture.Key), TextureFuture.Value);
+	}
+
+	if (Bindings->Bind(false))
 	{
-		const auto Result = TextureFuture.Value.Get();
-		MaterialInstance->SetTextureParameterValue(FName(TextureFuture.Key), Result.Texture);
+		PendingTextureBindings.Add(Bindings);
+		// The job is dropped without running its step once the material is destroyed, its bindings must not pin their textures anymore
+		VitruvioModule::Get().GetApplyScheduler().Schedule(
+			MaterialInstance,
+			[Bindings]() {
+				if (Bindings->Bind(false))
+				{
+					return EApplyStepResult::Wait;
+				}
+				PendingTextureBindings.Remove(Bindings);
+				return EApplyStepResult::Done;
+			},
+			[Bindings]() { PendingTextureBindings.Remove(Bindings); });
 	}
+
 	for (const TPair<FString, double>& ScalarProperty : MaterialContainer.ScalarProperties)
 	{
 		MaterialInstance->SetScalarParameterValue(FName(ScalarProperty.Key), ScalarProperty.Value);
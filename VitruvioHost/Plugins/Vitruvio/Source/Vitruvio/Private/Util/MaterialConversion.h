@@ -15,14 +15,81 @@
 
 #pragma once
 
+#include "TextureCache.h"
 #include "VitruvioTypes.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogMaterialConversion, Log, All);
 
 namespace Vitruvio
 {
+/**
+ * Creates a material instance for the given material attributes. Textures which are not cached yet are decoded asynchronously and bound to
+ * the material instance once they are ready, the parent material's defaults are used until then. Only the opacity map is waited for.
+ */
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FString& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
 															const FMaterialAttributeContainer& MaterialAttributes,
-															TMap<FString, FTextureData>& TextureCache);
+															FTextureCache& TextureCache);
+
+/**
+ * Blocks until all textures still being decoded are bound to their material instances.
+ */
+void FlushPendingTextureBindings();
+
+/**
+ * Calls the given function for every decoded texture which is waiting to be bound to its material instance. Until they are bound these
+ * textures are only held by their pending bindings, which must keep them alive even if they are evicted from the texture cache. The
+ * bindings of destroyed material instances are removed once the apply scheduler drops their job. Called on the game thread or during
+ * garbage collection.
+ */
+void ForEachPendingTexture(TFunctionRef<void(UTexture2D*)> Function);
+
+/**
+ * Material attributes which are moved to the per-instance custom data of instances and to the vertex colors of meshes, so that materials
+ * which only differ in these attributes are shared. Parent materials multiply the material parameters by these values. Configured by
+ * vitruvio.CustomData.Attributes, which only takes effect if the parent materials reading custom data are configured as well (see
+ * vitruvio.CustomData.OpaqueParent), since the default parent materials do not.
+ */
+struct FCustomDataSettings
+{
+	bool bDiffuseColor = false;
+	bool bOpacity = false;
+	bool bMetallic = false;
+	bool bRoughness = false;
+	bool bEmissiveColor = false;
+
+	bool IsEnabled() const
+	{
+		return bDiffuseColor || bOpacity || bMetallic || bRoughness || bEmissiveColor;
+	}
+
+	/** Only the diffuse color (rgb) and opacity (alpha) are moved to vertex colors. */
+	bool UsesVertexColors() const
+	{
+		return bDiffuseColor || bOpacity;
+	}
+};
+
+/** Layout of the per-instance custom data, values of attributes which are not moved are 1. */
+constexpr int32 CustomDataDiffuseColorIndex = 0; // rgb
+constexpr int32 CustomDataOpacityIndex = 3;
+constexpr int32 CustomDataMetallicIndex = 4;
+constexpr int32 CustomDataRoughnessIndex = 5;
+constexpr int32 CustomDataEmissiveColorIndex = 6; // rgb
+constexpr int32 NumCustomDataFloats = 9;
+
+FCustomDataSettings GetCustomDataSettings();
+
+/**
+ * Moves the custom data attributes of the given materials (all materials of an instance) to the returned per-instance custom data. Since
+ * the custom data applies to all materials of an instance, an attribute is only moved if it has the same value in all of them. The ids of
+ * the materials are updated.
+ */
+TArray<float> ExtractInstanceCustomData(TArray<FMaterialAttributeContainer>& Materials, const FCustomDataSettings& Settings);
+
+/**
+ * Moves the diffuse color and opacity of the given material to the returned vertex color if they are custom data attributes, the id of
+ * the material is updated.
+ */
+FLinearColor ExtractVertexColor(FMaterialAttributeContainer& Material, const FCustomDataSettings& Settings);
 }
@@ -0,0 +1,550 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureAtlas.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/xxhash.h"
+#include "StaticMeshAttributes.h"
+#include "VitruvioModule.h"
+
+namespace
+{
+TAutoConsoleVariable<bool> CVarAtlasEnabled(TEXT("vitruvio.Atlas.Enabled"), false,
+											TEXT("Pack the textures of generated models into shared atlas pages and merge the materials which "
+												 "become identical."));
+
+TAutoConsoleVariable<int32> CVarAtlasPageSize(TEXT("vitruvio.Atlas.PageSize"), 2048,
+											  TEXT("Width and maximum height of the texture atlas pages in pixels."));
+
+TAutoConsoleVariable<int32> CVarAtlasMaxTextureSize(TEXT("vitruvio.Atlas.MaxTextureSize"), 512,
+													TEXT("Textures larger than this in either dimension are not packed into atlas pages."));
+
+// Edge pixels repeated around each packed texture so that filtering and the first mips do not bleed into the neighbouring textures
+constexpr int32 AtlasPadding = 4;
+
+const FString AtlasPagePrefix = TEXT("vitruvio-atlas://");
+
+struct FAtlasPlacement
+{
+	FString Path;
+
+	// Position of the texture (without padding) in pixels from the bottom left, like PRT images are stored
+	int32 X = 0;
+	int32 Y = 0;
+	int32 Width = 0;
+	int32 Height = 0;
+};
+
+} // namespace
+
+namespace Vitruvio
+{
+// Pages only store where their textures are placed and are assembled whenever they are decoded
+struct FTextureAtlasPage
+{
+	FTextureMetadata Metadata;
+	TArray<FAtlasPlacement> Placements;
+};
+} // namespace Vitruvio
+
+namespace
+{
+using FAtlasPage = Vitruvio::FTextureAtlasPage;
+
+// Pages stay registered as long as a generated mesh whose materials use them holds them, see FVitruvioMesh::SetTextureAtlasPages
+FCriticalSection AtlasPagesLock;
+TMap<FString, TWeakPtr<const FAtlasPage>> AtlasPages;
+Vitruvio::FTextureAtlasStats TotalStats;
+
+// Released pages are also removed whenever the map has grown to this size, so it stays bounded without explicit cleanups
+int32 RemoveReleasedPagesThreshold = 256;
+
+int32 RemoveReleasedPagesLocked()
+{
+	int32 NumRemoved = 0;
+	for (auto It = AtlasPages.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+			++NumRemoved;
+		}
+	}
+	return NumRemoved;
+}
+
+FAutoConsoleCommand AtlasStatsCommand(TEXT("vitruvio.Atlas.Stats"), TEXT("Logs the statistics of the texture atlases of all generated models."),
+									  FConsoleCommandDelegate::CreateLambda([]() {
+										  FScopeLock Lock(&AtlasPagesLock);
+										  RemoveReleasedPagesLocked();
+										  UE_LOG(LogUnrealPrt, Display,
+												 TEXT("Texture atlases: %d textures packed into %d pages, %d -> %d materials, %d -> %d sections, %d "
+													  "pages registered"),
+												 TotalStats.NumPackedTextures, TotalStats.NumPages, TotalStats.NumMaterialsBefore,
+												 TotalStats.NumMaterialsAfter, TotalStats.NumSectionsBefore, TotalStats.NumSectionsAfter,
+												 AtlasPages.Num());
+									  }));
+
+int32 GetUVChannel(const FString& Key)
+{
+	// clang-format off
+	static const TMap<FString, Vitruvio::EUnrealUvSetType> KeyToUvSet = {
+		{TEXT("colorMap"), Vitruvio::EUnrealUvSetType::ColorMap},
+		{TEXT("dirtMap"), Vitruvio::EUnrealUvSetType::DirtMap},
+		{TEXT("opacityMap"), Vitruvio::EUnrealUvSetType::OpacityMap},
+		{TEXT("normalMap"), Vitruvio::EUnrealUvSetType::NormalMap},
+		{TEXT("emissiveMap"), Vitruvio::EUnrealUvSetType::EmissiveMap},
+		{TEXT("roughnessMap"), Vitruvio::EUnrealUvSetType::RoughnessMap},
+		{TEXT("metallicMap"), Vitruvio::EUnrealUvSetType::MetallicMap},
+	};
+	// clang-format on
+
+	const Vitruvio::EUnrealUvSetType* UvSet = KeyToUvSet.Find(Key);
+	return UvSet ? static_cast<int32>(*UvSet) : INDEX_NONE;
+}
+
+int32 CountDistinctMaterials(const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
+{
+	TSet<Vitruvio::FMaterialId> MaterialIds;
+	for (const Vitruvio::FMaterialAttributeContainer& Material : Materials)
+	{
+		MaterialIds.Add(Material.Id);
+	}
+	return MaterialIds.Num();
+}
+
+// Returns the repetition of the texture all uvs of the polygon group lie in, or nothing if they span several repetitions
+TOptional<FVector2f> GetUVTile(const FMeshDescription& MeshDescription, const TVertexInstanceAttributesRef<FVector2f>& UVs,
+							   FPolygonGroupID PolygonGroupId, int32 UVChannel)
+{
+	constexpr float Tolerance = 1e-3f;
+
+	FBox2f Bounds(ForceInit);
+	for (const FPolygonID PolygonId : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+	{
+		for (const FVertexInstanceID VertexInstanceId : MeshDescription.GetPolygonVertexInstances(PolygonId))
+		{
+			Bounds += UVs.Get(VertexInstanceId, UVChannel);
+		}
+	}
+
+	if (!Bounds.bIsValid)
+	{
+		return {};
+	}
+
+	const FVector2f Tile(FMath::FloorToFloat(Bounds.Min.X + Tolerance), FMath::FloorToFloat(Bounds.Min.Y + Tolerance));
+	if (Bounds.Max.X > Tile.X + 1.0f + Tolerance || Bounds.Max.Y > Tile.Y + 1.0f + Tolerance)
+	{
+		return {};
+	}
+	return Tile;
+}
+
+void RemapUVs(const FMeshDescription& MeshDescription, const TVertexInstanceAttributesRef<FVector2f>& UVs, FPolygonGroupID PolygonGroupId,
+			  int32 UVChannel, const FVector2f& Tile, const FAtlasPlacement& Placement, const Vitruvio::FTextureMetadata& PageMetadata)
+{
+	const float PageWidth = static_cast<float>(PageMetadata.Width);
+	const float PageHeight = static_cast<float>(PageMetadata.Height);
+
+	// Unreal textures are stored top down, so the placement is flipped vertically
+	const float OffsetX = static_cast<float>(Placement.X);
+	const float OffsetY = PageHeight - static_cast<float>(Placement.Y + Placement.Height);
+
+	for (const FPolygonID PolygonId : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+	{
+		for (const FVertexInstanceID VertexInstanceId : MeshDescription.GetPolygonVertexInstances(PolygonId))
+		{
+			const FVector2f UV = UVs.Get(VertexInstanceId, UVChannel) - Tile;
+			UVs.Set(VertexInstanceId, UVChannel,
+					FVector2f((OffsetX + UV.X * Placement.Width) / PageWidth, (OffsetY + UV.Y * Placement.Height) / PageHeight));
+		}
+	}
+}
+
+// Packs the textures into shelves of pages, largest textures first
+TArray<FAtlasPage> PackTextures(const TArray<FString>& Paths, const TMap<FString, Vitruvio::FTextureMetadata>& Metadata, int32 PageSize)
+{
+	TArray<FString> SortedPaths = Paths;
+	SortedPaths.Sort([&Metadata](const FString& Lhs, const FString& Rhs) {
+		const Vitruvio::FTextureMetadata& LhsMetadata = Metadata[Lhs];
+		const Vitruvio::FTextureMetadata& RhsMetadata = Metadata[Rhs];
+		return LhsMetadata.Height != RhsMetadata.Height ? LhsMetadata.Height > RhsMetadata.Height : LhsMetadata.Width > RhsMetadata.Width;
+	});
+
+	TArray<FAtlasPage> Pages;
+	int32 ShelfX = 0;
+	int32 ShelfY = 0;
+	int32 ShelfHeight = 0;
+	for (const FString& Path : SortedPaths)
+	{
+		const Vitruvio::FTextureMetadata& TextureMetadata = Metadata[Path];
+		const int32 Width = static_cast<int32>(TextureMetadata.Width);
+		const int32 Height = static_cast<int32>(TextureMetadata.Height);
+		const int32 CellWidth = Width + 2 * AtlasPadding;
+		const int32 CellHeight = Height + 2 * AtlasPadding;
+
+		if (ShelfX + CellWidth > PageSize)
+		{
+			ShelfX = 0;
+			ShelfY += ShelfHeight;
+			ShelfHeight = 0;
+		}
+		if (Pages.IsEmpty() || ShelfY + CellHeight > PageSize)
+		{
+			FAtlasPage& Page = Pages.AddDefaulted_GetRef();
+			Page.Metadata = TextureMetadata;
+			Page.Metadata.Width = PageSize;
+			Page.Metadata.Height = 0;
+			ShelfX = 0;
+			ShelfY = 0;
+			ShelfHeight = 0;
+		}
+
+		FAtlasPage& Page = Pages.Last();
+		Page.Placements.Add({Path, ShelfX + AtlasPadding, ShelfY + AtlasPadding, Width, Height});
+		Page.Metadata.Height = FMath::Max<size_t>(Page.Metadata.Height, Align(ShelfY + CellHeight, 4));
+
+		ShelfX += CellWidth;
+		ShelfHeight = FMath::Max(ShelfHeight, CellHeight);
+	}
+
+	return Pages;
+}
+
+// Pages are named by their content (including the file times of their textures), so regenerating a model reuses its cached pages
+FString RegisterPage(const FString& Key, const FAtlasPage& Page, TArray<Vitruvio::FTextureAtlasPagePtr>& OutPages)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FXxHash64Builder Builder;
+	Builder.Update(&Page.Metadata.Width, sizeof(Page.Metadata.Width));
+	Builder.Update(&Page.Metadata.Height, sizeof(Page.Metadata.Height));
+	Builder.Update(&Page.Metadata.Bands, sizeof(Page.Metadata.Bands));
+	for (const FAtlasPlacement& Placement : Page.Placements)
+	{
+		const int64 FileTime = PlatformFile.GetTimeStamp(*Placement.Path).GetTicks();
+		Builder.Update(*Placement.Path, Placement.Path.Len() * sizeof(TCHAR));
+		Builder.Update(&Placement.X, sizeof(Placement.X));
+		Builder.Update(&Placement.Y, sizeof(Placement.Y));
+		Builder.Update(&FileTime, sizeof(FileTime));
+	}
+
+	const FString PagePath = FString::Printf(TEXT("%s%s/%016llx"), *AtlasPagePrefix, *Key, Builder.Finalize().Hash);
+
+	FScopeLock Lock(&AtlasPagesLock);
+	TWeakPtr<const FAtlasPage>& RegisteredPage = AtlasPages.FindOrAdd(PagePath);
+	Vitruvio::FTextureAtlasPagePtr PinnedPage = RegisteredPage.Pin();
+	if (!PinnedPage)
+	{
+		PinnedPage = MakeShared<const FAtlasPage>(Page);
+		RegisteredPage = PinnedPage;
+	}
+	OutPages.Add(MoveTemp(PinnedPage));
+
+	if (AtlasPages.Num() >= RemoveReleasedPagesThreshold)
+	{
+		RemoveReleasedPagesLocked();
+		RemoveReleasedPagesThreshold = FMath::Max(256, AtlasPages.Num() * 2);
+	}
+
+	return PagePath;
+}
+
+// Moves the polygons of polygon groups whose materials are identical into the first of them
+void MergeIdenticalMaterials(FMeshDescription& MeshDescription, TArray<Vitruvio::FMaterialAttributeContainer>& Materials,
+							 const TArray<FPolygonGroupID>& PolygonGroupIds)
+{
+	TMap<Vitruvio::FMaterialId, FPolygonGroupID> MaterialToPolygonGroup;
+	TArray<int32> MergedMaterialIndices;
+	for (int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+	{
+		const FPolygonGroupID PolygonGroupId = PolygonGroupIds[MaterialIndex];
+		const FPolygonGroupID* TargetPolygonGroupId = MaterialToPolygonGroup.Find(Materials[MaterialIndex].Id);
+		if (!TargetPolygonGroupId)
+		{
+			MaterialToPolygonGroup.Add(Materials[MaterialIndex].Id, PolygonGroupId);
+			continue;
+		}
+
+		const TArray<FPolygonID> PolygonIds(MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId));
+		for (const FPolygonID PolygonId : PolygonIds)
+		{
+			MeshDescription.SetPolygonPolygonGroup(PolygonId, *TargetPolygonGroupId);
+		}
+		MeshDescription.DeletePolygonGroup(PolygonGroupId);
+		MergedMaterialIndices.Add(MaterialIndex);
+	}
+
+	if (MergedMaterialIndices.IsEmpty())
+	{
+		return;
+	}
+
+	for (int32 Index = MergedMaterialIndices.Num() - 1; Index >= 0; --Index)
+	{
+		Materials.RemoveAt(MergedMaterialIndices[Index]);
+	}
+
+	// Compacting keeps the order of the remaining polygon groups, so they still match the order of the materials
+	FElementIDRemappings Remappings;
+	MeshDescription.Compact(Remappings);
+}
+} // namespace
+
+namespace Vitruvio
+{
+
+bool IsTextureAtlasingEnabled()
+{
+	return CVarAtlasEnabled.GetValueOnAnyThread();
+}
+
+FTextureAtlasStats BuildTextureAtlases(FMeshDescription& MeshDescription, TArray<FMaterialAttributeContainer>& Materials,
+									   TArray<FTextureAtlasPagePtr>& OutPages)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_TextureAtlas_BuildTextureAtlases);
+
+	FTextureAtlasStats Stats;
+	Stats.NumMaterialsBefore = CountDistinctMaterials(Materials);
+	Stats.NumSectionsBefore = MeshDescription.PolygonGroups().Num();
+
+	TArray<FPolygonGroupID> PolygonGroupIds;
+	for (const FPolygonGroupID PolygonGroupId : MeshDescription.PolygonGroups().GetElementIDs())
+	{
+		PolygonGroupIds.Add(PolygonGroupId);
+	}
+	check(PolygonGroupIds.Num() == Materials.Num());
+
+	FStaticMeshAttributes Attributes(MeshDescription);
+	const TVertexInstanceAttributesRef<FVector2f> UVs = Attributes.GetVertexInstanceUVs();
+
+	const int32 PageSize = FMath::Clamp(CVarAtlasPageSize.GetValueOnAnyThread(), 256, 8192) & ~3;
+	const size_t MaxTextureSize = FMath::Clamp(CVarAtlasMaxTextureSize.GetValueOnAnyThread(), 0, PageSize - 2 * AtlasPadding);
+
+	struct FCandidate
+	{
+		int32 MaterialIndex;
+		int32 UVChannel;
+		FVector2f Tile;
+	};
+
+	// Collect the materials which can be packed, grouped by map type and pixel format
+	TMap<FString, Vitruvio::FTextureMetadata> Metadata;
+	TMap<TPair<FString, size_t>, TArray<FCandidate>> Groups;
+	for (int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+	{
+		if (Materials[MaterialIndex].TextureProperties.Num() != 1)
+		{
+			continue;
+		}
+
+		const auto& [Key, Path] = *Materials[MaterialIndex].TextureProperties.CreateConstIterator();
+		const int32 UVChannel = GetUVChannel(Key);
+		if (Path.IsEmpty() || UVChannel == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const TOptional<FVector2f> Tile = GetUVTile(MeshDescription, UVs, PolygonGroupIds[MaterialIndex], UVChannel);
+		if (!Tile)
+		{
+			continue;
+		}
+
+		if (!Metadata.Contains(Path))
+		{
+			Metadata.Add(Path, VitruvioModule::Get().ReadTextureMetadata(Path));
+		}
+
+		// Only 8 bit textures are packed, their pixels are converted to the same format by the decoder
+		const Vitruvio::FTextureMetadata& TextureMetadata = Metadata[Path];
+		if (TextureMetadata.PixelFormat == EPRTPixelFormat::Unknown || TextureMetadata.BytesPerBand != 1 || TextureMetadata.Width == 0 ||
+			TextureMetadata.Height == 0 || TextureMetadata.Width > MaxTextureSize || TextureMetadata.Height > MaxTextureSize)
+		{
+			continue;
+		}
+
+		Groups.FindOrAdd({Key, TextureMetadata.Bands}).Add({MaterialIndex, UVChannel, *Tile});
+	}
+
+	for (const auto& [Group, Candidates] : Groups)
+	{
+		const FString& Key = Group.Key;
+
+		TArray<FString> Paths;
+		for (const FCandidate& Candidate : Candidates)
+		{
+			Paths.AddUnique(Materials[Candidate.MaterialIndex].TextureProperties[Key]);
+		}
+		if (Paths.Num() < 2)
+		{
+			continue;
+		}
+
+		TMap<FString, TPair<FString, int32>> PathToPlacement;
+		TMap<FString, FAtlasPage> PagesByPath;
+		for (FAtlasPage& Page : PackTextures(Paths, Metadata, PageSize))
+		{
+			// A page with a single texture does not save anything
+			if (Page.Placements.Num() < 2)
+			{
+				continue;
+			}
+
+			const FString PagePath = RegisterPage(Key, Page, OutPages);
+			for (int32 PlacementIndex = 0; PlacementIndex < Page.Placements.Num(); ++PlacementIndex)
+			{
+				PathToPlacement.Add(Page.Placements[PlacementIndex].Path, {PagePath, PlacementIndex});
+			}
+
+			Stats.NumPackedTextures += Page.Placements.Num();
+			++Stats.NumPages;
+			PagesByPath.Add(PagePath, MoveTemp(Page));
+		}
+
+		for (const FCandidate& Candidate : Candidates)
+		{
+			FMaterialAttributeContainer& Material = Materials[Candidate.MaterialIndex];
+			const TPair<FString, int32>* Placement = PathToPlacement.Find(Material.TextureProperties[Key]);
+			if (!Placement)
+			{
+				continue;
+			}
+
+			const FAtlasPage& Page = PagesByPath[Placement->Key];
+			RemapUVs(MeshDescription, UVs, PolygonGroupIds[Candidate.MaterialIndex], Candidate.UVChannel, Candidate.Tile,
+					 Page.Placements[Placement->Value], Page.Metadata);
+
+			Material.TextureProperties[Key] = Placement->Key;
+			Material.UpdateId();
+		}
+	}
+
+	MergeIdenticalMaterials(MeshDescription, Materials, PolygonGroupIds);
+
+	Stats.NumMaterialsAfter = CountDistinctMaterials(Materials);
+	Stats.NumSectionsAfter = MeshDescription.PolygonGroups().Num();
+
+	UE_LOG(LogUnrealPrt, Verbose, TEXT("Texture atlas: %d textures packed into %d pages, %d -> %d materials, %d -> %d sections"),
+		   Stats.NumPackedTextures, Stats.NumPages, Stats.NumMaterialsBefore, Stats.NumMaterialsAfter, Stats.NumSectionsBefore,
+		   Stats.NumSectionsAfter);
+
+	{
+		FScopeLock Lock(&AtlasPagesLock);
+		TotalStats.NumMaterialsBefore += Stats.NumMaterialsBefore;
+		TotalStats.NumMaterialsAfter += Stats.NumMaterialsAfter;
+		TotalStats.NumSectionsBefore += Stats.NumSectionsBefore;
+		TotalStats.NumSectionsAfter += Stats.NumSectionsAfter;
+		TotalStats.NumPackedTextures += Stats.NumPackedTextures;
+		TotalStats.NumPages += Stats.NumPages;
+	}
+
+	return Stats;
+}
+
+bool IsTextureAtlasPage(const FString& Path)
+{
+	return Path.StartsWith(AtlasPagePrefix);
+}
+
+TArray<FString> GetTextureAtlasPageTextures(const FString& Path)
+{
+	FTextureAtlasPagePtr RegisteredPage;
+	{
+		FScopeLock Lock(&AtlasPagesLock);
+		if (const TWeakPtr<const FAtlasPage>* WeakPage = AtlasPages.Find(Path))
+		{
+			RegisteredPage = WeakPage->Pin();
+		}
+	}
+
+	TArray<FString> TexturePaths;
+	if (RegisteredPage)
+	{
+		TexturePaths.Reserve(RegisteredPage->Placements.Num());
+		for (const FAtlasPlacement& Placement : RegisteredPage->Placements)
+		{
+			TexturePaths.Add(Placement.Path);
+		}
+	}
+	return TexturePaths;
+}
+
+FTexturePixels AssembleTextureAtlasPage(const FString& Path)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_TextureAtlas_AssembleTextureAtlasPage);
+
+	FTextureAtlasPagePtr RegisteredPage;
+	{
+		FScopeLock Lock(&AtlasPagesLock);
+		if (const TWeakPtr<const FAtlasPage>* WeakPage = AtlasPages.Find(Path))
+		{
+			RegisteredPage = WeakPage->Pin();
+		}
+	}
+
+	// Only happens if the page is decoded after all meshes using it have been released
+	if (!RegisteredPage)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("Atlas page %s is not registered anymore"), *Path);
+		return {};
+	}
+	const FAtlasPage& Page = *RegisteredPage;
+
+	FTexturePixels Pixels;
+	Pixels.Metadata = Page.Metadata;
+
+	const size_t Bands = Page.Metadata.Bands;
+	const size_t RowSize = Page.Metadata.Width * Bands;
+	Pixels.BufferSize = RowSize * Page.Metadata.Height;
+	Pixels.Buffer = std::make_unique<uint8_t[]>(Pixels.BufferSize);
+
+	for (const FAtlasPlacement& Placement : Page.Placements)
+	{
+		const FTexturePixels Texture = VitruvioModule::Get().ReadTexture(Placement.Path);
+		if (static_cast<int32>(Texture.Metadata.Width) != Placement.Width || static_cast<int32>(Texture.Metadata.Height) != Placement.Height ||
+			Texture.Metadata.Bands != Bands ||
+			Texture.Metadata.BytesPerBand != 1)
+		{
+			UE_LOG(LogUnrealPrt, Warning, TEXT("Texture %s has changed since it was packed into atlas page %s"), *Placement.Path, *Path);
+			continue;
+		}
+
+		// Copy the rows and repeat the edge pixels into the padding
+		const size_t TextureRowSize = Placement.Width * Bands;
+		for (int32 Y = -AtlasPadding; Y < Placement.Height + AtlasPadding; ++Y)
+		{
+			const uint8* SourceRow = Texture.Buffer.get() + FMath::Clamp(Y, 0, Placement.Height - 1) * TextureRowSize;
+			uint8* Row = Pixels.Buffer.get() + (Placement.Y + Y) * RowSize + Placement.X * Bands;
+
+			for (int32 X = -AtlasPadding; X < 0; ++X)
+			{
+				FMemory::Memcpy(Row + X * static_cast<int64>(Bands), SourceRow, Bands);
+			}
+			FMemory::Memcpy(Row, SourceRow, TextureRowSize);
+			for (int32 X = Placement.Width; X < Placement.Width + AtlasPadding; ++X)
+			{
+				FMemory::Memcpy(Row + X * Bands, SourceRow + TextureRowSize - Bands, Bands);
+			}
+		}
+	}
+
+	return Pixels;
+}
+
+} // namespace Vitruvio
@@ -0,0 +1,77 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "MeshDescription.h"
+#include "TextureDecoding.h"
+#include "VitruvioTypes.h"
+
+namespace Vitruvio
+{
+
+struct FTextureAtlasStats
+{
+	int32 NumMaterialsBefore = 0;
+	int32 NumMaterialsAfter = 0;
+	int32 NumSectionsBefore = 0;
+	int32 NumSectionsAfter = 0;
+	int32 NumPackedTextures = 0;
+	int32 NumPages = 0;
+};
+
+/**
+ * An atlas page created by BuildTextureAtlases. A page stays registered, so that it can be assembled by AssembleTextureAtlasPage, as long
+ * as any reference to it is held.
+ */
+struct FTextureAtlasPage;
+using FTextureAtlasPagePtr = TSharedPtr<const FTextureAtlasPage>;
+
+/**
+ * Returns whether the textures of generated models are packed into atlas pages, see vitruvio.Atlas.Enabled.
+ */
+bool IsTextureAtlasingEnabled();
+
+/**
+ * Packs the textures of the given materials into shared atlas pages, grouped by map type and pixel format. Only materials with a single
+ * texture whose uvs stay within one repetition of the texture are packed, since atlas pages can not repeat their textures. The uvs of
+ * their polygons are remapped into the page, their texture is replaced by the page and polygon groups whose materials become identical
+ * are merged.
+ *
+ * @param MeshDescription	the mesh whose uvs and polygon groups are modified
+ * @param Materials			the materials of the polygon groups in the order of their ids, modified in place
+ * @param OutPages			receives the pages used by the materials, which have to be held as long as the materials may be created
+ * @return the number of materials and sections before and after packing.
+ */
+FTextureAtlasStats BuildTextureAtlases(FMeshDescription& MeshDescription, TArray<FMaterialAttributeContainer>& Materials,
+									   TArray<FTextureAtlasPagePtr>& OutPages);
+
+/**
+ * Returns whether the given texture path refers to an atlas page created by BuildTextureAtlases.
+ */
+bool IsTextureAtlasPage(const FString& Path);
+
+/**
+ * Assembles the pixels of the given atlas page from the textures packed into it. Returns no pixels (unknown pixel format) if the page is
+ * not registered anymore.
+ */
+FTexturePixels AssembleTextureAtlasPage(const FString& Path);
+
+/**
+ * Returns the paths of the textures packed into the given atlas page, or none if the page is not registered anymore.
+ */
+TArray<FString> GetTextureAtlasPageTextures(const FString& Path);
+
+} // namespace Vitruvio
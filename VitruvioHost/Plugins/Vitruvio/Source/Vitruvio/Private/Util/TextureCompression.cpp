@@ -0,0 +1,613 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCompression.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/Float16.h"
+
+namespace
+{
+TAutoConsoleVariable<bool> CVarGenerateMips(TEXT("vitruvio.Textures.GenerateMips"), false,
+											TEXT("Generate the full mip chain of decoded textures on the worker threads."));
+
+TAutoConsoleVariable<bool> CVarCompress(TEXT("vitruvio.Textures.Compress"), false,
+										TEXT("Compress decoded 8 bit textures to BC1/BC3/BC4/BC5 on the worker threads (implies mip generation)."));
+
+TAutoConsoleVariable<int32> CVarMaxResolution(TEXT("vitruvio.Textures.MaxResolution"), 0,
+											  TEXT("Maximum width and height of decoded textures, larger ones are downsampled on the worker threads. "
+												   "Rule packages can override it. 0 keeps the source resolution."));
+
+constexpr int32 BlockSize = 4;
+constexpr int32 BlockPixels = BlockSize * BlockSize;
+
+// Pixels are stored as B, G, R, A (PF_B8G8R8A8)
+constexpr int32 ChannelB = 0;
+constexpr int32 ChannelG = 1;
+constexpr int32 ChannelR = 2;
+constexpr int32 ChannelA = 3;
+
+int32 GetBlockBytes(EPixelFormat CompressedFormat)
+{
+	return CompressedFormat == PF_DXT1 || CompressedFormat == PF_BC4 ? 8 : 16;
+}
+
+// Box filters one 2x2 footprint per destination pixel, odd rows and columns are clamped to the border
+template <typename TChannel, typename TToFloat, typename TFromFloat>
+void Downsample(const TChannel* Src, int32 SrcSizeX, int32 SrcSizeY, TChannel* Dst, int32 DstSizeX, int32 DstSizeY, TToFloat ToFloat,
+				TFromFloat FromFloat)
+{
+	for (int32 Y = 0; Y < DstSizeY; ++Y)
+	{
+		const int32 Y0 = FMath::Min(Y * 2, SrcSizeY - 1);
+		const int32 Y1 = FMath::Min(Y * 2 + 1, SrcSizeY - 1);
+		for (int32 X = 0; X < DstSizeX; ++X)
+		{
+			const int32 X0 = FMath::Min(X * 2, SrcSizeX - 1);
+			const int32 X1 = FMath::Min(X * 2 + 1, SrcSizeX - 1);
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				const float Sum = ToFloat(Src[(Y0 * SrcSizeX + X0) * 4 + Channel]) + ToFloat(Src[(Y0 * SrcSizeX + X1) * 4 + Channel]) +
+								  ToFloat(Src[(Y1 * SrcSizeX + X0) * 4 + Channel]) + ToFloat(Src[(Y1 * SrcSizeX + X1) * 4 + Channel]);
+				Dst[(Y * DstSizeX + X) * 4 + Channel] = FromFloat(Sum * 0.25f);
+			}
+		}
+	}
+}
+
+void DownsampleMip(const uint8* Src, int32 SrcSizeX, int32 SrcSizeY, uint8* Dst, int32 DstSizeX, int32 DstSizeY, EPixelFormat PixelFormat)
+{
+	switch (PixelFormat)
+	{
+	case PF_B8G8R8A8:
+		Downsample(Src, SrcSizeX, SrcSizeY, Dst, DstSizeX, DstSizeY, [](uint8 Value) { return static_cast<float>(Value); },
+				   [](float Value) { return static_cast<uint8>(Value + 0.5f); });
+		break;
+	case PF_A16B16G16R16:
+		Downsample(reinterpret_cast<const uint16*>(Src), SrcSizeX, SrcSizeY, reinterpret_cast<uint16*>(Dst), DstSizeX, DstSizeY,
+				   [](uint16 Value) { return static_cast<float>(Value); }, [](float Value) { return static_cast<uint16>(Value + 0.5f); });
+		break;
+	case PF_FloatRGBA:
+		Downsample(reinterpret_cast<const FFloat16*>(Src), SrcSizeX, SrcSizeY, reinterpret_cast<FFloat16*>(Dst), DstSizeX, DstSizeY,
+				   [](FFloat16 Value) { return Value.GetFloat(); }, [](float Value) { return FFloat16(Value); });
+		break;
+	default:
+		checkNoEntry();
+	}
+}
+
+// Averages the source pixels covered by each destination pixel weighted by their coverage, for any reduction ratio of at least 1
+template <typename TChannel, typename TToFloat, typename TFromFloat>
+void ResampleArea(const TChannel* Src, int32 SrcSizeX, int32 SrcSizeY, TChannel* Dst, int32 DstSizeX, int32 DstSizeY, TToFloat ToFloat,
+				  TFromFloat FromFloat)
+{
+	const double ScaleX = static_cast<double>(SrcSizeX) / DstSizeX;
+	const double ScaleY = static_cast<double>(SrcSizeY) / DstSizeY;
+	const float Normalization = static_cast<float>(1.0 / (ScaleX * ScaleY));
+	for (int32 Y = 0; Y < DstSizeY; ++Y)
+	{
+		const double Y0 = Y * ScaleY;
+		const double Y1 = (Y + 1) * ScaleY;
+		const int32 EndY = FMath::Min(FMath::CeilToInt32(Y1), SrcSizeY);
+		for (int32 X = 0; X < DstSizeX; ++X)
+		{
+			const double X0 = X * ScaleX;
+			const double X1 = (X + 1) * ScaleX;
+			const int32 EndX = FMath::Min(FMath::CeilToInt32(X1), SrcSizeX);
+
+			float Sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (int32 SrcY = FMath::FloorToInt32(Y0); SrcY < EndY; ++SrcY)
+			{
+				const double WeightY = FMath::Min<double>(Y1, SrcY + 1) - FMath::Max<double>(Y0, SrcY);
+				for (int32 SrcX = FMath::FloorToInt32(X0); SrcX < EndX; ++SrcX)
+				{
+					const float Weight = static_cast<float>(WeightY * (FMath::Min<double>(X1, SrcX + 1) - FMath::Max<double>(X0, SrcX)));
+					const TChannel* Pixel = Src + (static_cast<int64>(SrcY) * SrcSizeX + SrcX) * 4;
+					for (int32 Channel = 0; Channel < 4; ++Channel)
+					{
+						Sum[Channel] += Weight * ToFloat(Pixel[Channel]);
+					}
+				}
+			}
+
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				Dst[(static_cast<int64>(Y) * DstSizeX + X) * 4 + Channel] = FromFloat(Sum[Channel] * Normalization);
+			}
+		}
+	}
+}
+
+void ResampleMip(const uint8* Src, int32 SrcSizeX, int32 SrcSizeY, uint8* Dst, int32 DstSizeX, int32 DstSizeY, EPixelFormat PixelFormat)
+{
+	switch (PixelFormat)
+	{
+	case PF_B8G8R8A8:
+		ResampleArea(Src, SrcSizeX, SrcSizeY, Dst, DstSizeX, DstSizeY, [](uint8 Value) { return static_cast<float>(Value); },
+					 [](float Value) { return static_cast<uint8>(FMath::Min(Value + 0.5f, 255.0f)); });
+		break;
+	case PF_A16B16G16R16:
+		ResampleArea(reinterpret_cast<const uint16*>(Src), SrcSizeX, SrcSizeY, reinterpret_cast<uint16*>(Dst), DstSizeX, DstSizeY,
+					 [](uint16 Value) { return static_cast<float>(Value); },
+					 [](float Value) { return static_cast<uint16>(FMath::Min(Value + 0.5f, 65535.0f)); });
+		break;
+	case PF_FloatRGBA:
+		ResampleArea(reinterpret_cast<const FFloat16*>(Src), SrcSizeX, SrcSizeY, reinterpret_cast<FFloat16*>(Dst), DstSizeX, DstSizeY,
+					 [](FFloat16 Value) { return Value.GetFloat(); }, [](float Value) { return FFloat16(Value); });
+		break;
+	default:
+		checkNoEntry();
+	}
+}
+
+void LoadBlock(const uint8* Pixels, int32 SizeX, int32 SizeY, int32 BlockX, int32 BlockY, uint8 (&Block)[BlockPixels][4])
+{
+	for (int32 Y = 0; Y < BlockSize; ++Y)
+	{
+		const int32 PixelY = FMath::Min(BlockY * BlockSize + Y, SizeY - 1);
+		for (int32 X = 0; X < BlockSize; ++X)
+		{
+			const int32 PixelX = FMath::Min(BlockX * BlockSize + X, SizeX - 1);
+			FMemory::Memcpy(Block[Y * BlockSize + X], Pixels + (static_cast<int64>(PixelY) * SizeX + PixelX) * 4, 4);
+		}
+	}
+}
+
+void StoreBlock(uint8* Pixels, int32 SizeX, int32 SizeY, int32 BlockX, int32 BlockY, const uint8 (&Block)[BlockPixels][4])
+{
+	for (int32 Y = 0; Y < BlockSize && BlockY * BlockSize + Y < SizeY; ++Y)
+	{
+		for (int32 X = 0; X < BlockSize && BlockX * BlockSize + X < SizeX; ++X)
+		{
+			const int64 PixelIndex = static_cast<int64>(BlockY * BlockSize + Y) * SizeX + BlockX * BlockSize + X;
+			FMemory::Memcpy(Pixels + PixelIndex * 4, Block[Y * BlockSize + X], 4);
+		}
+	}
+}
+
+uint16 ToRGB565(const int32 (&Color)[3])
+{
+	const int32 R = (Color[0] * 31 + 127) / 255;
+	const int32 G = (Color[1] * 63 + 127) / 255;
+	const int32 B = (Color[2] * 31 + 127) / 255;
+	return static_cast<uint16>((R << 11) | (G << 5) | B);
+}
+
+void FromRGB565(uint16 Color, int32 (&OutColor)[3])
+{
+	const int32 R = (Color >> 11) & 31;
+	const int32 G = (Color >> 5) & 63;
+	const int32 B = Color & 31;
+	OutColor[0] = (R << 3) | (R >> 2);
+	OutColor[1] = (G << 2) | (G >> 4);
+	OutColor[2] = (B << 3) | (B >> 2);
+}
+
+// Endpoints are the inset corners of the bounding box along the dominant diagonal, indices the nearest of the four palette colors
+void CompressBC1Block(const uint8 (&Block)[BlockPixels][4], uint8* Out)
+{
+	constexpr int32 Channels[3] = {ChannelR, ChannelG, ChannelB};
+
+	int32 Min[3] = {255, 255, 255};
+	int32 Max[3] = {0, 0, 0};
+	int32 Mean[3] = {0, 0, 0};
+	for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+	{
+		for (int32 Channel = 0; Channel < 3; ++Channel)
+		{
+			const int32 Value = Block[Pixel][Channels[Channel]];
+			Min[Channel] = FMath::Min(Min[Channel], Value);
+			Max[Channel] = FMath::Max(Max[Channel], Value);
+			Mean[Channel] += Value;
+		}
+	}
+
+	// Flip the diagonal for channels which are anti-correlated with the channel of the largest extent
+	int32 Dominant = 0;
+	for (int32 Channel = 1; Channel < 3; ++Channel)
+	{
+		if (Max[Channel] - Min[Channel] > Max[Dominant] - Min[Dominant])
+		{
+			Dominant = Channel;
+		}
+	}
+	for (int32 Channel = 0; Channel < 3; ++Channel)
+	{
+		int32 Covariance = 0;
+		for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+		{
+			Covariance += (Block[Pixel][Channels[Channel]] * BlockPixels - Mean[Channel]) *
+						  (Block[Pixel][Channels[Dominant]] * BlockPixels - Mean[Dominant]);
+		}
+		if (Covariance < 0)
+		{
+			Swap(Min[Channel], Max[Channel]);
+		}
+	}
+
+	int32 Start[3];
+	int32 End[3];
+	for (int32 Channel = 0; Channel < 3; ++Channel)
+	{
+		const int32 Inset = (Max[Channel] - Min[Channel]) / 16;
+		Start[Channel] = Max[Channel] - Inset;
+		End[Channel] = Min[Channel] + Inset;
+	}
+
+	uint16 Color0 = ToRGB565(Start);
+	uint16 Color1 = ToRGB565(End);
+	if (Color0 < Color1)
+	{
+		Swap(Color0, Color1);
+	}
+
+	int32 Palette[4][3];
+	FromRGB565(Color0, Palette[0]);
+	FromRGB565(Color1, Palette[1]);
+	for (int32 Channel = 0; Channel < 3; ++Channel)
+	{
+		Palette[2][Channel] = (2 * Palette[0][Channel] + Palette[1][Channel]) / 3;
+		Palette[3][Channel] = (Palette[0][Channel] + 2 * Palette[1][Channel]) / 3;
+	}
+
+	uint32 Indices = 0;
+	if (Color0 != Color1)
+	{
+		for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+		{
+			int32 BestIndex = 0;
+			int32 BestDistance = MAX_int32;
+			for (int32 Index = 0; Index < 4; ++Index)
+			{
+				int32 Distance = 0;
+				for (int32 Channel = 0; Channel < 3; ++Channel)
+				{
+					const int32 Delta = Block[Pixel][Channels[Channel]] - Palette[Index][Channel];
+					Distance += Delta * Delta;
+				}
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestIndex = Index;
+				}
+			}
+			Indices |= static_cast<uint32>(BestIndex) << (Pixel * 2);
+		}
+	}
+
+	FMemory::Memcpy(Out + 0, &Color0, sizeof(Color0));
+	FMemory::Memcpy(Out + 2, &Color1, sizeof(Color1));
+	FMemory::Memcpy(Out + 4, &Indices, sizeof(Indices));
+}
+
+// Always uses the eight value mode with the extremes of the block as endpoints
+void CompressBC4Block(const uint8 (&Block)[BlockPixels][4], int32 Channel, uint8* Out)
+{
+	int32 Min = 255;
+	int32 Max = 0;
+	for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+	{
+		Min = FMath::Min<int32>(Min, Block[Pixel][Channel]);
+		Max = FMath::Max<int32>(Max, Block[Pixel][Channel]);
+	}
+
+	Out[0] = static_cast<uint8>(Max);
+	Out[1] = static_cast<uint8>(Min);
+
+	uint64 Indices = 0;
+	if (Max > Min)
+	{
+		const int32 Range = Max - Min;
+		for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+		{
+			// Step 0 is the first endpoint (code 0), step 7 the second one (code 1) and the steps in between are codes 2 to 7
+			const int32 Step = ((Max - Block[Pixel][Channel]) * 7 + Range / 2) / Range;
+			const uint64 Code = Step == 0 ? 0 : (Step == 7 ? 1 : Step + 1);
+			Indices |= Code << (Pixel * 3);
+		}
+	}
+
+	for (int32 Byte = 0; Byte < 6; ++Byte)
+	{
+		Out[2 + Byte] = static_cast<uint8>(Indices >> (Byte * 8));
+	}
+}
+
+void DecompressBC1Block(const uint8* In, uint8 (&Block)[BlockPixels][4], bool bAlwaysFourColors)
+{
+	uint16 Color0;
+	uint16 Color1;
+	uint32 Indices;
+	FMemory::Memcpy(&Color0, In + 0, sizeof(Color0));
+	FMemory::Memcpy(&Color1, In + 2, sizeof(Color1));
+	FMemory::Memcpy(&Indices, In + 4, sizeof(Indices));
+
+	int32 Palette[4][3];
+	FromRGB565(Color0, Palette[0]);
+	FromRGB565(Color1, Palette[1]);
+
+	const bool bFourColors = bAlwaysFourColors || Color0 > Color1;
+	for (int32 Channel = 0; Channel < 3; ++Channel)
+	{
+		if (bFourColors)
+		{
+			Palette[2][Channel] = (2 * Palette[0][Channel] + Palette[1][Channel]) / 3;
+			Palette[3][Channel] = (Palette[0][Channel] + 2 * Palette[1][Channel]) / 3;
+		}
+		else
+		{
+			Palette[2][Channel] = (Palette[0][Channel] + Palette[1][Channel]) / 2;
+			Palette[3][Channel] = 0;
+		}
+	}
+	for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+	{
+		const int32 Index = (Indices >> (Pixel * 2)) & 3;
+		Block[Pixel][ChannelR] = static_cast<uint8>(Palette[Index][0]);
+		Block[Pixel][ChannelG] = static_cast<uint8>(Palette[Index][1]);
+		Block[Pixel][ChannelB] = static_cast<uint8>(Palette[Index][2]);
+		// Index 3 is transparent black in the three color mode
+		Block[Pixel][ChannelA] = !bFourColors && Index == 3 ? 0 : 255;
+	}
+}
+
+void DecompressBC4Block(const uint8* In, uint8 (&Block)[BlockPixels][4], int32 Channel)
+{
+	const int32 Value0 = In[0];
+	const int32 Value1 = In[1];
+
+	int32 Palette[8] = {Value0, Value1};
+	for (int32 Code = 2; Code < 8; ++Code)
+	{
+		if (Value0 > Value1)
+		{
+			Palette[Code] = ((8 - Code) * Value0 + (Code - 1) * Value1) / 7;
+		}
+		else
+		{
+			Palette[Code] = Code < 6 ? ((6 - Code) * Value0 + (Code - 1) * Value1) / 5 : (Code == 6 ? 0 : 255);
+		}
+	}
+
+	uint64 Indices = 0;
+	for (int32 Byte = 0; Byte < 6; ++Byte)
+	{
+		Indices |= static_cast<uint64>(In[2 + Byte]) << (Byte * 8);
+	}
+
+	for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+	{
+		Block[Pixel][Channel] = static_cast<uint8>(Palette[(Indices >> (Pixel * 3)) & 7]);
+	}
+}
+} // namespace
+
+namespace Vitruvio
+{
+
+FTextureCompressionSettings GetTextureCompressionSettings()
+{
+	FTextureCompressionSettings Settings;
+	Settings.bCompress = CVarCompress.GetValueOnAnyThread();
+	Settings.bGenerateMips = Settings.bCompress || CVarGenerateMips.GetValueOnAnyThread();
+	Settings.MaxResolution = FMath::Max(0, CVarMaxResolution.GetValueOnAnyThread());
+	return Settings;
+}
+
+EPixelFormat GetCompressedPixelFormat(const FString& Key, EPixelFormat PixelFormat, uint32 NumChannels, int32 SizeX, int32 SizeY)
+{
+	// Block compressed textures need a top level which is a multiple of the block size
+	if (PixelFormat != PF_B8G8R8A8 || SizeX % BlockSize != 0 || SizeY % BlockSize != 0)
+	{
+		return PF_Unknown;
+	}
+
+	EPixelFormat CompressedFormat;
+	if (Key == TEXT("normalMap"))
+	{
+		CompressedFormat = PF_BC5;
+	}
+	else if ((Key == TEXT("roughnessMap") || Key == TEXT("metallicMap")) && NumChannels == 1)
+	{
+		// Only grayscale maps are single channel, color maps may pack other masks into green and blue (e.g. occlusion/roughness/metallic)
+		CompressedFormat = PF_BC4;
+	}
+	else
+	{
+		CompressedFormat = NumChannels == 4 ? PF_DXT5 : PF_DXT1;
+	}
+
+	return GPixelFormats[CompressedFormat].Supported ? CompressedFormat : PF_Unknown;
+}
+
+TArray<FTextureMipData> GenerateMips(const uint8* Pixels, int32 SizeX, int32 SizeY, EPixelFormat PixelFormat)
+{
+	TArray<FTextureMipData> Mips;
+
+	const int32 BytesPerPixel = GPixelFormats[PixelFormat].BlockBytes;
+	const uint8* SrcPixels = Pixels;
+	int32 SrcSizeX = SizeX;
+	int32 SrcSizeY = SizeY;
+	while (SrcSizeX > 1 || SrcSizeY > 1)
+	{
+		FTextureMipData& Mip = Mips.AddDefaulted_GetRef();
+		Mip.SizeX = FMath::Max(1, SrcSizeX / 2);
+		Mip.SizeY = FMath::Max(1, SrcSizeY / 2);
+		Mip.Data.SetNumUninitialized(static_cast<int64>(Mip.SizeX) * Mip.SizeY * BytesPerPixel);
+		DownsampleMip(SrcPixels, SrcSizeX, SrcSizeY, Mip.Data.GetData(), Mip.SizeX, Mip.SizeY, PixelFormat);
+
+		SrcPixels = Mip.Data.GetData();
+		SrcSizeX = Mip.SizeX;
+		SrcSizeY = Mip.SizeY;
+	}
+
+	return Mips;
+}
+
+TArray64<uint8> DownsampleToMaxSize(const uint8* Pixels, int32& InOutSizeX, int32& InOutSizeY, int32 MaxSize, EPixelFormat PixelFormat)
+{
+	check(MaxSize > 0);
+
+	if (InOutSizeX <= MaxSize && InOutSizeY <= MaxSize)
+	{
+		return {};
+	}
+
+	// The longer side becomes MaxSize and the shorter one keeps the aspect ratio. Sides of at least 4 pixels are rounded down to a
+	// multiple of 4 so that the result can still be block compressed.
+	const double Scale = static_cast<double>(MaxSize) / FMath::Max(InOutSizeX, InOutSizeY);
+	auto GetTargetSize = [Scale, MaxSize](int32 Size) {
+		const int32 TargetSize = FMath::Clamp(FMath::RoundToInt32(Size * Scale), 1, MaxSize);
+		return TargetSize >= 4 ? TargetSize & ~3 : TargetSize;
+	};
+	const int32 TargetSizeX = GetTargetSize(InOutSizeX);
+	const int32 TargetSizeY = GetTargetSize(InOutSizeY);
+
+	// Halve with the mip filter while possible, which is cheap, and resample the remaining reduction of less than 2 to the exact size
+	const int32 BytesPerPixel = GPixelFormats[PixelFormat].BlockBytes;
+	TArray64<uint8> Downsampled;
+	TArray64<uint8> Halved;
+	while (InOutSizeX / 2 >= TargetSizeX && InOutSizeY / 2 >= TargetSizeY)
+	{
+		const int32 HalvedSizeX = InOutSizeX / 2;
+		const int32 HalvedSizeY = InOutSizeY / 2;
+		Halved.SetNumUninitialized(static_cast<int64>(HalvedSizeX) * HalvedSizeY * BytesPerPixel);
+		DownsampleMip(Downsampled.IsEmpty() ? Pixels : Downsampled.GetData(), InOutSizeX, InOutSizeY, Halved.GetData(), HalvedSizeX, HalvedSizeY,
+					  PixelFormat);
+
+		Swap(Downsampled, Halved);
+		InOutSizeX = HalvedSizeX;
+		InOutSizeY = HalvedSizeY;
+	}
+
+	if (InOutSizeX != TargetSizeX || InOutSizeY != TargetSizeY)
+	{
+		Halved.SetNumUninitialized(static_cast<int64>(TargetSizeX) * TargetSizeY * BytesPerPixel);
+		ResampleMip(Downsampled.IsEmpty() ? Pixels : Downsampled.GetData(), InOutSizeX, InOutSizeY, Halved.GetData(), TargetSizeX, TargetSizeY,
+					PixelFormat);
+
+		Swap(Downsampled, Halved);
+		InOutSizeX = TargetSizeX;
+		InOutSizeY = TargetSizeY;
+	}
+
+	return Downsampled;
+}
+
+TArray64<uint8> CompressBlocks(const uint8* Pixels, int32 SizeX, int32 SizeY, EPixelFormat CompressedFormat)
+{
+	const int32 BlocksX = FMath::DivideAndRoundUp(SizeX, BlockSize);
+	const int32 BlocksY = FMath::DivideAndRoundUp(SizeY, BlockSize);
+	const int32 BlockBytes = GetBlockBytes(CompressedFormat);
+
+	TArray64<uint8> Blocks;
+	Blocks.SetNumUninitialized(static_cast<int64>(BlocksX) * BlocksY * BlockBytes);
+
+	uint8 Block[BlockPixels][4];
+	uint8* Out = Blocks.GetData();
+	for (int32 BlockY = 0; BlockY < BlocksY; ++BlockY)
+	{
+		for (int32 BlockX = 0; BlockX < BlocksX; ++BlockX)
+		{
+			LoadBlock(Pixels, SizeX, SizeY, BlockX, BlockY, Block);
+			switch (CompressedFormat)
+			{
+			case PF_DXT1:
+				CompressBC1Block(Block, Out);
+				break;
+			case PF_DXT5:
+				CompressBC4Block(Block, ChannelA, Out);
+				CompressBC1Block(Block, Out + 8);
+				break;
+			case PF_BC4:
+				CompressBC4Block(Block, ChannelR, Out);
+				break;
+			case PF_BC5:
+				CompressBC4Block(Block, ChannelR, Out);
+				CompressBC4Block(Block, ChannelG, Out + 8);
+				break;
+			default:
+				checkNoEntry();
+			}
+			Out += BlockBytes;
+		}
+	}
+
+	return Blocks;
+}
+
+TArray64<uint8> DecompressBlocks(const uint8* Blocks, int32 SizeX, int32 SizeY, EPixelFormat CompressedFormat)
+{
+	const int32 BlocksX = FMath::DivideAndRoundUp(SizeX, BlockSize);
+	const int32 BlocksY = FMath::DivideAndRoundUp(SizeY, BlockSize);
+	const int32 BlockBytes = GetBlockBytes(CompressedFormat);
+
+	TArray64<uint8> Pixels;
+	Pixels.SetNumUninitialized(static_cast<int64>(SizeX) * SizeY * 4);
+
+	uint8 Block[BlockPixels][4];
+	const uint8* In = Blocks;
+	for (int32 BlockY = 0; BlockY < BlocksY; ++BlockY)
+	{
+		for (int32 BlockX = 0; BlockX < BlocksX; ++BlockX)
+		{
+			switch (CompressedFormat)
+			{
+			case PF_DXT1:
+				DecompressBC1Block(In, Block, false);
+				break;
+			case PF_DXT5:
+				DecompressBC1Block(In + 8, Block, true);
+				DecompressBC4Block(In, Block, ChannelA);
+				break;
+			case PF_BC4:
+				// Single channel maps were grayscale before compression
+				DecompressBC4Block(In, Block, ChannelR);
+				for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+				{
+					Block[Pixel][ChannelG] = Block[Pixel][ChannelB] = Block[Pixel][ChannelR];
+					Block[Pixel][ChannelA] = 255;
+				}
+				break;
+			case PF_BC5:
+				// The blue channel of normal maps is reconstructed from the unit length of the normal
+				DecompressBC4Block(In, Block, ChannelR);
+				DecompressBC4Block(In + 8, Block, ChannelG);
+				for (int32 Pixel = 0; Pixel < BlockPixels; ++Pixel)
+				{
+					const float NormalX = Block[Pixel][ChannelR] / 127.5f - 1.0f;
+					const float NormalY = Block[Pixel][ChannelG] / 127.5f - 1.0f;
+					const float NormalZ = FMath::Sqrt(FMath::Max(0.0f, 1.0f - NormalX * NormalX - NormalY * NormalY));
+					Block[Pixel][ChannelB] = static_cast<uint8>(FMath::Clamp((NormalZ + 1.0f) * 127.5f, 0.0f, 255.0f));
+					Block[Pixel][ChannelA] = 255;
+				}
+				break;
+			default:
+				checkNoEntry();
+			}
+			StoreBlock(Pixels.GetData(), SizeX, SizeY, BlockX, BlockY, Block);
+			In += BlockBytes;
+		}
+	}
+
+	return Pixels;
+}
+
+bool IsBlockCompressed(EPixelFormat PixelFormat)
+{
+	return PixelFormat == PF_DXT1 || PixelFormat == PF_DXT5 || PixelFormat == PF_BC4 || PixelFormat == PF_BC5;
+}
+
+} // namespace Vitruvio
@@ -14,14 +14,30 @@
  */
 
 #include "TextureDecoding.h"
+#include "TextureCompression.h"
 #include "Engine/TextureDefines.h"
 #include "HAL/PlatformFileManager.h"
+#include "Hash/xxhash.h"
 #include "Engine/Texture2D.h"
 #include "Runtime/Engine/Public/TextureResource.h"
 #include "UObject/Package.h"
 
 #include <string>
 
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#define VITRUVIO_DECODE_NEON 1
+#define VITRUVIO_DECODE_SSE 0
+#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+// SSE2 is part of every x64 target, the kernels only use SSE2 so they do not depend on the SSE4/AVX target settings
+#define VITRUVIO_DECODE_NEON 0
+#define VITRUVIO_DECODE_SSE 1
+#include <emmintrin.h>
+#else
+#define VITRUVIO_DECODE_NEON 0
+#define VITRUVIO_DECODE_SSE 0
+#endif
+
 namespace
 {
 struct FTextureSettings
@@ -43,6 +59,264 @@ FTextureSettings GetTextureSettings(const FString& Key, EPixelFormat PixelFormat
 	bool IsGrayscale = PixelFormat == EPixelFormat::PF_G8 || PixelFormat == EPixelFormat::PF_G16 || EPixelFormat::PF_R32_FLOAT;
 	return {!IsGrayscale, TC_Default};
 }
+
+// Pixels with an opacity below the black or above the white threshold are considered fully transparent or opaque
+constexpr double BlackColorThreshold = 0.02;
+constexpr double WhiteColorThreshold = 1.0 - BlackColorThreshold;
+
+// Histogram of the opacity channel of the converted pixels, alpha for textures with 4 bands and red otherwise
+class FOpacityHistogram
+{
+public:
+	FOpacityHistogram(const Vitruvio::FTextureMetadata& TextureMetadata)
+		: Channel(TextureMetadata.Bands == 4 ? 3 : 2)
+	{
+		switch (TextureMetadata.PixelFormat)
+		{
+		case Vitruvio::EPRTPixelFormat::GREY8:
+		case Vitruvio::EPRTPixelFormat::RGB8:
+		case Vitruvio::EPRTPixelFormat::RGBA8:
+			Bins.SetNumZeroed(TNumericLimits<uint8>::Max() + 1);
+			break;
+		case Vitruvio::EPRTPixelFormat::GREY16:
+			Bins.SetNumZeroed(TNumericLimits<uint16>::Max() + 1);
+			break;
+		default:
+			// Float textures are never used to choose a blend mode
+			break;
+		}
+	}
+
+	void AddRow(const uint8* Row, int32 Width)
+	{
+		if (Bins.Num() == TNumericLimits<uint8>::Max() + 1)
+		{
+			for (int32 X = 0; X < Width; ++X)
+			{
+				++Bins[Row[X * 4 + Channel]];
+			}
+		}
+		else if (!Bins.IsEmpty())
+		{
+			// RGBA16 rows, the opacity is the red channel
+			for (int32 X = 0; X < Width; ++X)
+			{
+				uint16 Value;
+				FMemory::Memcpy(&Value, Row + X * 8, sizeof(uint16));
+				++Bins[Value];
+			}
+		}
+	}
+
+	void Count(uint32& OutBlackPixels, uint32& OutWhitePixels) const
+	{
+		OutBlackPixels = 0;
+		OutWhitePixels = 0;
+
+		const float MaxValue = static_cast<float>(Bins.Num() - 1);
+		for (int32 Bin = 0; Bin < Bins.Num(); ++Bin)
+		{
+			const float Value = static_cast<float>(Bin) / MaxValue;
+			if (Value < BlackColorThreshold)
+			{
+				OutBlackPixels += Bins[Bin];
+			}
+			else if (Value > WhiteColorThreshold)
+			{
+				OutWhitePixels += Bins[Bin];
+			}
+		}
+	}
+
+private:
+	int32 Channel;
+	TArray<uint32> Bins;
+};
+
+// Row kernels converting one row of PRT pixels to the corresponding Unreal pixel format. Grayscale images are also converted to
+// rgba, since texture params don't automatically update their sample method. Alpha is 0 for sources without an alpha band.
+using FRowConverter = void (*)(const uint8* Src, uint8* Dst, int32 Width);
+
+void ConvertRowGrey8ToBGRA8(const uint8* Src, uint8* Dst, int32 Width)
+{
+	int32 X = 0;
+#if VITRUVIO_DECODE_NEON
+	const uint8x16_t Zero = vdupq_n_u8(0);
+	for (; X + 16 <= Width; X += 16)
+	{
+		const uint8x16_t Grey = vld1q_u8(Src + X);
+		vst4q_u8(Dst + X * 4, uint8x16x4_t {{Grey, Grey, Grey, Zero}});
+	}
+#elif VITRUVIO_DECODE_SSE
+	const __m128i ColorMask = _mm_set1_epi32(0x00FFFFFF);
+	for (; X + 16 <= Width; X += 16)
+	{
+		const __m128i Grey = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X));
+		const __m128i Lo = _mm_unpacklo_epi8(Grey, Grey);
+		const __m128i Hi = _mm_unpackhi_epi8(Grey, Grey);
+		__m128i* Out = reinterpret_cast<__m128i*>(Dst + X * 4);
+		_mm_storeu_si128(Out + 0, _mm_and_si128(_mm_unpacklo_epi16(Lo, Lo), ColorMask));
+		_mm_storeu_si128(Out + 1, _mm_and_si128(_mm_unpackhi_epi16(Lo, Lo), ColorMask));
+		_mm_storeu_si128(Out + 2, _mm_and_si128(_mm_unpacklo_epi16(Hi, Hi), ColorMask));
+		_mm_storeu_si128(Out + 3, _mm_and_si128(_mm_unpackhi_epi16(Hi, Hi), ColorMask));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		uint8* Out = Dst + X * 4;
+		Out[0] = Out[1] = Out[2] = Src[X];
+		Out[3] = 0;
+	}
+}
+
+void ConvertRowGrey16ToRGBA16(const uint8* Src, uint8* Dst, int32 Width)
+{
+	const uint16* Src16 = reinterpret_cast<const uint16*>(Src);
+	uint16* Dst16 = reinterpret_cast<uint16*>(Dst);
+
+	int32 X = 0;
+#if VITRUVIO_DECODE_NEON
+	const uint16x8_t Zero = vdupq_n_u16(0);
+	for (; X + 8 <= Width; X += 8)
+	{
+		const uint16x8_t Grey = vld1q_u16(Src16 + X);
+		vst4q_u16(Dst16 + X * 4, uint16x8x4_t {{Grey, Grey, Grey, Zero}});
+	}
+#elif VITRUVIO_DECODE_SSE
+	const __m128i Zero = _mm_setzero_si128();
+	for (; X + 8 <= Width; X += 8)
+	{
+		const __m128i Grey = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src16 + X));
+		const __m128i GreyGreyLo = _mm_unpacklo_epi16(Grey, Grey);
+		const __m128i GreyZeroLo = _mm_unpacklo_epi16(Grey, Zero);
+		const __m128i GreyGreyHi = _mm_unpackhi_epi16(Grey, Grey);
+		const __m128i GreyZeroHi = _mm_unpackhi_epi16(Grey, Zero);
+		__m128i* Out = reinterpret_cast<__m128i*>(Dst16 + X * 4);
+		_mm_storeu_si128(Out + 0, _mm_unpacklo_epi32(GreyGreyLo, GreyZeroLo));
+		_mm_storeu_si128(Out + 1, _mm_unpackhi_epi32(GreyGreyLo, GreyZeroLo));
+		_mm_storeu_si128(Out + 2, _mm_unpacklo_epi32(GreyGreyHi, GreyZeroHi));
+		_mm_storeu_si128(Out + 3, _mm_unpackhi_epi32(GreyGreyHi, GreyZeroHi));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		uint16 Grey;
+		FMemory::Memcpy(&Grey, Src16 + X, sizeof(uint16));
+		const uint16 Pixel[4] = {Grey, Grey, Grey, 0};
+		FMemory::Memcpy(Dst16 + X * 4, Pixel, sizeof(Pixel));
+	}
+}
+
+void ConvertRowRGB8ToBGRA8(const uint8* Src, uint8* Dst, int32 Width)
+{
+	int32 X = 0;
+#if VITRUVIO_DECODE_NEON
+	const uint8x16_t Zero = vdupq_n_u8(0);
+	for (; X + 16 <= Width; X += 16)
+	{
+		const uint8x16x3_t RGB = vld3q_u8(Src + X * 3);
+		vst4q_u8(Dst + X * 4, uint8x16x4_t {{RGB.val[2], RGB.val[1], RGB.val[0], Zero}});
+	}
+#elif VITRUVIO_DECODE_SSE
+	// Four pixels per iteration, each loaded as 32 bits including the first byte of the next pixel. Stop early enough for the last
+	// load to stay within the row.
+	const __m128i RMask = _mm_set1_epi32(0x000000FF);
+	const __m128i GMask = _mm_set1_epi32(0x0000FF00);
+	for (; X + 5 <= Width; X += 4)
+	{
+		const uint8* In = Src + X * 3;
+		uint32 Pixels[4];
+		FMemory::Memcpy(&Pixels[0], In + 0, sizeof(uint32));
+		FMemory::Memcpy(&Pixels[1], In + 3, sizeof(uint32));
+		FMemory::Memcpy(&Pixels[2], In + 6, sizeof(uint32));
+		FMemory::Memcpy(&Pixels[3], In + 9, sizeof(uint32));
+		const __m128i RGBX = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels));
+		const __m128i R = _mm_slli_epi32(_mm_and_si128(RGBX, RMask), 16);
+		const __m128i G = _mm_and_si128(RGBX, GMask);
+		const __m128i B = _mm_and_si128(_mm_srli_epi32(RGBX, 16), RMask);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + X * 4), _mm_or_si128(_mm_or_si128(R, G), B));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		const uint8* In = Src + X * 3;
+		uint8* Out = Dst + X * 4;
+		Out[0] = In[2];
+		Out[1] = In[1];
+		Out[2] = In[0];
+		Out[3] = 0;
+	}
+}
+
+void ConvertRowRGBA8ToBGRA8(const uint8* Src, uint8* Dst, int32 Width)
+{
+	int32 X = 0;
+#if VITRUVIO_DECODE_NEON
+	for (; X + 16 <= Width; X += 16)
+	{
+		const uint8x16x4_t RGBA = vld4q_u8(Src + X * 4);
+		vst4q_u8(Dst + X * 4, uint8x16x4_t {{RGBA.val[2], RGBA.val[1], RGBA.val[0], RGBA.val[3]}});
+	}
+#elif VITRUVIO_DECODE_SSE
+	// Swap red and blue by rotating the 16 bit halves of the red/blue bytes of each pixel
+	const __m128i RBMask = _mm_set1_epi32(0x00FF00FF);
+	const __m128i GAMask = _mm_set1_epi32(0xFF00FF00);
+	for (; X + 4 <= Width; X += 4)
+	{
+		const __m128i RGBA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X * 4));
+		const __m128i RB = _mm_and_si128(RGBA, RBMask);
+		const __m128i BR = _mm_or_si128(_mm_slli_epi32(RB, 16), _mm_srli_epi32(RB, 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + X * 4), _mm_or_si128(_mm_and_si128(RGBA, GAMask), BR));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		const uint8* In = Src + X * 4;
+		uint8* Out = Dst + X * 4;
+		Out[0] = In[2];
+		Out[1] = In[1];
+		Out[2] = In[0];
+		Out[3] = In[3];
+	}
+}
+
+// Converts 32 bit grayscale float textures to 16 bit RGBA float textures. The half conversion itself stays scalar so the rounding
+// is exactly the one of FFloat16.
+void ConvertRowFloat32ToFloatRGBA(const uint8* Src, uint8* Dst, int32 Width)
+{
+	const float* FloatSrc = reinterpret_cast<const float*>(Src);
+	FFloat16Color* Float16Dst = reinterpret_cast<FFloat16Color*>(Dst);
+	const FFloat16 One(1.0f);
+
+	for (int32 X = 0; X < Width; ++X)
+	{
+		const FFloat16 Float16Value(FloatSrc[X]);
+		FFloat16Color& Color = Float16Dst[X];
+		Color.R = Float16Value;
+		Color.G = Float16Value;
+		Color.B = Float16Value;
+		Color.A = One;
+	}
+}
+
+FRowConverter GetRowConverter(Vitruvio::EPRTPixelFormat PixelFormat)
+{
+	switch (PixelFormat)
+	{
+	case Vitruvio::EPRTPixelFormat::GREY8:
+		return &ConvertRowGrey8ToBGRA8;
+	case Vitruvio::EPRTPixelFormat::GREY16:
+		return &ConvertRowGrey16ToRGBA16;
+	case Vitruvio::EPRTPixelFormat::RGB8:
+		return &ConvertRowRGB8ToBGRA8;
+	case Vitruvio::EPRTPixelFormat::RGBA8:
+		return &ConvertRowRGBA8ToBGRA8;
+	case Vitruvio::EPRTPixelFormat::FLOAT32:
+		return &ConvertRowFloat32ToFloatRGBA;
+	default:
+		return nullptr;
+	}
+}
 } // namespace
 
 namespace Vitruvio
@@ -95,6 +369,13 @@ FTextureMetadata ParseTextureMetadata(const prt::AttributeMap* TextureMetadata)
 	return Result;
 }
 
+void ConvertTextureRow(EPRTPixelFormat PixelFormat, const uint8* Src, uint8* Dst, int32 Width)
+{
+	const FRowConverter ConvertRow = GetRowConverter(PixelFormat);
+	check(ConvertRow);
+	ConvertRow(Src, Dst, Width);
+}
+
 EPixelFormat GetUnrealPixelFormat(EPRTPixelFormat PRTPixelFormat)
 {
 	switch (PRTPixelFormat)
@@ -121,53 +402,85 @@ EPixelFormat GetUnrealPixelFormat(EPRTPixelFormat PRTPixelFormat)
 }
 
 FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Path, const FTextureMetadata& TextureMetadata,
-						   std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize)
+						   std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize, int32 MaxResolution,
+						   TFunctionRef<TOptional<FTextureData>(uint64 ContentHash)> FindDecodedTexture)
 {
 	EPixelFormat UnrealPixelFormat = GetUnrealPixelFormat(TextureMetadata.PixelFormat);
 	check(UnrealPixelFormat != EPixelFormat::PF_Unknown);
 
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_Vitruvio_DecodeTexture);
+
 	const size_t BytesPerBand = FMath::Min<size_t>(2, TextureMetadata.BytesPerBand);
-	const bool bIsColor = (TextureMetadata.Bands >= 3);
 
 	size_t NewBufferSize = TextureMetadata.Width * TextureMetadata.Height * 4 * BytesPerBand;
 	auto NewBuffer = std::make_unique<uint8_t[]>(NewBufferSize);
 
-	for (int Y = 0; Y < TextureMetadata.Height; ++Y)
+	const FRowConverter ConvertRow = GetRowConverter(TextureMetadata.PixelFormat);
+	check(ConvertRow);
+
+	// PRT images are stored bottom up, flip them by converting whole rows in reverse order
+	const size_t SrcRowSize = TextureMetadata.Width * TextureMetadata.Bands * TextureMetadata.BytesPerBand;
+	const size_t DstRowSize = TextureMetadata.Width * 4 * BytesPerBand;
+	check(SrcRowSize * TextureMetadata.Height <= BufferSize);
+	int32 SizeX = static_cast<int32>(TextureMetadata.Width);
+	int32 SizeY = static_cast<int32>(TextureMetadata.Height);
+	const bool bDownsample = MaxResolution > 0 && (SizeX > MaxResolution || SizeY > MaxResolution);
+	// Only opacity maps are used to choose a blend mode, other textures skip the histogram (65536 bins for 16 bit textures)
+	TOptional<FOpacityHistogram> OpacityHistogram;
+	if (Key == TEXT("opacityMap"))
 	{
-		for (int X = 0; X < TextureMetadata.Width; ++X)
+		OpacityHistogram.Emplace(TextureMetadata);
+	}
+	for (size_t Y = 0; Y < TextureMetadata.Height; ++Y)
+	{
+		const uint8* SrcRow = Buffer.get() + (TextureMetadata.Height - Y - 1) * SrcRowSize;
+		uint8* DstRow = NewBuffer.get() + Y * DstRowSize;
+		ConvertRow(SrcRow, DstRow, SizeX);
+		if (OpacityHistogram && !bDownsample)
 		{
-			if (TextureMetadata.PixelFormat == EPRTPixelFormat::FLOAT32)
-			{
-				// Convert 32 bit grayscale float textures to 16 bit RGBA float textures
-				const int OldOffset = ((TextureMetadata.Height - Y - 1) * TextureMetadata.Width + X) * TextureMetadata.Bands;
-				const int NewOffset = (Y * TextureMetadata.Width + X);
-				const float* FloatBuffer = reinterpret_cast<const float*>(Buffer.get());
-				FFloat16Color* NewFloat16Buffer = reinterpret_cast<FFloat16Color*>(NewBuffer.get());
-				const float Float32Value = FloatBuffer[OldOffset];
-				const FFloat16 Float16Value(Float32Value);
-				FFloat16Color Color;
-				Color.R = Float16Value;
-				Color.G = Float16Value;
-				Color.B = Float16Value;
-				Color.A = FFloat16(1.0f);
-				NewFloat16Buffer[NewOffset] = Color;
-			}
-			else
-			{
-				// Workaround: Also convert grayscale images to rgba, since texture params don't automatically update their sample method
-				const int OldOffset = ((TextureMetadata.Height - Y - 1) * TextureMetadata.Width + X) * TextureMetadata.Bands * BytesPerBand;
-				const int NewOffset = (Y * TextureMetadata.Width + X) * 4 * BytesPerBand;
-				for (int B = 0; B < BytesPerBand; ++B)
-				{
-					NewBuffer[NewOffset + 0 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 2 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 1 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 1 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 2 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 0 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 3 * BytesPerBand + B] = (TextureMetadata.Bands == 4) ? Buffer[OldOffset + 3 + B] : 0;
-				}
-			}
+			OpacityHistogram->AddRow(DstRow, SizeX);
+		}
+	}
+	Buffer.reset();
+
+	// Oversized textures are downsampled to the maximum resolution, the opacity is counted on the downsampled pixels the texture ends up with
+	TArray64<uint8> Downsampled;
+	const uint8* Pixels = NewBuffer.get();
+	size_t PixelsSize = NewBufferSize;
+	if (bDownsample)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_Vitruvio_DownsampleTexture);
+		Downsampled = DownsampleToMaxSize(NewBuffer.get(), SizeX, SizeY, MaxResolution, UnrealPixelFormat);
+		NewBuffer.reset();
+		Pixels = Downsampled.GetData();
+		PixelsSize = Downsampled.Num();
+
+		const size_t DownsampledRowSize = SizeX * 4 * BytesPerBand;
+		for (int32 Y = 0; OpacityHistogram && Y < SizeY; ++Y)
+		{
+			OpacityHistogram->AddRow(Pixels + Y * DownsampledRowSize, SizeX);
 		}
 	}
 
+	// The key determines the texture settings, the same pixels used for different maps result in different textures
+	FXxHash64Builder ContentHashBuilder;
+	ContentHashBuilder.Update(Pixels, PixelsSize);
+	ContentHashBuilder.Update(&SizeX, sizeof(SizeX));
+	ContentHashBuilder.Update(&SizeY, sizeof(SizeY));
+	ContentHashBuilder.Update(&TextureMetadata.Bands, sizeof(TextureMetadata.Bands));
+	ContentHashBuilder.Update(&UnrealPixelFormat, sizeof(UnrealPixelFormat));
+	ContentHashBuilder.Update(*Key, Key.Len() * sizeof(TCHAR));
+
+	const uint64 ContentHash = ContentHashBuilder.Finalize().Hash;
+	const FDateTime LoadTime = FPlatformFileManager::Get().GetPlatformFile().GetTimeStamp(*Path);
+
+	// Identical pixels from another file share the texture which has already been created for them
+	if (TOptional<FTextureData> DecodedTexture = FindDecodedTexture(ContentHash))
+	{
+		DecodedTexture->LoadTime = LoadTime;
+		return *DecodedTexture;
+	}
+
 	const FTextureSettings Settings = GetTextureSettings(Key, UnrealPixelFormat);
 
 	const FString TextureBaseName = TEXT("T_") + FPaths::GetBaseFilename(Path);
@@ -176,27 +489,60 @@ FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Pa
 	NewTexture->CompressionSettings = Settings.Compression;
 	NewTexture->SRGB = Settings.SRGB;
 
+	// Mips and block compression are optional and built here on the loading worker thread
+	const FTextureCompressionSettings CompressionSettings = GetTextureCompressionSettings();
+	const TArray<FTextureMipData> Mips =
+		CompressionSettings.bGenerateMips ? GenerateMips(Pixels, SizeX, SizeY, UnrealPixelFormat) : TArray<FTextureMipData>();
+	const EPixelFormat CompressedPixelFormat =
+		CompressionSettings.bCompress ? GetCompressedPixelFormat(Key, UnrealPixelFormat, TextureMetadata.Bands, SizeX, SizeY) : PF_Unknown;
+	const EPixelFormat PlatformPixelFormat = CompressedPixelFormat != PF_Unknown ? CompressedPixelFormat : UnrealPixelFormat;
+
 	FTexturePlatformData* PlatformData = new FTexturePlatformData();
-	PlatformData = new FTexturePlatformData();
-	PlatformData->SizeX = TextureMetadata.Width;
-	PlatformData->SizeY = TextureMetadata.Height;
-	PlatformData->PixelFormat = UnrealPixelFormat;
-
-	// Allocate first mipmap and upload the pixel data
-	FTexture2DMipMap* Mip = new FTexture2DMipMap();
-	PlatformData->Mips.Add(Mip);
-	Mip->SizeX = TextureMetadata.Width;
-	Mip->SizeY = TextureMetadata.Height;
-	Mip->BulkData.Lock(LOCK_READ_WRITE);
-	void* TextureData = Mip->BulkData.Realloc(CalculateImageBytes(TextureMetadata.Width, TextureMetadata.Height, 0, UnrealPixelFormat));
-	FMemory::Memcpy(TextureData, NewBuffer.get(), NewBufferSize);
-	Mip->BulkData.Unlock();
+	PlatformData->SizeX = SizeX;
+	PlatformData->SizeY = SizeY;
+	PlatformData->PixelFormat = PlatformPixelFormat;
+
+	// Allocate the mipmaps and upload the pixel data
+	auto AddMip = [PlatformData, CompressedPixelFormat, PlatformPixelFormat](const uint8* Pixels, int32 MipSizeX, int32 MipSizeY)
+	{
+		FTexture2DMipMap* Mip = new FTexture2DMipMap();
+		PlatformData->Mips.Add(Mip);
+		Mip->SizeX = MipSizeX;
+		Mip->SizeY = MipSizeY;
+
+		TArray64<uint8> Blocks;
+		if (CompressedPixelFormat != PF_Unknown)
+		{
+			Blocks = CompressBlocks(Pixels, MipSizeX, MipSizeY, CompressedPixelFormat);
+			Pixels = Blocks.GetData();
+		}
+
+		const SIZE_T MipBytes = CalculateImageBytes(MipSizeX, MipSizeY, 0, PlatformPixelFormat);
+		Mip->BulkData.Lock(LOCK_READ_WRITE);
+		void* TextureData = Mip->BulkData.Realloc(MipBytes);
+		FMemory::Memcpy(TextureData, Pixels, MipBytes);
+		Mip->BulkData.Unlock();
+	};
 
+	AddMip(Pixels, SizeX, SizeY);
+	for (const FTextureMipData& MipData : Mips)
+	{
+		AddMip(MipData.Data.GetData(), MipData.SizeX, MipData.SizeY);
+	}
+
+	// There is no bulk data on disk to stream from, all mips stay resident
+	NewTexture->NeverStream = true;
 	NewTexture->SetPlatformData(PlatformData);
 
 	NewTexture->UpdateResource();
 
-	const auto TimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*Path);
-	return FTextureData { NewTexture, static_cast<uint32>(TextureMetadata.Bands), TimeStamp };
+	FTextureData TextureData {NewTexture, static_cast<uint32>(TextureMetadata.Bands)};
+	TextureData.LoadTime = LoadTime;
+	TextureData.ContentHash = ContentHash;
+	if (OpacityHistogram)
+	{
+		OpacityHistogram->Count(TextureData.OpacityBlackPixels, TextureData.OpacityWhitePixels);
+	}
+	return TextureData;
 }
 } // namespace Vitruvio
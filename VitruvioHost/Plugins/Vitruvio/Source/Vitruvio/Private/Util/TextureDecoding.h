@@ -44,9 +44,30 @@ struct FTextureMetadata
 	EPRTPixelFormat PixelFormat = EPRTPixelFormat::Unknown;
 };
 
+/** Pixels of a texture as provided by PRT, stored bottom up. */
+struct FTexturePixels
+{
+	FTextureMetadata Metadata;
+	std::unique_ptr<uint8_t[]> Buffer;
+	size_t BufferSize = 0;
+};
+
 VITRUVIO_API FTextureMetadata ParseTextureMetadata(const prt::AttributeMap* TextureMetadata);
 
+/**
+ * Converts one row of Width PRT pixels to the Unreal pixel format DecodeTexture creates for them (BGRA8, RGBA16 or FloatRGBA).
+ * Uses the vectorized row kernels where the platform has them.
+ */
+void ConvertTextureRow(EPRTPixelFormat PixelFormat, const uint8* Src, uint8* Dst, int32 Width);
+
+/**
+ * Converts the given PRT pixels to a texture. Textures larger than MaxResolution (if not 0) are downsampled.
+ *
+ * @param FindDecodedTexture returns an already decoded texture with the given content hash, which is returned instead of creating a new
+ * texture for the same pixels.
+ */
 VITRUVIO_API FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Path, const FTextureMetadata& TextureMetadata,
-										std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize);
+										std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize, int32 MaxResolution,
+										TFunctionRef<TOptional<FTextureData>(uint64 ContentHash)> FindDecodedTexture);
 
 } // namespace Vitruvio
@@ -77,20 +77,29 @@ TTuple<TArray<FInitialShape>, TArray<UVitruvioComponent*>> UTile::GetInitialShap
 	return MakeTuple(MoveTemp(InitialShapes), ValidVitruvioComponents);
 }
 
+void FGrid::MarkForGenerate(UTile* Tile, UVitruvioComponent* VitruvioComponent, UGenerateCompletedCallbackProxy* CallbackProxy)
+{
+	Tile->MarkForGenerate(VitruvioComponent, CallbackProxy);
+	DirtyTiles.Add(Tile);
+}
+
 void FGrid::MarkForGenerate(UVitruvioComponent* VitruvioComponent, UGenerateCompletedCallbackProxy* CallbackProxy)
 {
 	if (UTile** FoundTile = TilesByComponent.Find(VitruvioComponent))
 	{
-		UTile* Tile = *FoundTile;
-		Tile->MarkForGenerate(VitruvioComponent, CallbackProxy);
+		MarkForGenerate(*FoundTile, VitruvioComponent, CallbackProxy);
 	}
 }
 
 void FGrid::MarkAllForGenerate()
 {
-	for (const auto& [Component, Tile] : TilesByComponent)
+	for (const auto& [Point, Tile] : Tiles)
 	{
-		Tile->MarkForGenerate(Component);
+		if (!Tile->VitruvioComponents.IsEmpty())
+		{
+			Tile->bMarkedForGenerate = true;
+			DirtyTiles.Add(Tile);
+		}
 	}
 }
 
@@ -118,20 +127,27 @@ void FGrid::Register(UVitruvioComponent* VitruvioComponent, AVitruvioBatchActor*
 		Tiles.Add(Position, Tile);
 	}
 
+	// A component which has moved to another tile is removed from its previous one
+	UTile*& ComponentTile = TilesByComponent.FindOrAdd(VitruvioComponent);
+	if (ComponentTile && ComponentTile != Tile)
+	{
+		ComponentTile->Remove(VitruvioComponent);
+		MarkForGenerate(ComponentTile, VitruvioComponent);
+	}
+	ComponentTile = Tile;
+
 	if (!Tile->Contains(VitruvioComponent))
 	{
 		Tile->Add(VitruvioComponent);
-		Tile->MarkForGenerate(VitruvioComponent);
-		TilesByComponent.Add(VitruvioComponent, Tile);
+		MarkForGenerate(Tile, VitruvioComponent);
 	}
 }
 
 void FGrid::Unregister(UVitruvioComponent* VitruvioComponent)
 {
-	if (UTile** FoundTile = TilesByComponent.Find(VitruvioComponent))
+	UTile* Tile;
+	if (TilesByComponent.RemoveAndCopyValue(VitruvioComponent, Tile))
 	{
-		UTile* Tile = *FoundTile;
-
 		if (Tile->GenerateToken)
 		{
 			Tile->GenerateToken->Invalidate();
@@ -139,14 +155,21 @@ void FGrid::Unregister(UVitruvioComponent* VitruvioComponent)
 		}
 		
 		Tile->Remove(VitruvioComponent);
-		Tile->MarkForGenerate(VitruvioComponent);
+		MarkForGenerate(Tile, VitruvioComponent);
 	}
 }
 
 void FGrid::Clear()
 {
-	for (auto& [VitruvioComponent, Tile] : TilesByComponent)
+	for (auto& [Point, Tile] : Tiles)
 	{
+		// Results of generates which are still running or waiting to be applied belong to the cleared tiles
+		if (Tile->GenerateToken)
+		{
+			Tile->GenerateToken->Invalidate();
+			Tile->GenerateToken.Reset();
+		}
+
 		if (Tile->GeneratedModelComponent && IsValid(Tile->GeneratedModelComponent))
 		{
 			TArray<USceneComponent*> InstanceSceneComponents;
@@ -162,28 +185,40 @@ void FGrid::Clear()
 
 	TilesByComponent.Reset();
 	Tiles.Reset();
+	DirtyTiles.Reset();
+	GeneratingTiles.Reset();
 }
 
 TArray<UTile*> FGrid::GetTilesMarkedForGenerate() const
 {
-	TArray<UTile*> TilesToGenerate;
-	for (auto& [Point, Tile] : Tiles)
-	{
-		if (Tile->bMarkedForGenerate)
-		{
-			TilesToGenerate.Add(Tile);
-		}
-	}
-
-	return TilesToGenerate;
+	return DirtyTiles.Array();
 }
 
 void FGrid::UnmarkForGenerate()
 {
-	for (auto& [Point, Tile] : Tiles)
+	for (UTile* Tile : DirtyTiles)
 	{
 		Tile->UnmarkForGenerate();
 	}
+	DirtyTiles.Reset();
+}
+
+void FGrid::SetGenerating(UTile* Tile, bool bIsGenerating)
+{
+	Tile->bIsGenerating = bIsGenerating;
+	if (bIsGenerating)
+	{
+		GeneratingTiles.Add(Tile);
+	}
+	else
+	{
+		GeneratingTiles.Remove(Tile);
+	}
+}
+
+bool FGrid::IsGenerating() const
+{
+	return !GeneratingTiles.IsEmpty();
 }
 
 AVitruvioBatchActor::AVitruvioBatchActor()
@@ -218,11 +253,18 @@ void AVitruvioBatchActor::ProcessTiles()
 {
 	for (UTile* Tile : Grid.GetTilesMarkedForGenerate())
 	{
+		// A result of the tile which is still being applied is outdated, its model is regenerated below
+		if (PendingGenerateResult.IsSet() && PendingGenerateResult->Item.Tile == Tile)
+		{
+			CancelPendingGenerateResult();
+		}
+
 		// Initialize and cleanup the model component
 		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = Tile->GeneratedModelComponent;
 		if (VitruvioModelComponent)
 		{
 			VitruvioModelComponent->SetStaticMesh(nullptr);
+			VitruvioModelComponent->SetMaterialReferences({});
 
 			// Cleanup old hierarchical instances
 			TArray<USceneComponent*> InstanceSceneComponents;
@@ -258,10 +300,11 @@ void AVitruvioBatchActor::ProcessTiles()
 			FBatchGenerateResult GenerateResult = VitruvioModule::Get().BatchGenerateAsync(MoveTemp(InitialShapes));
 			
 			Tile->GenerateToken = GenerateResult.Token;
-			Tile->bIsGenerating = true;
+			Grid.SetGenerating(Tile, true);
 		
+			const TWeakObjectPtr<UTile> WeakTile = Tile;
 			// clang-format off
-			GenerateResult.Result.Next([this, Tile, InitialShapeVitruvioComponents](const FBatchGenerateResult::ResultType& Result)
+			GenerateResult.Result.Next([this, WeakTile, InitialShapeVitruvioComponents](FBatchGenerateResult::ResultType Result)
 			{
 				FScopeLock Lock(&Result.Token->Lock);
 
@@ -270,13 +313,22 @@ void AVitruvioBatchActor::ProcessTiles()
 					return;
 				}
 
-				Tile->GenerateToken.Reset();
-
+				// The tile keeps its token until the result is applied, so that regenerating or clearing the tile drops the queued result
 				FScopeLock GenerateQueueLock(&ProcessQueueCriticalSection);
-				GenerateQueue.Enqueue({Result.Value, Tile, InitialShapeVitruvioComponents});
+				GenerateQueue.Enqueue({MoveTemp(Result.Value), WeakTile, Result.Token, InitialShapeVitruvioComponents});
 			});
 			// clang-format on
 		}
+		else
+		{
+			// A tile without any generatable components has nothing left to generate, its model has been cleared above
+			if (Tile->GenerateToken)
+			{
+				Tile->GenerateToken->Invalidate();
+				Tile->GenerateToken.Reset();
+			}
+			Grid.SetGenerating(Tile, false);
+		}
 	}
 
 	Grid.UnmarkForGenerate();
@@ -284,31 +336,77 @@ void AVitruvioBatchActor::ProcessTiles()
 
 void AVitruvioBatchActor::ProcessGenerateQueue()
 {
-	ProcessQueueCriticalSection.Lock();
-	
-	if (!GenerateQueue.IsEmpty())
+	// Results are applied one after another by the apply scheduler
+	if (!PendingGenerateResult.IsSet())
 	{
 		FBatchGenerateQueueItem Item;
-		GenerateQueue.Dequeue(Item);
 
+		ProcessQueueCriticalSection.Lock();
+		bool bDequeued = GenerateQueue.Dequeue(Item);
+		while (bDequeued && (Item.Token->IsInvalid() || !Item.Tile.IsValid()))
+		{
+			bDequeued = GenerateQueue.Dequeue(Item);
+		}
 		ProcessQueueCriticalSection.Unlock();
 
-		for (int ComponentIndex = 0; ComponentIndex < Item.VitruvioComponents.Num(); ++ComponentIndex)
+		if (bDequeued)
 		{
-			UVitruvioComponent* VitruvioComponent = Item.VitruvioComponents[ComponentIndex];
-			Item.GenerateResultDescription.EvaluatedAttributes[ComponentIndex]->UpdateUnrealAttributeMap(VitruvioComponent->Attributes, VitruvioComponent);
-			VitruvioComponent->NotifyAttributesChanged();
+			for (int ComponentIndex = 0; ComponentIndex < Item.VitruvioComponents.Num(); ++ComponentIndex)
+			{
+				UVitruvioComponent* VitruvioComponent = Item.VitruvioComponents[ComponentIndex];
+				Item.GenerateResultDescription.EvaluatedAttributes[ComponentIndex]->UpdateUnrealAttributeMap(VitruvioComponent->Attributes, VitruvioComponent);
+				VitruvioComponent->NotifyAttributesChanged();
+			}
+
+			PendingGenerateResult = FPendingBatchGenerateResult {MoveTemp(Item)};
+			VitruvioModule::Get().GetApplyScheduler().Schedule(this, [this]() { return ApplyGenerateResultStep(); });
 		}
+	}
 
-		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = Item.Tile->GeneratedModelComponent;
+	if (GenerateAllCallbackProxy)
+	{
+		if (!Grid.IsGenerating())
+		{
+			GenerateAllCallbackProxy->OnGenerateCompleted.Broadcast();
+			GenerateAllCallbackProxy = nullptr;
+		}
+	}
+}
 
-		const FConvertedGenerateResult ConvertedResult = BuildGenerateResult(Item.GenerateResultDescription,
-	VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(),
-				MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld());
+EApplyStepResult AVitruvioBatchActor::ApplyGenerateResultStep()
+{
+	if (!PendingGenerateResult.IsSet())
+	{
+		return EApplyStepResult::Done;
+	}
+
+	FBatchGenerateQueueItem& Item = PendingGenerateResult->Item;
+	FApplyGenerateResultState& State = PendingGenerateResult->State;
+	const FConvertedGenerateResult& ConvertedResult = State.ConvertedResult;
+
+	// The tile has been generated again or cleared since, its callbacks belong to the newer generate
+	UTile* Tile = Item.Tile.Get();
+	if (!Tile || Item.Token->IsInvalid())
+	{
+		PendingGenerateResult.Reset();
+		return EApplyStepResult::Done;
+	}
+
+	if (State.Stage < EApplyGenerateResultStage::UpdateComponents)
+	{
+		return BuildGenerateResultStep(Item.GenerateResultDescription, State, VitruvioModule::Get().GetMaterialCache(),
+									   VitruvioModule::Get().GetTextureCache(), MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent,
+									   MaskedParent, TranslucentParent, GetWorld());
+	}
+
+	if (State.Stage == EApplyGenerateResultStage::UpdateComponents)
+	{
+		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = Tile->GeneratedModelComponent;
 
 		if (ConvertedResult.ShapeMesh)
 		{
 			VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
+			VitruvioModelComponent->SetMaterialReferences(ConvertedResult.ShapeMesh->GetMaterialReferences());
 			
 			// Reset Material replacements
 			for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
@@ -327,68 +425,91 @@ void AVitruvioBatchActor::ProcessGenerateQueue()
 			InstanceComponent->DestroyComponent(true);
 		}
 
-		TMap<FString, int32> NameMap;
-		TSet<FInstance> Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, NameMap);
-		for (const FInstance& Instance : ConvertedResult.Instances)
-		{
-			if (Replaced.Contains(Instance))
-			{
-				continue;
-			}
-
-			FString UniqueName = UniqueComponentName(Instance.Name, NameMap);
-			auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, FName(UniqueName),
-																			  RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-			const TArray<FTransform>& Transforms = Instance.Transforms;
-			InstancedComponent->SetStaticMesh(Instance.InstanceMesh->GetStaticMesh());
-			InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
-			
-			// Add all instance transforms
-			for (const FTransform& Transform : Transforms)
-			{
-				InstancedComponent->AddInstance(Transform);
-			}
+		State.Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, State.NameMap);
 
-			// Apply override materials
-			for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
-			{
-				InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
-			}
+		State.ModelComponent = VitruvioModelComponent;
+		State.StepIndex = 0;
+		State.Stage = EApplyGenerateResultStage::AddInstances;
+		return EApplyStepResult::Progress;
+	}
 
-			// Attach and register instance component
-			InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
-			InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
-			RootComponent->GetOwner()->AddOwnedComponent(InstancedComponent);
-			InstancedComponent->OnComponentCreated();
-			InstancedComponent->RegisterComponent();
+	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = State.ModelComponent.Get();
+	if (VitruvioModelComponent && State.StepIndex < ConvertedResult.Instances.Num())
+	{
+		const FInstance& Instance = ConvertedResult.Instances[State.StepIndex++];
+		if (State.Replaced.Contains(Instance))
+		{
+			return EApplyStepResult::Progress;
 		}
 
-		for (auto& [VitruvioComponent, CallbackProxy] : Item.Tile->CallbackProxies)
+		FString UniqueName = UniqueComponentName(Instance.Name, State.NameMap);
+		auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, FName(UniqueName),
+																		  RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
+		InstancedComponent->SetStaticMesh(Instance.InstanceMesh->GetStaticMesh());
+		InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
+		
+		// Add all instance transforms
+		InstancedComponent->AddInstancesWithCustomData(Instance.Transforms, Instance.CustomData, Instance.NumCustomDataFloats);
+
+		// Apply override materials
+		for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
 		{
-			CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
-			CallbackProxy->OnGenerateCompleted.Broadcast();
-			CallbackProxy->SetReadyToDestroy();
+			InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
 		}
 
-		Item.Tile->CallbackProxies.Empty();
-		Item.Tile->bIsGenerating = false;
+		// Keep the cached materials of the instance mesh and its overrides alive while the component uses them
+		TArray<FMaterialReferencePtr> MaterialReferences = Instance.InstanceMesh->GetMaterialReferences();
+		MaterialReferences.Append(Instance.OverrideMaterialReferences);
+		InstancedComponent->SetMaterialReferences(MoveTemp(MaterialReferences));
+
+		// Attach and register instance component
+		InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
+		InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
+		RootComponent->GetOwner()->AddOwnedComponent(InstancedComponent);
+		InstancedComponent->OnComponentCreated();
+		InstancedComponent->RegisterComponent();
+
+		return EApplyStepResult::Progress;
 	}
-	else
+
+	for (auto& [VitruvioComponent, CallbackProxy] : Tile->CallbackProxies)
 	{
-		ProcessQueueCriticalSection.Unlock();
+		CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
+		CallbackProxy->OnGenerateCompleted.Broadcast();
+		CallbackProxy->SetReadyToDestroy();
 	}
 
-	if (GenerateAllCallbackProxy)
+	Tile->CallbackProxies.Empty();
+	if (Tile->GenerateToken == Item.Token)
 	{
-		TArray<UTile*> Tiles;
-		Grid.Tiles.GenerateValueArray(Tiles);
-		bool bAllGenerated = Algo::NoneOf(Tiles, [](const UTile* Tile) { return Tile->bIsGenerating; });
-		if (bAllGenerated)
-		{
-			GenerateAllCallbackProxy->OnGenerateCompleted.Broadcast();
-			GenerateAllCallbackProxy = nullptr;
-		}
+		Tile->GenerateToken.Reset();
 	}
+	Grid.SetGenerating(Tile, false);
+
+	PendingGenerateResult.Reset();
+
+	return EApplyStepResult::Done;
+}
+
+void AVitruvioBatchActor::CancelPendingGenerateResult()
+{
+	if (PendingGenerateResult.IsSet())
+	{
+		PendingGenerateResult.Reset();
+		VitruvioModule::Get().GetApplyScheduler().Cancel(this);
+	}
+}
+
+void AVitruvioBatchActor::ClearGrid()
+{
+	// Clearing the grid invalidates the tokens of its tiles, nothing of the previous grid is applied anymore
+	CancelPendingGenerateResult();
+
+	ProcessQueueCriticalSection.Lock();
+	GenerateQueue.Empty();
+	ProcessQueueCriticalSection.Unlock();
+
+	Grid.Clear();
 }
 
 void AVitruvioBatchActor::Tick(float DeltaSeconds)
@@ -411,7 +532,7 @@ void AVitruvioBatchActor::UnregisterVitruvioComponent(UVitruvioComponent* Vitruv
 
 void AVitruvioBatchActor::UnregisterAllVitruvioComponents()
 {
-	Grid.Clear();
+	ClearGrid();
 	VitruvioComponents.Empty();
 }
 
@@ -461,7 +582,7 @@ void AVitruvioBatchActor::PostEditChangeProperty(FPropertyChangedEvent& Property
 	if (PropertyChangedEvent.MemberProperty &&
 		PropertyChangedEvent.MemberProperty->GetFName() == GET_MEMBER_NAME_CHECKED(AVitruvioBatchActor, GridDimension))
 	{
-		Grid.Clear();
+		ClearGrid();
 		Grid.RegisterAll(VitruvioComponents, this);
 	}
 
@@ -424,50 +424,108 @@ TSet<FInstance> ApplyInstanceReplacements(UGeneratedModelStaticMeshComponent* Ge
 	return Replaced;
 }
 
-FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
-									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-									 TMap<FString, Vitruvio::FTextureData>& TextureCache,
-									 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
-									 TMap<FString, int32>& UniqueMaterialIdentifiers,
-									 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-									 UWorld* World)
+EApplyStepResult BuildGenerateResultStep(FGenerateResultDescription& GenerateResult, FApplyGenerateResultState& State,
+										 FMaterialCache& MaterialCache,
+										 FTextureCache& TextureCache,
+										 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+										 TMap<FString, int32>& UniqueMaterialIdentifiers,
+										 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+										 UWorld* World)
 {
-	MaterialIdentifiers.Empty();
-	UniqueMaterialIdentifiers.Empty();
+	FConvertedGenerateResult& ConvertedResult = State.ConvertedResult;
 
-	// Build all meshes
-	if (GenerateResult.GeneratedModel)
+	switch (State.Stage)
 	{
-		GenerateResult.GeneratedModel->Build(TEXT("GeneratedModel"), MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers,
-			OpaqueParent, MaskedParent, TranslucentParent, World);
+	case EApplyGenerateResultStage::BuildShapeMesh:
+	{
+		// Materials of components destroyed since the last result are not referenced anymore
+		MaterialCache.EvictUnreferenced();
+
+		MaterialIdentifiers.Empty();
+		UniqueMaterialIdentifiers.Empty();
+
+		if (GenerateResult.GeneratedModel)
+		{
+			GenerateResult.GeneratedModel->Build(TEXT("GeneratedModel"), MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers,
+				OpaqueParent, MaskedParent, TranslucentParent, World);
+		}
+
+		ConvertedResult.ShapeMesh = GenerateResult.GeneratedModel;
+		ConvertedResult.Reports = MoveTemp(GenerateResult.Reports);
+
+		GenerateResult.InstanceMeshes.GenerateKeyArray(State.InstanceMeshIds);
+		State.Stage = EApplyGenerateResultStage::BuildInstanceMeshes;
+		return EApplyStepResult::Progress;
 	}
 
-	for (const auto& IdAndMesh : GenerateResult.InstanceMeshes)
+	case EApplyGenerateResultStage::BuildInstanceMeshes:
 	{
-		FString Name = GenerateResult.InstanceNames[IdAndMesh.Key];
-		IdAndMesh.Value->Build(Name, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers,
-			OpaqueParent, MaskedParent, TranslucentParent, World);
+		if (State.StepIndex < State.InstanceMeshIds.Num())
+		{
+			const FString& MeshId = State.InstanceMeshIds[State.StepIndex++];
+			GenerateResult.InstanceMeshes[MeshId]->Build(GenerateResult.InstanceNames[MeshId], MaterialCache, TextureCache, MaterialIdentifiers,
+				UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, World);
+			return EApplyStepResult::Progress;
+		}
+
+		GenerateResult.Instances.GenerateKeyArray(State.InstanceKeys);
+		State.StepIndex = 0;
+		State.Stage = EApplyGenerateResultStage::ConvertInstances;
+		return EApplyStepResult::Progress;
 	}
 
-	// Convert instances
-	TArray<FInstance> Instances;
-	for (const auto& [Key, Transform] : GenerateResult.Instances)
+	case EApplyGenerateResultStage::ConvertInstances:
 	{
-		const TSharedPtr<FVitruvioMesh>& VitruvioMesh = GenerateResult.InstanceMeshes[Key.MeshId];
-		const FString MeshName = GenerateResult.InstanceNames[Key.MeshId];
-		TArray<UMaterialInstanceDynamic*> OverrideMaterials;
+		if (State.StepIndex < State.InstanceKeys.Num())
+		{
+			const Vitruvio::FInstanceCacheKey& Key = State.InstanceKeys[State.StepIndex++];
+			const TSharedPtr<FVitruvioMesh>& VitruvioMesh = GenerateResult.InstanceMeshes[Key.MeshId];
+			const FString MeshName = GenerateResult.InstanceNames[Key.MeshId];
+			TArray<UMaterialInstanceDynamic*> OverrideMaterials;
+			TArray<FMaterialReferencePtr> OverrideMaterialReferences;
+
+			// The cache entries of the created materials keep the interned materials alive from now on (see FMaterialCache::Add)
+			Vitruvio::FInstanceData& InstanceData = GenerateResult.Instances[Key];
+			check(InstanceData.MaterialOverrides.Num() == Key.MaterialOverrides.Num());
+			for (const TSharedRef<const Vitruvio::FMaterialAttributeContainer>& MaterialContainer : InstanceData.MaterialOverrides)
+			{
+				FMaterialReferencePtr& MaterialReference = OverrideMaterialReferences.AddDefaulted_GetRef();
+				OverrideMaterials.Add(CacheMaterial(OpaqueParent, MaskedParent, TranslucentParent, TextureCache, MaterialCache, *MaterialContainer,
+													UniqueMaterialIdentifiers, MaterialIdentifiers, VitruvioMesh->GetStaticMesh(), MaterialReference));
+			}
+			InstanceData.MaterialOverrides.Empty();
+
+			ConvertedResult.Instances.Add({MeshName, VitruvioMesh, MoveTemp(OverrideMaterials), MoveTemp(InstanceData.Transforms),
+										   MoveTemp(InstanceData.CustomData), InstanceData.NumCustomDataFloats, MoveTemp(OverrideMaterialReferences)});
+			return EApplyStepResult::Progress;
+		}
 
-		for (size_t MaterialIndex = 0; MaterialIndex < Key.MaterialOverrides.Num(); ++MaterialIndex)
+		State.StepIndex = 0;
+		State.Stage = EApplyGenerateResultStage::FinishMeshes;
+		return EApplyStepResult::Progress;
+	}
+
+	case EApplyGenerateResultStage::FinishMeshes:
+	{
+		// Meshes are built asynchronously, only continue once all of them can be assigned to components
+		bool bFinished = !GenerateResult.GeneratedModel || GenerateResult.GeneratedModel->FinishBuild();
+		for (const auto& [MeshId, VitruvioMesh] : GenerateResult.InstanceMeshes)
 		{
-			const Vitruvio::FMaterialAttributeContainer& MaterialContainer = Key.MaterialOverrides[MaterialIndex];
-			OverrideMaterials.Add(CacheMaterial(OpaqueParent, MaskedParent, TranslucentParent, TextureCache, MaterialCache, MaterialContainer,
-												UniqueMaterialIdentifiers, MaterialIdentifiers, VitruvioMesh->GetStaticMesh()));
+			bFinished &= VitruvioMesh->FinishBuild();
 		}
 
-		Instances.Add({MeshName, VitruvioMesh, OverrideMaterials, Transform});
+		if (!bFinished)
+		{
+			return EApplyStepResult::Wait;
+		}
+
+		State.Stage = EApplyGenerateResultStage::UpdateComponents;
+		return EApplyStepResult::Progress;
 	}
 
-	return {GenerateResult.GeneratedModel, Instances, GenerateResult.Reports};
+	default:
+		return EApplyStepResult::Progress;
+	}
 }
 
 FString UniqueComponentName(const FString& Name, TMap<FString, int32>& UsedNames)
@@ -772,7 +830,7 @@ void UVitruvioComponent::Initialize()
 
 void UVitruvioComponent::ProcessGenerateQueue()
 {
-	if (GenerateQueue.IsEmpty())
+	if (GenerateQueue.IsEmpty() && !PendingGenerateResult.IsSet())
 	{
 		return;
 	}
@@ -781,107 +839,138 @@ void UVitruvioComponent::ProcessGenerateQueue()
 	{
 		RemoveGeneratedMeshes();
 		GenerateQueue.Empty();
+		PendingGenerateResult.Reset();
+		VitruvioModule::Get().GetApplyScheduler().Cancel(this);
 		return;
 	}
-		
-	// Get from queue and build meshes
-	FGenerateQueueItem Result;
-	GenerateQueue.Dequeue(Result);
 
-	FConvertedGenerateResult ConvertedResult = BuildGenerateResult(Result.GenerateResultDescription,
-VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(),
-			MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld());
+	// Results are applied one after another by the apply scheduler
+	if (PendingGenerateResult.IsSet())
+	{
+		return;
+	}
 
-	Reports = ConvertedResult.Reports;
+	FGenerateQueueItem Item;
+	GenerateQueue.Dequeue(Item);
+	PendingGenerateResult = FPendingGenerateResult {MoveTemp(Item)};
 
-	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
+	VitruvioModule::Get().GetApplyScheduler().Schedule(this, [this]() { return ApplyGenerateResultStep(); });
+}
 
-	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = nullptr;
+EApplyStepResult UVitruvioComponent::ApplyGenerateResultStep()
+{
+	if (!PendingGenerateResult.IsSet())
+	{
+		return EApplyStepResult::Done;
+	}
 
-	TArray<USceneComponent*> InitialShapeChildComponents;
-	InitialShapeSceneComponent->GetChildrenComponents(false, InitialShapeChildComponents);
-	for (USceneComponent* Component : InitialShapeChildComponents)
+	FGenerateQueueItem& Result = PendingGenerateResult->Item;
+	FApplyGenerateResultState& State = PendingGenerateResult->State;
+	FConvertedGenerateResult& ConvertedResult = State.ConvertedResult;
+
+	if (State.Stage < EApplyGenerateResultStage::UpdateComponents)
 	{
-		if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
-		{
-			VitruvioModelComponent = Cast<UGeneratedModelStaticMeshComponent>(Component);
+		return BuildGenerateResultStep(Result.GenerateResultDescription, State, VitruvioModule::Get().GetMaterialCache(),
+									   VitruvioModule::Get().GetTextureCache(), MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent,
+									   MaskedParent, TranslucentParent, GetWorld());
+	}
 
-			VitruvioModelComponent->SetStaticMesh(nullptr);
+	if (State.Stage == EApplyGenerateResultStage::UpdateComponents)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
+
+		Reports = MoveTemp(ConvertedResult.Reports);
+
+		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = nullptr;
 
-			// Cleanup old hierarchical instances
-			TArray<USceneComponent*> InstanceComponents;
-			VitruvioModelComponent->GetChildrenComponents(true, InstanceComponents);
-			for (USceneComponent* InstanceComponent : InstanceComponents)
+		TArray<USceneComponent*> InitialShapeChildComponents;
+		InitialShapeSceneComponent->GetChildrenComponents(false, InitialShapeChildComponents);
+		for (USceneComponent* Component : InitialShapeChildComponents)
+		{
+			if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
 			{
-				InstanceComponent->DestroyComponent(true);
+				VitruvioModelComponent = Cast<UGeneratedModelStaticMeshComponent>(Component);
+
+				VitruvioModelComponent->SetStaticMesh(nullptr);
+				VitruvioModelComponent->SetMaterialReferences({});
+
+				// Cleanup old hierarchical instances
+				TArray<USceneComponent*> InstanceComponents;
+				VitruvioModelComponent->GetChildrenComponents(true, InstanceComponents);
+				for (USceneComponent* InstanceComponent : InstanceComponents)
+				{
+					InstanceComponent->DestroyComponent(true);
+				}
+
+				break;
 			}
+		}
 
-			break;
+		if (!VitruvioModelComponent)
+		{
+			VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShapeSceneComponent, FName(TEXT("GeneratedModel")),
+																				   RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
+			VitruvioModelComponent->CreationMethod = EComponentCreationMethod::Instance;
+			InitialShapeSceneComponent->GetOwner()->AddOwnedComponent(VitruvioModelComponent);
+			VitruvioModelComponent->AttachToComponent(InitialShapeSceneComponent, FAttachmentTransformRules::KeepRelativeTransform);
+			VitruvioModelComponent->OnComponentCreated();
+			VitruvioModelComponent->RegisterComponent();
 		}
-	}
 
-	if (!VitruvioModelComponent)
-	{
-		VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShapeSceneComponent, FName(TEXT("GeneratedModel")),
-																			   RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-		VitruvioModelComponent->CreationMethod = EComponentCreationMethod::Instance;
-		InitialShapeSceneComponent->GetOwner()->AddOwnedComponent(VitruvioModelComponent);
-		VitruvioModelComponent->AttachToComponent(InitialShapeSceneComponent, FAttachmentTransformRules::KeepRelativeTransform);
-		VitruvioModelComponent->OnComponentCreated();
-		VitruvioModelComponent->RegisterComponent();
-	}
+		if (ConvertedResult.ShapeMesh)
+		{
+			VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
+			VitruvioModelComponent->SetMaterialReferences(ConvertedResult.ShapeMesh->GetMaterialReferences());
+			VitruvioModelComponent->RecreatePhysicsState();
 
-	if (ConvertedResult.ShapeMesh)
-	{
-		VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
-		VitruvioModelComponent->RecreatePhysicsState();
-		
-		// Reset Material replacements
-		for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+			// Reset Material replacements
+			for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+			{
+				VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+			}
+
+			if (!Result.GenerateOptions.bIgnoreMaterialReplacements)
+			{
+				ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
+			}
+		}
+		else
 		{
-			VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+			VitruvioModelComponent->SetStaticMesh(nullptr);
+			VitruvioModelComponent->SetMaterialReferences({});
 		}
 
-		if (!Result.GenerateOptions.bIgnoreMaterialReplacements)
+		if (!Result.GenerateOptions.bIgnoreInstanceReplacements)
 		{
-			ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
+			State.Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, State.NameMap);
 		}
-	}
-	else
-	{
-		VitruvioModelComponent->SetStaticMesh(nullptr);
-	}
-
-	TMap<FString, int32> NameMap;
-	TSet<FInstance> Replaced;
 
-	if (!Result.GenerateOptions.bIgnoreInstanceReplacements)
-	{
-		Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, NameMap);
+		State.ModelComponent = VitruvioModelComponent;
+		State.StepIndex = 0;
+		State.Stage = EApplyGenerateResultStage::AddInstances;
+		return EApplyStepResult::Progress;
 	}
 
-	for (const FInstance& Instance : ConvertedResult.Instances)
+	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = State.ModelComponent.Get();
+	if (VitruvioModelComponent && State.StepIndex < ConvertedResult.Instances.Num())
 	{
-		if (Replaced.Contains(Instance))
+		const FInstance& Instance = ConvertedResult.Instances[State.StepIndex++];
+		if (State.Replaced.Contains(Instance))
 		{
-			continue;
+			return EApplyStepResult::Progress;
 		}
 
-		FString UniqueName = UniqueComponentName(Instance.Name, NameMap);
+		FString UniqueName = UniqueComponentName(Instance.Name, State.NameMap);
 		auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, FName(UniqueName),
 																		  RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-		
+
 		UStaticMesh* StaticMesh = Instance.InstanceMesh->GetStaticMesh();
 		InstancedComponent->SetStaticMesh(StaticMesh);
 		InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
 		InstancedComponent->RecreatePhysicsState();
 
 		// Add all instance transforms
-		const TArray<FTransform>& Transforms = Instance.Transforms;
-		for (const FTransform& Transform : Transforms)
-		{
-			InstancedComponent->AddInstance(Transform);
-		}
+		InstancedComponent->AddInstancesWithCustomData(Instance.Transforms, Instance.CustomData, Instance.NumCustomDataFloats);
 
 		// Apply override materials
 		for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
@@ -889,6 +978,11 @@ VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(
 			InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
 		}
 
+		// Keep the cached materials of the instance mesh and its overrides alive while the component uses them
+		TArray<FMaterialReferencePtr> MaterialReferences = Instance.InstanceMesh->GetMaterialReferences();
+		MaterialReferences.Append(Instance.OverrideMaterialReferences);
+		InstancedComponent->SetMaterialReferences(MoveTemp(MaterialReferences));
+
 		// Attach and register instance component
 		InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
 		InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
@@ -900,21 +994,28 @@ VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(
 		{
 			ApplyMaterialReplacements(InstancedComponent, MaterialIdentifiers, MaterialReplacement);
 		}
+
+		return EApplyStepResult::Progress;
 	}
 
+	UGenerateCompletedCallbackProxy* CallbackProxy = Result.CallbackProxy;
+	PendingGenerateResult.Reset();
+
 	OnHierarchyChanged.Broadcast(this);
 
 	bHasGeneratedModel = true;
 
 	SetInitialShapeVisible(!HideAfterGeneration);
 
-	if (Result.CallbackProxy)
+	if (CallbackProxy)
 	{
-		Result.CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
-		Result.CallbackProxy->OnGenerateCompleted.Broadcast();
-		Result.CallbackProxy->SetReadyToDestroy();
+		CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
+		CallbackProxy->OnGenerateCompleted.Broadcast();
+		CallbackProxy->SetReadyToDestroy();
 	}
 	OnGenerateCompleted.Broadcast();
+
+	return EApplyStepResult::Done;
 }
 
 void UVitruvioComponent::ProcessAttributesEvaluationQueue()
@@ -1063,6 +1164,15 @@ FString UVitruvioComponent::GetMaterialIdentifier(const UMaterialInterface* Sour
 
 void UVitruvioComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 {
+	if (PendingGenerateResult.IsSet())
+	{
+		PendingGenerateResult.Reset();
+		if (VitruvioModule* VitruvioModule = VitruvioModule::GetUnchecked())
+		{
+			VitruvioModule->GetApplyScheduler().Cancel(this);
+		}
+	}
+
 	if (GenerateToken)
 	{
 		GenerateToken->Invalidate();
@@ -1109,12 +1219,13 @@ void UVitruvioComponent::Generate(UGenerateCompletedCallbackProxy* CallbackProxy
 	if (InitialShape)
 	{
 		FGenerateResult GenerateResult =
-			VitruvioModule::Get().GenerateAsync({ FVector::ZeroVector, InitialShape->GetPolygon(), Vitruvio::CreateAttributeMap(Attributes), RandomSeed, Rpk});
+			VitruvioModule::Get().GenerateAsync({ FVector::ZeroVector, InitialShape->GetPolygon(), Vitruvio::CreateAttributeMap(Attributes), RandomSeed, Rpk},
+				bGenerateReports);
 
 		GenerateToken = GenerateResult.Token;
 
 		// clang-format off
-		GenerateResult.Result.Next([this, CallbackProxy, GenerateOptions](const FGenerateResult::ResultType& Result)
+		GenerateResult.Result.Next([this, CallbackProxy, GenerateOptions](FGenerateResult::ResultType Result)
 		{
 			FScopeLock Lock(&Result.Token->Lock);
 
@@ -1124,7 +1235,7 @@ void UVitruvioComponent::Generate(UGenerateCompletedCallbackProxy* CallbackProxy
 			}
 
 			GenerateToken.Reset();
-			GenerateQueue.Enqueue({Result.Value, GenerateOptions, CallbackProxy});
+			GenerateQueue.Enqueue({MoveTemp(Result.Value), GenerateOptions, CallbackProxy});
 		});
 		// clang-format on
 	}
@@ -1216,6 +1327,11 @@ void UVitruvioComponent::OnPropertyChanged(UObject* Object, FPropertyChangedEven
 			bComponentPropertyChanged = true;
 		}
 
+		if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UVitruvioComponent, bGenerateReports))
+		{
+			bComponentPropertyChanged = true;
+		}
+
 		if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UVitruvioComponent, MaterialReplacement))
 		{
 			bComponentPropertyChanged = true;
@@ -14,17 +14,60 @@
  */
 
 #include "VitruvioMesh.h"
+#include "LODGeneration.h"
 #include "MaterialConversion.h"
 #include "Materials/Material.h"
 #include "StaticMeshAttributes.h"
 #include "VitruvioModule.h"
+#include "Async/Async.h"
 #include "PhysicsEngine/BodySetup.h"
 #include "Engine/CollisionProfile.h"
 #include "UObject/Package.h"
 #include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("Vitruvio"), STATGROUP_Vitruvio, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Mesh Build (Game Thread)"), STAT_VitruvioMesh_Build, STATGROUP_Vitruvio);
+DECLARE_CYCLE_STAT(TEXT("Mesh FinishBuild (Game Thread)"), STAT_VitruvioMesh_FinishBuild, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Meshes Built"), STAT_VitruvioMesh_NumBuilt, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Last Mesh Build (Game Thread ms)"), STAT_VitruvioMesh_LastBuildMs, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Last Mesh FinishBuild (Game Thread ms)"), STAT_VitruvioMesh_LastFinishBuildMs, STATGROUP_Vitruvio);
+
+CSV_DEFINE_CATEGORY(Vitruvio, true);
 
 namespace
 {
+TAutoConsoleVariable<bool> CVarMemoryLean(TEXT("vitruvio.MemoryLean"), false,
+										  TEXT("Release the source data (mesh descriptions and collision data) of generated meshes once they are built. "
+											   "In the editor the data is loaded again on demand."));
+
+// Approximates the memory used by a mesh description by its serialized size
+SIZE_T GetMeshDescriptionSize(const FMeshDescription& MeshDescription)
+{
+	class FSizeCountingArchive final : public FArchive
+	{
+	public:
+		int64 Size = 0;
+
+		FSizeCountingArchive()
+		{
+			SetIsSaving(true);
+		}
+
+		virtual void Serialize(void* Data, int64 Length) override
+		{
+			Size += Length;
+		}
+	};
+
+	FSizeCountingArchive Ar;
+	Ar << const_cast<FMeshDescription&>(MeshDescription);
+	return Ar.Size;
+}
+
 FString MakeUniqueMaterialName(FString Name, TMap<FString, int32>& UniqueMaterialNames)
 {
 	if (UniqueMaterialNames.Contains(Name))
@@ -43,18 +86,16 @@ FString MakeUniqueMaterialName(FString Name, TMap<FString, int32>& UniqueMateria
 } // namespace
 
 UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-										TMap<FString, Vitruvio::FTextureData>& TextureCache,
-										TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+										FTextureCache& TextureCache, FMaterialCache& MaterialCache,
 										const Vitruvio::FMaterialAttributeContainer& MaterialAttributes, TMap<FString, int32>& UniqueMaterialNames,
-										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer)
+										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer, FMaterialReferencePtr& OutReference)
 {
 	check(IsInGameThread());
 
 	const FString MaterialIdentifier = MaterialAttributes.GetMaterialName();
 
-	if (const TObjectPtr<UMaterialInstanceDynamic>* Result = MaterialCache.Find(MaterialAttributes))
+	if (UMaterialInstanceDynamic* Material = MaterialCache.Get(MaterialAttributes.Id, OutReference))
 	{
-		const TObjectPtr<UMaterialInstanceDynamic> Material = *Result;
 		MaterialIdentifiers.Add(Material, MaterialIdentifier);
 		return Material;
 	}
@@ -63,48 +104,100 @@ UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* Mask
 	UMaterialInstanceDynamic* Material = GameThread_CreateMaterialInstance(Outer, UniqueMaterialIdentifier, OpaqueParent, MaskedParent,
 																		   TranslucentParent, MaterialAttributes, TextureCache);
 
-	MaterialCache.Add(MaterialAttributes, Material);
+	OutReference = MaterialCache.Add(MaterialAttributes.Id, Material);
 	MaterialIdentifiers.Add(Material, MaterialIdentifier);
 
+	if (TextureCache.IsOverBudget())
+	{
+		// Textures used by cached materials or waiting to be bound to one can not be released, collect them once for the whole eviction
+		TSet<const UTexture*> ReferencedTextures;
+		MaterialCache.ForEachMaterial([&ReferencedTextures](const UMaterialInstanceDynamic* CachedMaterial) {
+			for (const FTextureParameterValue& TextureParameter : CachedMaterial->TextureParameterValues)
+			{
+				ReferencedTextures.Add(TextureParameter.ParameterValue);
+			}
+		});
+		Vitruvio::ForEachPendingTexture([&ReferencedTextures](const UTexture2D* Texture) { ReferencedTextures.Add(Texture); });
+		TextureCache.EvictUnreferenced([&ReferencedTextures](const UTexture2D* Texture) { return ReferencedTextures.Contains(Texture); });
+	}
+
 	return Material;
 }
 
-void InitializeBodySetup(UBodySetup* BodySetup)
+void InitializeBodySetup(UBodySetup* BodySetup, bool bAsyncCook)
 {
 	BodySetup->DefaultInstance.SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
 	BodySetup->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
 	BodySetup->bDoubleSidedGeometry = true;
 	BodySetup->bMeshCollideAll = true;
 	BodySetup->InvalidatePhysicsData();
-	BodySetup->CreatePhysicsMeshes();
+	if (bAsyncCook)
+	{
+		BodySetup->CreatePhysicsMeshesAsync({});
+	}
+	else
+	{
+		BodySetup->CreatePhysicsMeshes();
+	}
 }
 
 FVitruvioMesh::~FVitruvioMesh()
 {
+	// The build task accesses this mesh, wait for it to finish before releasing anything
+	if (BuildTask.IsValid())
+	{
+		BuildTask.Wait();
+	}
+
 	if (IsEngineExitRequested())
 	{
 		return;
 	}
 	
-	VitruvioModule* VitruvioModule = VitruvioModule::GetUnchecked();
-	if (StaticMesh && VitruvioModule)
+	if (!StaticMesh)
+	{
+		return;
+	}
+
+	// Shared meshes can be released last by a generate worker, the registered meshes are only modified on the game thread. The mesh stays
+	// registered, and therefore alive, until it is unregistered.
+	const auto Unregister = [StaticMesh = StaticMesh]() {
+		if (VitruvioModule* VitruvioModule = VitruvioModule::GetUnchecked())
+		{
+			VitruvioModule->UnregisterMesh(StaticMesh);
+		}
+	};
+
+	if (IsInGameThread())
 	{
-		VitruvioModule->UnregisterMesh(StaticMesh);
+		Unregister();
+	}
+	else
+	{
+		AsyncTask(ENamedThreads::GameThread, Unregister);
 	}
 }
 
-void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-						  TMap<FString, Vitruvio::FTextureData>& TextureCache, TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers,
-						  TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+void FVitruvioMesh::Build(const FString& Name, FMaterialCache& MaterialCache, FTextureCache& TextureCache,
+						  TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers, TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
 						  UWorld* World)
 {
+	SCOPE_CYCLE_COUNTER(STAT_VitruvioMesh_Build);
+
 	check(IsInGameThread());
 
 	if (StaticMesh)
 	{
+		// The mesh is shared with other results, only register its materials
+		for (int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+		{
+			UniqueMaterialIdentifiers.Add(StaticMesh->GetMaterial(MaterialIndex), Materials[MaterialIndex].GetMaterialName());
+		}
 		return;
 	}
 
+	FScopedDurationTimer BuildTimer(GameThreadBuildSeconds);
+
 	FString MeshName = Name.Replace(TEXT("."), TEXT(""));
 	const FName StaticMeshName = MakeUniqueObjectName(nullptr, UStaticMesh::StaticClass(), FName(MeshName));
 	StaticMesh = NewObject<UStaticMesh>(GetTransientPackage(), StaticMeshName, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
@@ -112,64 +205,206 @@ void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttribute
 	
 	VitruvioModule::Get().RegisterMesh(StaticMesh);
 
-	TMap<UMaterialInstanceDynamic*, FName> MaterialSlots;
-
 	FStaticMeshAttributes MeshAttributes(MeshDescription);
-
-	TArray<FVector3f> Vertices;
-	auto VertexPositions = MeshAttributes.GetVertexPositions();
-	for (int32 VertexIndex = 0; VertexIndex < VertexPositions.GetNumElements(); ++VertexIndex)
-	{
-		Vertices.Add(VertexPositions[FVertexID(VertexIndex)]);
-	}
-
-	TArray<FTriIndices> Indices;
-	const auto PolygonGroups = MeshDescription.PolygonGroups();
 	size_t MaterialIndex = 0;
 
-	for (const auto& PolygonGroupId : PolygonGroups.GetElementIDs())
+	for (const auto& PolygonGroupId : MeshDescription.PolygonGroups().GetElementIDs())
 	{
+		FMaterialReferencePtr MaterialReference;
 		UMaterialInstanceDynamic* Material = CacheMaterial(OpaqueParent, MaskedParent, TranslucentParent, TextureCache, MaterialCache,
-														   Materials[MaterialIndex], UniqueMaterialNames, UniqueMaterialIdentifiers, StaticMesh);
+														   Materials[MaterialIndex], UniqueMaterialNames, UniqueMaterialIdentifiers, StaticMesh,
+														   MaterialReference);
+		MaterialReferences.Add(MoveTemp(MaterialReference));
 
 		const FName SlotName = StaticMesh->AddMaterial(Material);
 		MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = SlotName;
-		MaterialSlots.Add(Material, SlotName);
 
 		++MaterialIndex;
+	}
+
+	// From here on neither the mesh description nor the static materials are modified until FinishBuild (see BuildRenderAndCollisionData)
+	BuildTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { BuildRenderAndCollisionData(); });
+}
+
+// Runs on a worker thread while the game thread can reach StaticMesh through the registered meshes and GC. This is safe because
+// BuildFromMeshDescription only writes to the passed FStaticMeshLODResources and only reads the static materials of the UStaticMesh
+// (to map material slot names to section material indices):
+// - The static materials are added in Build before this task is launched and are never modified afterwards, meshes shared between
+//   results only read them (see Build).
+// - StaticMesh is registered before this task is launched and stays registered, and therefore referenced, until ~FVitruvioMesh which
+//   waits for this task first. GC only reads the reachable mesh.
+// - The mesh is not assigned to any component, nor are its render data or body setup set, before FinishBuild saw this task completed.
+void FVitruvioMesh::BuildRenderAndCollisionData()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioMesh_BuildRenderAndCollisionData);
+
+	const Vitruvio::FLODSettings LODSettings = Vitruvio::GetLODSettings();
+	LODMeshDescriptions = Vitruvio::GenerateLODs(MeshDescription, LODSettings);
+	LODScreenSizes = TArray<float>(LODSettings.ScreenSizes.GetData(), LODMeshDescriptions.Num());
+
+	RenderData = MakeUnique<FStaticMeshRenderData>();
+	RenderData->AllocateLODResources(1 + LODMeshDescriptions.Num());
+	StaticMesh->BuildFromMeshDescription(MeshDescription, RenderData->LODResources[0]);
+	RenderData->Bounds = MeshDescription.GetBounds();
+	RenderData->ScreenSize[0].Default = 1.0f;
+
+	for (int32 LODIndex = 0; LODIndex < LODMeshDescriptions.Num(); ++LODIndex)
+	{
+		StaticMesh->BuildFromMeshDescription(LODMeshDescriptions[LODIndex], RenderData->LODResources[LODIndex + 1]);
+		RenderData->ScreenSize[LODIndex + 1].Default = LODScreenSizes[LODIndex];
+	}
+
+	CollisionData = Vitruvio::CreateCollisionData(MeshDescription);
+}
+
+bool FVitruvioMesh::FinishBuild()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VitruvioMesh_FinishBuild);
 
-		// cache collision data
-		for (FPolygonID PolygonID : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+	check(IsInGameThread());
+	check(StaticMesh);
+
+	bool bFinished;
+	{
+		FScopedDurationTimer FinishBuildTimer(GameThreadFinishBuildSeconds);
+		bFinished = TryFinishBuild();
+	}
+
+	if (bFinished && !bGameThreadTimeReported)
+	{
+		ReportGameThreadTime();
+	}
+
+	return bFinished;
+}
+
+bool FVitruvioMesh::TryFinishBuild()
+{
+	if (!bRenderDataFinished)
+	{
+		if (!BuildTask.IsCompleted())
 		{
-			for (FTriangleID TriangleID : MeshDescription.GetPolygonTriangles(PolygonID))
-			{
-				auto TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
+			return false;
+		}
 
-				auto VertexID0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]);
-				auto VertexID1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]);
-				auto VertexID2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]);
+		// The sections built by BuildRenderAndCollisionData index into the static materials as they were when the task was launched
+		check(StaticMesh->GetStaticMaterials().Num() == Materials.Num());
 
-				FTriIndices TriIndex;
-				TriIndex.v0 = VertexID0.GetValue();
-				TriIndex.v1 = VertexID1.GetValue();
-				TriIndex.v2 = VertexID2.GetValue();
-				Indices.Add(TriIndex);
-			}
+		StaticMesh->SetIsBuiltAtRuntime(true);
+		StaticMesh->SetRenderData(MoveTemp(RenderData));
+		StaticMesh->InitResources();
+		StaticMesh->CalculateExtendedBounds();
+
+#if WITH_EDITOR
+		// The mesh descriptions are needed in the editor, eg for cooking generated models into assets
+		StaticMesh->SetNumSourceModels(1 + LODMeshDescriptions.Num());
+		UStaticMesh::FCommitMeshDescriptionParams CommitParams;
+		CommitParams.bMarkPackageDirty = false;
+		CommitParams.bUseHashAsGuid = true;
+
+		if (CVarMemoryLean.GetValueOnGameThread())
+		{
+			StaticMesh->CreateMeshDescription(0, MoveTemp(MeshDescription));
+		}
+		else
+		{
+			StaticMesh->CreateMeshDescription(0, MeshDescription);
+		}
+		StaticMesh->CommitMeshDescription(0, CommitParams);
+
+		for (int32 LODIndex = 0; LODIndex < LODMeshDescriptions.Num(); ++LODIndex)
+		{
+			StaticMesh->GetSourceModel(LODIndex + 1).ScreenSize.Default = LODScreenSizes[LODIndex];
+			StaticMesh->CreateMeshDescription(LODIndex + 1, MoveTemp(LODMeshDescriptions[LODIndex]));
+			StaticMesh->CommitMeshDescription(LODIndex + 1, CommitParams);
 		}
+		StaticMesh->bAutoComputeLODScreenSize = false;
+#endif
+		LODMeshDescriptions.Empty();
+
+		CollisionDataProvider->SetCollisionData(MoveTemp(CollisionData));
+
+		UBodySetup* BodySetup = NewObject<UBodySetup>(CollisionDataProvider, NAME_None, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient | RF_Transactional);
+		InitializeBodySetup(BodySetup, true);
+		StaticMesh->SetBodySetup(BodySetup);
+
+		bRenderDataFinished = true;
 	}
 
-	TArray<const FMeshDescription*> MeshDescriptionPtrs;
-	MeshDescriptionPtrs.Emplace(&MeshDescription);
+	if (!StaticMesh->GetBodySetup()->bCreatedPhysicsMeshes)
+	{
+		return false;
+	}
 
-	UStaticMesh::FBuildMeshDescriptionsParams Params;
-	Params.bCommitMeshDescription = true;
-	Params.bFastBuild = true;
-	StaticMesh->BuildFromMeshDescriptions(MeshDescriptionPtrs, Params);
-	
-	Vitruvio::FCollisionData CollisionData = {Indices, Vertices};
-	CollisionDataProvider->SetCollisionData(CollisionData);
+	if (!bSourceDataReleased && CVarMemoryLean.GetValueOnGameThread())
+	{
+		ReleaseSourceData();
+	}
+
+	return true;
+}
+
+void FVitruvioMesh::ReportGameThreadTime()
+{
+	const float BuildMs = static_cast<float>(GameThreadBuildSeconds * 1000.0);
+	const float FinishBuildMs = static_cast<float>(GameThreadFinishBuildSeconds * 1000.0);
+
+	INC_DWORD_STAT(STAT_VitruvioMesh_NumBuilt);
+	SET_FLOAT_STAT(STAT_VitruvioMesh_LastBuildMs, BuildMs);
+	SET_FLOAT_STAT(STAT_VitruvioMesh_LastFinishBuildMs, FinishBuildMs);
+
+	// Divided by MeshesBuilt these give the game thread milliseconds per generated mesh of a frame
+	CSV_CUSTOM_STAT(Vitruvio, MeshesBuilt, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Vitruvio, MeshBuildGameThreadMs, BuildMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Vitruvio, MeshFinishBuildGameThreadMs, FinishBuildMs, ECsvCustomStatOp::Accumulate);
+
+	UE_LOG(LogUnrealPrt, Verbose, TEXT("Built mesh %s: %.2f ms Build, %.2f ms FinishBuild on the game thread"), *Identifier, BuildMs,
+		   FinishBuildMs);
+
+	bGameThreadTimeReported = true;
+}
+
+void FVitruvioMesh::ReleaseSourceData()
+{
+	const SIZE_T SizeBefore = GetSourceDataSize();
+
+	// Render data and cooked collision are all that is needed to display the mesh
+	MeshDescription = FMeshDescription();
+
+#if WITH_EDITOR
+	// The committed mesh descriptions are kept as the only source, they are loaded again on demand (eg for cooking)
+	StaticMesh->ClearMeshDescriptions();
+	CollisionDataProvider->ReleaseCollisionData(StaticMesh);
+#endif
+
+	bSourceDataReleased = true;
+
+	UE_LOG(LogUnrealPrt, Verbose, TEXT("Released source data of mesh %s: %llu KiB before, %llu KiB after"), *Identifier,
+		   static_cast<uint64>(SizeBefore / 1024), static_cast<uint64>(GetSourceDataSize() / 1024));
+}
+
+SIZE_T FVitruvioMesh::GetSourceDataSize() const
+{
+	SIZE_T Size = GetMeshDescriptionSize(MeshDescription);
+	Size += CollisionData.Indices.GetAllocatedSize() + CollisionData.Vertices.GetAllocatedSize();
+
+	if (CollisionDataProvider)
+	{
+		Size += CollisionDataProvider->GetCollisionDataSize();
+	}
+
+#if WITH_EDITOR
+	if (StaticMesh)
+	{
+		for (int32 LODIndex = 0; LODIndex < StaticMesh->GetNumSourceModels(); ++LODIndex)
+		{
+			if (const FMeshDescription* CachedMeshDescription = StaticMesh->GetSourceModel(LODIndex).GetCachedMeshDescription())
+			{
+				Size += GetMeshDescriptionSize(*CachedMeshDescription);
+			}
+		}
+	}
+#endif
 
-	UBodySetup* BodySetup = NewObject<UBodySetup>(CollisionDataProvider, NAME_None, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient | RF_Transactional);
-	InitializeBodySetup(BodySetup);
-	StaticMesh->SetBodySetup(BodySetup);
+	return Size;
 }
\ No newline at end of file
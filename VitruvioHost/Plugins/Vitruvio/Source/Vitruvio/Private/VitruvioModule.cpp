@@ -17,8 +17,11 @@
 
 #include "prt/API.h"
 
+#include "MaterialConversion.h"
 #include "PRTTypes.h"
 #include "PRTUtils.h"
+#include "TextureAtlas.h"
+#include "TextureCompression.h"
 #include "TextureDecoding.h"
 #include "UnrealCallbacks.h"
 
@@ -28,6 +31,7 @@
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFileManager.h"
 #include "Interfaces/IPluginManager.h"
+#include "Misc/ScopeRWLock.h"
 #include "Modules/ModuleManager.h"
 
 #include "UObject/UObjectBaseUtility.h"
@@ -72,11 +76,19 @@ class FLoadResolveMapTask
 	FCriticalSection& LoadResolveMapLock;
 	FString RpkFolder;
 
+	int32 MaxTextureResolution;
+	TMap<FString, int32>& RpkMaxTextureResolutions;
+	TMap<TLazyObjectPtr<URulePackage>, FString>& RpkUris;
+	FRWLock& MaxTextureResolutionLock;
+
 public:
 	FLoadResolveMapTask(TPromise<ResolveMapSPtr>&& InPromise, const FString RpkFolder, const TLazyObjectPtr<URulePackage> LazyRulePackagePtr,
-						TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache, FCriticalSection& LoadResolveMapLock)
+						TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache, FCriticalSection& LoadResolveMapLock,
+						int32 MaxTextureResolution, TMap<FString, int32>& RpkMaxTextureResolutions,
+						TMap<TLazyObjectPtr<URulePackage>, FString>& RpkUris, FRWLock& MaxTextureResolutionLock)
 		: LazyRulePackagePtr(LazyRulePackagePtr), Promise(MoveTemp(InPromise)), ResolveMapCache(ResolveMapCache),
-		  LoadResolveMapLock(LoadResolveMapLock), RpkFolder(RpkFolder)
+		  LoadResolveMapLock(LoadResolveMapLock), RpkFolder(RpkFolder), MaxTextureResolution(MaxTextureResolution),
+		  RpkMaxTextureResolutions(RpkMaxTextureResolutions), RpkUris(RpkUris), MaxTextureResolutionLock(MaxTextureResolutionLock)
 	{
 	}
 
@@ -127,6 +139,13 @@ public:
 			const std::wstring RpkFileUri = prtu::toFileURI(AbsoluteRpkPath);
 			prt::Status Status;
 			const ResolveMapSPtr ResolveMapPtr(prt::createResolveMap(RpkFileUri.c_str(), nullptr, &Status), PRTDestroyer());
+			{
+				// Registered before the promise is set, so that the textures of the first generate already use the override
+				FWriteScopeLock Lock(MaxTextureResolutionLock);
+				const FString RpkUri(WCHAR_TO_TCHAR(RpkFileUri.c_str()));
+				RpkUris.Add(LazyRulePackagePtr, RpkUri);
+				RpkMaxTextureResolutions.Add(RpkUri, MaxTextureResolution);
+			}
 			{
 				FScopeLock Lock(&LoadResolveMapLock);
 				ResolveMapCache.Add(LazyRulePackagePtr, ResolveMapPtr);
@@ -140,6 +159,19 @@ public:
 	}
 };
 
+AttributeMapUPtr CreateUnrealEncoderOptions(bool bEmitReports)
+{
+	AttributeMapBuilderUPtr OptionsBuilder(prt::AttributeMapBuilder::create());
+	OptionsBuilder->setBool(EO_EMIT_REPORTS, bEmitReports);
+	const AttributeMapUPtr Options(OptionsBuilder->createAttributeMapAndReset());
+	return prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID, Options.get());
+}
+
+UnrealCallbacks::FCachedPrototypeLookup FindCachedPrototype()
+{
+	return [](const FString& MeshId) { return VitruvioModule::Get().GetMeshCache().Get(MeshId); };
+}
+
 void SetInitialShapeGeometry(const InitialShapeBuilderUPtr& InitialShapeBuilder, const FInitialShape& InitialShape)
 {
 	std::vector<double> vertexCoords;
@@ -338,11 +370,15 @@ void VitruvioModule::StartupModule()
 		return;
 	}
 
+	ApplyScheduler.Start();
+
 	InitializePrt();
 }
 
 void VitruvioModule::ShutdownModule()
 {
+	ApplyScheduler.Stop();
+
 	if (!Initialized)
 	{
 		return;
@@ -376,17 +412,91 @@ void VitruvioModule::ShutdownModule()
 	UE_LOG(LogUnrealPrt, Display, TEXT("Shutdown complete"))
 }
 
-Vitruvio::FTextureData VitruvioModule::DecodeTexture(UObject* Outer, const FString& Path, const FString& Key) const
+Vitruvio::FTextureData VitruvioModule::DecodeTexture(UObject* Outer, const FString& Path, const FString& Key, int32 MaxResolution) const
+{
+	// Atlas pages have no file of their own and are assembled from the textures packed into them
+	Vitruvio::FTexturePixels Pixels = Vitruvio::IsTextureAtlasPage(Path) ? Vitruvio::AssembleTextureAtlasPage(Path) : ReadTexture(Path);
+	if (Pixels.Metadata.PixelFormat == Vitruvio::EPRTPixelFormat::Unknown)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("Could not read texture %s"), *Path);
+		return {};
+	}
+
+	return Vitruvio::DecodeTexture(Outer, Key, Path, Pixels.Metadata, std::move(Pixels.Buffer), Pixels.BufferSize, MaxResolution,
+								   [this](uint64 ContentHash) { return TextureCache.FindByContentHash(ContentHash); });
+}
+
+int32 VitruvioModule::GetMaxTextureResolution(const FString& Path) const
+{
+	// Atlas pages use the largest cap of the textures packed into them, so that none of them ends up below its own cap
+	if (Vitruvio::IsTextureAtlasPage(Path))
+	{
+		const TArray<FString> TexturePaths = Vitruvio::GetTextureAtlasPageTextures(Path);
+		if (TexturePaths.IsEmpty())
+		{
+			return Vitruvio::GetTextureCompressionSettings().MaxResolution;
+		}
+
+		int32 PageMaxResolution = 0;
+		for (const FString& TexturePath : TexturePaths)
+		{
+			const int32 MaxResolution = GetMaxTextureResolution(TexturePath);
+			if (MaxResolution == 0)
+			{
+				return 0;
+			}
+			PageMaxResolution = FMath::Max(PageMaxResolution, MaxResolution);
+		}
+		return PageMaxResolution;
+	}
+
+	// Textures inside a rule package are addressed as rpk:<rpk uri>!/<path inside the rpk>, their rpk uri is looked up directly
+	int32 RpkUriEnd;
+	if (Path.FindChar(TEXT('!'), RpkUriEnd))
+	{
+		const int32 RpkUriStart = Path.StartsWith(TEXT("rpk:")) ? 4 : 0;
+		const FString RpkUri = Path.Mid(RpkUriStart, RpkUriEnd - RpkUriStart);
+
+		FReadScopeLock Lock(MaxTextureResolutionLock);
+		const int32* MaxResolution = RpkMaxTextureResolutions.Find(RpkUri);
+		if (MaxResolution && *MaxResolution > 0)
+		{
+			return *MaxResolution;
+		}
+	}
+
+	return Vitruvio::GetTextureCompressionSettings().MaxResolution;
+}
+
+void VitruvioModule::UpdateMaxTextureResolution(URulePackage* RulePackage)
 {
-	const prt::AttributeMap* TextureMetadataAttributeMap = prt::createTextureMetadata(*Path, PrtCache.get());
-	Vitruvio::FTextureMetadata TextureMetadata = Vitruvio::ParseTextureMetadata(TextureMetadataAttributeMap);
+	check(IsInGameThread());
 
-	size_t BufferSize = TextureMetadata.Width * TextureMetadata.Height * TextureMetadata.Bands * TextureMetadata.BytesPerBand;
-	auto Buffer = std::make_unique<uint8_t[]>(BufferSize);
+	FWriteScopeLock Lock(MaxTextureResolutionLock);
+	if (const FString* RpkUri = RpkUris.Find(TLazyObjectPtr<URulePackage>(RulePackage)))
+	{
+		RpkMaxTextureResolutions.Add(*RpkUri, RulePackage->MaxTextureResolution);
+	}
+}
 
-	prt::getTexturePixeldata(*Path, Buffer.get(), BufferSize, PrtCache.get());
+Vitruvio::FTextureMetadata VitruvioModule::ReadTextureMetadata(const FString& Path) const
+{
+	const AttributeMapUPtr TextureMetadataAttributeMap(prt::createTextureMetadata(*Path, PrtCache.get()));
+	return Vitruvio::ParseTextureMetadata(TextureMetadataAttributeMap.get());
+}
+
+Vitruvio::FTexturePixels VitruvioModule::ReadTexture(const FString& Path) const
+{
+	Vitruvio::FTexturePixels Pixels;
+	Pixels.Metadata = ReadTextureMetadata(Path);
 
-	return Vitruvio::DecodeTexture(Outer, Key, Path, TextureMetadata, std::move(Buffer), BufferSize);
+	const Vitruvio::FTextureMetadata& TextureMetadata = Pixels.Metadata;
+	Pixels.BufferSize = TextureMetadata.Width * TextureMetadata.Height * TextureMetadata.Bands * TextureMetadata.BytesPerBand;
+	Pixels.Buffer = std::make_unique<uint8_t[]>(Pixels.BufferSize);
+
+	prt::getTexturePixeldata(*Path, Pixels.Buffer.get(), Pixels.BufferSize, PrtCache.get());
+
+	return Pixels;
 }
 
 FBatchGenerateResult VitruvioModule::BatchGenerateAsync(TArray<FInitialShape> InitialShapes) const
@@ -409,7 +519,10 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	{
 		return {};
 	}
-	
+
+	// Check for changed texture files here on the generate thread instead of on the game thread when creating the materials
+	TextureCache.Revalidate();
+
 	CHECK_PRT_INITIALIZED()
 
 	GenerateCallsCounter.Add(InitialShapes.Num());
@@ -515,8 +628,9 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	}
 
 	// Generate
+	const AttributeMapUPtr UnrealEncoderOptions(CreateUnrealEncoderOptions(false));
 	TArray<AttributeMapBuilderUPtr> GenerateAttributeMapBuilders;
-	TSharedPtr<UnrealCallbacks> GenerateOutputHandler(new UnrealCallbacks(GenerateAttributeMapBuilders));
+	TSharedPtr<UnrealCallbacks> GenerateOutputHandler(new UnrealCallbacks(GenerateAttributeMapBuilders, FindCachedPrototype()));
 	{
 		InitialShapeUPtrs.clear();
 		InitialShapePtrs.clear();
@@ -535,7 +649,6 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	    AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
 
 	    const std::vector UnrealEncoderIds = { UNREAL_GEOMETRY_ENCODER_ID };
-	    const AttributeMapUPtr UnrealEncoderOptions(prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID));
 	    const AttributeMapNOPtrVector GenerateEncoderOptions = {UnrealEncoderOptions.get()};
 
 		AttributeMapBuilderUPtr GenerateOptionsBuilder(prt::AttributeMapBuilder::create());
@@ -560,29 +673,33 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 
 	NotifyGenerateCompleted();
     
-    return FGenerateResultDescription { GenerateOutputHandler->GetGeneratedModel(), GenerateOutputHandler->GetInstances(),
-    	GenerateOutputHandler->GetInstanceMeshes(), GenerateOutputHandler->GetInstanceNames(), {}, EvaluatedAttributes };
+	FGenerateResultDescription Result = GenerateOutputHandler->TakeGenerateResult();
+	Result.EvaluatedAttributes = MoveTemp(EvaluatedAttributes);
+	return Result;
 }
 
 
-FGenerateResult VitruvioModule::GenerateAsync(FInitialShape InitialShape) const
+FGenerateResult VitruvioModule::GenerateAsync(FInitialShape InitialShape, bool bEmitReports) const
 {
 	const FGenerateResult::FTokenPtr Token = MakeShared<FGenerateToken>();
 
 	CHECK_PRT_INITIALIZED_ASYNC(FGenerateResult, Token)
 
-	FGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::Thread, [this, Token, InitialShape = MoveTemp(InitialShape)]() mutable {
-		FGenerateResultDescription Result = Generate(MoveTemp(InitialShape));
+	FGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::Thread, [this, Token, InitialShape = MoveTemp(InitialShape), bEmitReports]() mutable {
+		FGenerateResultDescription Result = Generate(MoveTemp(InitialShape), bEmitReports);
 		return FGenerateResult::ResultType{Token, MoveTemp(Result)};
 	});
 
 	return FGenerateResult{MoveTemp(ResultFuture), Token};
 }
 
-FGenerateResultDescription VitruvioModule::Generate(const FInitialShape& InitialShape) const
+FGenerateResultDescription VitruvioModule::Generate(const FInitialShape& InitialShape, bool bEmitReports) const
 {
 	CHECK_PRT_INITIALIZED()
 
+	// Check for changed texture files here on the generate thread instead of on the game thread when creating the materials
+	TextureCache.Revalidate();
+
 	GenerateCallsCounter.Increment();
 
 	const InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
@@ -599,14 +716,15 @@ FGenerateResultDescription VitruvioModule::Generate(const FInitialShape& Initial
 	InitialShapeBuilder->setAttributes(RuleFile.c_str(), StartRule.c_str(),
 		InitialShape.RandomSeed, L"", InitialShape.Attributes.get(), ResolveMap.get());
 
+	const AttributeMapUPtr UnrealEncoderOptions(CreateUnrealEncoderOptions(bEmitReports));
+
 	TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
 	AttributeMapBuilders.Add(AttributeMapBuilderUPtr(prt::AttributeMapBuilder::create()));
-	const TSharedPtr<UnrealCallbacks> OutputHandler(new UnrealCallbacks(AttributeMapBuilders));
+	const TSharedPtr<UnrealCallbacks> OutputHandler(new UnrealCallbacks(AttributeMapBuilders, FindCachedPrototype()));
 
 	const InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShapeAndReset());
 
 	const std::vector<const wchar_t*> EncoderIds = {UNREAL_GEOMETRY_ENCODER_ID};
-	const AttributeMapUPtr UnrealEncoderOptions(prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID));
 	const AttributeMapNOPtrVector EncoderOptions = {UnrealEncoderOptions.get()};
 
 	InitialShapeNOPtrVector Shapes = {Shape.get()};
@@ -625,8 +743,7 @@ FGenerateResultDescription VitruvioModule::Generate(const FInitialShape& Initial
 	
 	NotifyGenerateCompleted();
 
-	return FGenerateResultDescription{ OutputHandler->GetGeneratedModel(), OutputHandler->GetInstances(), OutputHandler->GetInstanceMeshes(),
-									  OutputHandler->GetInstanceNames(), OutputHandler->GetReports()};
+	return OutputHandler->TakeGenerateResult();
 }
 
 FAttributeMapResult VitruvioModule::EvaluateRuleAttributesAsync(FInitialShape InitialShape) const
@@ -682,14 +799,31 @@ void VitruvioModule::EvictFromResolveMapCache(URulePackage* RulePackage)
 	PrtCache->flushAll();
 }
 
+void VitruvioModule::FlushPendingTextureBindings() const
+{
+	Vitruvio::FlushPendingTextureBindings();
+}
+
+void VitruvioModule::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	MaterialCache.AddReferencedObjects(Collector);
+	Collector.AddReferencedObjects(RegisteredMeshes);
+	TextureCache.AddReferencedObjects(Collector);
+
+	// Decoded textures may be evicted from the texture cache before they are bound to their materials
+	Vitruvio::ForEachPendingTexture([&Collector](UTexture2D* Texture) { Collector.AddReferencedObject(Texture); });
+}
+
 void VitruvioModule::RegisterMesh(UStaticMesh* StaticMesh)
 {
+	check(IsInGameThread());
 	FScopeLock Lock(&RegisterMeshLock);
 	RegisteredMeshes.Add(StaticMesh);
 }
 
 void VitruvioModule::UnregisterMesh(UStaticMesh* StaticMesh)
 {
+	check(IsInGameThread());
 	FScopeLock Lock(&RegisterMeshLock);
 	RegisteredMeshes.Remove(StaticMesh);
 }
@@ -781,8 +915,9 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 		{
 			FScopeLock Lock(&LoadResolveMapLock);
 			// Task which does the actual resolve map loading which might take a long time
-			LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(MoveTemp(Promise), RpkFolder, LazyRulePackagePtr,
-																								   ResolveMapCache, LoadResolveMapLock);
+			LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(
+				MoveTemp(Promise), RpkFolder, LazyRulePackagePtr, ResolveMapCache, LoadResolveMapLock, RulePackage->MaxTextureResolution,
+				RpkMaxTextureResolutions, RpkUris, MaxTextureResolutionLock);
 			ResolveMapEventGraphRefCache.Add(LazyRulePackagePtr, LoadTask);
 		}
 
@@ -15,6 +15,8 @@
 
 #include "VitruvioTypes.h"
 
+#include "Hash/xxhash.h"
+#include "StaticMeshAttributes.h"
 #include "Runtime/Core/Public/Containers/UnrealString.h"
 #include "Runtime/Core/Public/Templates/TypeHash.h"
 
@@ -91,11 +93,35 @@ FLinearColor GetLinearColor(const prt::AttributeMap* MaterialAttributes, wchar_t
 	return FLinearColor(Color);
 }
 
+void HashString(FXxHash64Builder& Builder, const FString& String)
+{
+	const int32 Length = String.Len();
+	Builder.Update(&Length, sizeof(Length));
+	Builder.Update(*String, Length * sizeof(TCHAR));
+}
+
+// Keys are hashed in sorted order so that the hash does not depend on the insertion order of the properties
+template <typename V, typename F>
+void HashProperties(FXxHash64Builder& Builder, const TMap<FString, V>& Properties, F HashValue)
+{
+	TArray<FString> Keys;
+	Properties.GetKeys(Keys);
+	Keys.Sort([](const FString& A, const FString& B) { return A.Compare(B, ESearchCase::CaseSensitive) < 0; });
+
+	const int32 Num = Keys.Num();
+	Builder.Update(&Num, sizeof(Num));
+	for (const FString& Key : Keys)
+	{
+		HashString(Builder, Key);
+		HashValue(Properties[Key]);
+	}
+}
+
 } // namespace
 
 namespace Vitruvio
 {
-FMaterialAttributeContainer::FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap)
+FMaterialAttributeContainer::FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap, const TMap<FString, double>& AdditionalScalarProperties)
 {
 	size_t KeyCount = 0;
 	wchar_t const* const* Keys = AttributeMap->getKeys(&KeyCount);
@@ -158,22 +184,70 @@ FMaterialAttributeContainer::FMaterialAttributeContainer(const prt::AttributeMap
 	{
 		Name = AttributeMap->getString(L"name");
 	}
+
+	ScalarProperties.Append(AdditionalScalarProperties);
+
+	UpdateId();
 }
 
-uint32 GetTypeHash(const FMaterialAttributeContainer& Object)
+void FMaterialAttributeContainer::UpdateId()
 {
-	uint32 Hash = 0x274110C5;
-	Hash = HashCombine(Hash, GetMapHash<FString, FString>(Object.TextureProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, FLinearColor>(Object.ColorProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, double>(Object.ScalarProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, FString>(Object.StringProperties));
-	Hash = HashCombine(Hash, GetTypeHash(Object.BlendMode));
-	return Hash;
+	FXxHash64Builder Builder;
+	HashProperties(Builder, TextureProperties, [&Builder](const FString& Value) { HashString(Builder, Value); });
+	HashProperties(Builder, ColorProperties, [&Builder](const FLinearColor& Value) { Builder.Update(&Value, sizeof(Value)); });
+	HashProperties(Builder, ScalarProperties, [&Builder](const double& Value) { Builder.Update(&Value, sizeof(Value)); });
+	HashProperties(Builder, StringProperties, [&Builder](const FString& Value) { HashString(Builder, Value); });
+	HashString(Builder, BlendMode);
+	Id = Builder.Finalize().Hash;
 }
 
 uint32 GetTypeHash(const FInstanceCacheKey& Object)
 {
-	return HashCombine(GetTypeHash(Object.MeshId), GetArrayHash(Object.MaterialOverrides));
+	uint32 Hash = GetTypeHash(Object.MeshId);
+	for (const FMaterialId MaterialId : Object.MaterialOverrides)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(MaterialId));
+	}
+	return Hash;
+}
+
+FCollisionData CreateCollisionData(const FMeshDescription& MeshDescription)
+{
+	FCollisionData CollisionData;
+	FStaticMeshConstAttributes MeshAttributes(MeshDescription);
+
+	TArray<FVector3f>& Vertices = CollisionData.Vertices;
+	const auto VertexPositions = MeshAttributes.GetVertexPositions();
+	Vertices.Reserve(VertexPositions.GetNumElements());
+	for (int32 VertexIndex = 0; VertexIndex < VertexPositions.GetNumElements(); ++VertexIndex)
+	{
+		Vertices.Add(VertexPositions[FVertexID(VertexIndex)]);
+	}
+
+	TArray<FTriIndices>& Indices = CollisionData.Indices;
+	Indices.Reserve(MeshDescription.Triangles().Num());
+	for (const auto& PolygonGroupId : MeshDescription.PolygonGroups().GetElementIDs())
+	{
+		for (FPolygonID PolygonID : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+		{
+			for (FTriangleID TriangleID : MeshDescription.GetPolygonTriangles(PolygonID))
+			{
+				auto TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
+
+				auto VertexID0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]);
+				auto VertexID1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]);
+				auto VertexID2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]);
+
+				FTriIndices TriIndex;
+				TriIndex.v0 = VertexID0.GetValue();
+				TriIndex.v1 = VertexID1.GetValue();
+				TriIndex.v2 = VertexID2.GetValue();
+				Indices.Add(TriIndex);
+			}
+		}
+	}
+
+	return CollisionData;
 }
 
 } // namespace Vitruvio
@@ -0,0 +1,70 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Containers/Ticker.h"
+#include "UObject/WeakObjectPtr.h"
+
+enum class EApplyStepResult : uint8
+{
+	/** The step made progress and the job has more steps to run. */
+	Progress,
+	/** The job waits for asynchronous work, continue with the next job. */
+	Wait,
+	/** The job is complete. */
+	Done
+};
+
+/**
+ * Applies generate results in resumable steps within a frame time budget shared by all VitruvioComponents and VitruvioBatchActors
+ * (see vitruvio.ApplyBudgetMs). Jobs are run in the order they were scheduled and at least one step is run every frame.
+ */
+class FApplyScheduler
+{
+public:
+	using FApplyStep = TFunction<EApplyStepResult()>;
+	using FDroppedHandler = TFunction<void()>;
+
+	/**
+	 * \brief Schedules a job which repeatedly runs the given step until it returns Done. The job is dropped if the owner is destroyed or
+	 * the job is canceled, OnDropped is called then instead of the step so that the job can release what it holds.
+	 */
+	VITRUVIO_API void Schedule(const UObject* Owner, FApplyStep Step, FDroppedHandler OnDropped = {});
+
+	/**
+	 * \brief Cancels all jobs of the given owner.
+	 */
+	VITRUVIO_API void Cancel(const UObject* Owner);
+
+	void Start();
+	void Stop();
+
+private:
+	struct FJob
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		FApplyStep Step;
+		FDroppedHandler OnDropped;
+	};
+
+	// Only accessed on the game thread. Schedule appends jobs and Cancel only resets their owner, jobs are only removed by Tick (or Stop).
+	// Tick holds a reference to the running job and indexes into Jobs, so steps and drop handlers can safely schedule or cancel jobs,
+	// including their own.
+	TArray<TSharedRef<FJob>> Jobs;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	bool Tick(float DeltaTime);
+};
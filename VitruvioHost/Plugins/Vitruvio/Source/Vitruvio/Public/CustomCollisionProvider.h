@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VitruvioTypes.h"
+#include "Engine/StaticMesh.h"
 #include "Interfaces/Interface_CollisionDataProvider.h"
 #include "CustomCollisionProvider.generated.h"
 
@@ -10,11 +11,27 @@ class VITRUVIO_API UCustomCollisionDataProvider : public UObject, public IInterf
 	GENERATED_BODY()
 
 protected:
-	Vitruvio::FCollisionData CollisionData;
+	mutable Vitruvio::FCollisionData CollisionData;
+
+#if WITH_EDITOR
+	// Released collision data is rebuilt on demand from the mesh description of this mesh
+	TWeakObjectPtr<UStaticMesh> SourceMesh;
+#endif
+
+	bool RebuildCollisionData() const
+	{
+#if WITH_EDITOR
+		if (const FMeshDescription* MeshDescription = SourceMesh.IsValid() ? SourceMesh->GetMeshDescription(0) : nullptr)
+		{
+			CollisionData = Vitruvio::CreateCollisionData(*MeshDescription);
+		}
+#endif
+		return CollisionData.IsValid();
+	}
 	
 	bool UpdateTrieMeshCollisionData(FTriMeshCollisionData* TriCollisionData) const
 	{
-		if (!CollisionData.IsValid())
+		if (!CollisionData.IsValid() && !RebuildCollisionData())
 		{
 			return false;
 		}
@@ -35,11 +52,33 @@ public:
 		CollisionData = InCollisionData;
 	}
 
+	void SetCollisionData(Vitruvio::FCollisionData&& InCollisionData)
+	{
+		CollisionData = MoveTemp(InCollisionData);
+	}
+
 	void ClearCollisionData()
 	{
 		CollisionData = {};
 	}
 
+	/**
+	 * Releases the collision data in the editor, it is rebuilt on demand from the given mesh. At runtime the collision data is kept as
+	 * it is the only remaining source.
+	 */
+	void ReleaseCollisionData(UStaticMesh* InSourceMesh)
+	{
+#if WITH_EDITOR
+		SourceMesh = InSourceMesh;
+		CollisionData = {};
+#endif
+	}
+
+	SIZE_T GetCollisionDataSize() const
+	{
+		return CollisionData.Indices.GetAllocatedSize() + CollisionData.Vertices.GetAllocatedSize();
+	}
+
 	virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* TriCollisionData, bool InUseAllTriData) override
 	{
 		return UpdateTrieMeshCollisionData(TriCollisionData);
@@ -47,6 +86,12 @@ public:
 
 	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override
 	{
+#if WITH_EDITOR
+		if (SourceMesh.IsValid())
+		{
+			return true;
+		}
+#endif
 		return CollisionData.IsValid();
 	}
 };
\ No newline at end of file
@@ -17,6 +17,7 @@
 
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Interfaces/Interface_CollisionDataProvider.h"
+#include "MaterialCache.h"
 
 #include "GeneratedModelHISMComponent.generated.h"
 
@@ -36,6 +37,45 @@ public:
 		MeshIdentifier = NewMeshIdentifier;
 	}
 
+	/**
+	 * Adds the given instances with their per-instance custom data, which holds CustomDataFloatsPerInstance values per instance or is empty.
+	 */
+	void AddInstancesWithCustomData(const TArray<FTransform>& Transforms, const TArray<float>& CustomData, int32 CustomDataFloatsPerInstance)
+	{
+		if (CustomData.IsEmpty())
+		{
+			for (const FTransform& Transform : Transforms)
+			{
+				AddInstance(Transform);
+			}
+			return;
+		}
+
+		check(CustomData.Num() == Transforms.Num() * CustomDataFloatsPerInstance);
+		SetNumCustomDataFloats(CustomDataFloatsPerInstance);
+		for (int32 InstanceIndex = 0; InstanceIndex < Transforms.Num(); ++InstanceIndex)
+		{
+			const int32 NewInstanceIndex = AddInstance(Transforms[InstanceIndex]);
+			SetCustomData(NewInstanceIndex, MakeArrayView(CustomData.GetData() + InstanceIndex * CustomDataFloatsPerInstance, CustomDataFloatsPerInstance),
+						  false);
+		}
+	}
+
+	/**
+	 * Sets the references which keep the generated materials of this component cached, see FMaterialCache.
+	 */
+	void SetMaterialReferences(TArray<FMaterialReferencePtr> NewMaterialReferences)
+	{
+		MaterialReferences = MoveTemp(NewMaterialReferences);
+	}
+
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override
+	{
+		MaterialReferences.Empty();
+		Super::OnComponentDestroyed(bDestroyingHierarchy);
+	}
+
 private:
 	FString MeshIdentifier;
-};
\ No newline at end of file
+	TArray<FMaterialReferencePtr> MaterialReferences;
+};
@@ -17,6 +17,7 @@
 
 #include "Components/StaticMeshComponent.h"
 #include "Interfaces/Interface_CollisionDataProvider.h"
+#include "MaterialCache.h"
 
 #include "GeneratedModelStaticMeshComponent.generated.h"
 
@@ -24,5 +25,22 @@ UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class VITRUVIO_API UGeneratedModelStaticMeshComponent : public UStaticMeshComponent
 {
 	GENERATED_BODY()
-	
+
+public:
+	/**
+	 * Sets the references which keep the generated materials of this component cached, see FMaterialCache.
+	 */
+	void SetMaterialReferences(TArray<FMaterialReferencePtr> NewMaterialReferences)
+	{
+		MaterialReferences = MoveTemp(NewMaterialReferences);
+	}
+
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override
+	{
+		MaterialReferences.Empty();
+		Super::OnComponentDestroyed(bDestroyingHierarchy);
+	}
+
+private:
+	TArray<FMaterialReferencePtr> MaterialReferences;
 };
\ No newline at end of file
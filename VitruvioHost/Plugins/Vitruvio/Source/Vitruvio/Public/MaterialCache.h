@@ -0,0 +1,100 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Materials/MaterialInstanceDynamic.h"
+#include "UObject/GCObject.h"
+
+/**
+ * Keeps a cached material from being evicted as long as it is held by any of the meshes and components which use the material.
+ */
+class FMaterialReference
+{
+public:
+	explicit FMaterialReference(Vitruvio::FMaterialId Id) : Id(Id) {}
+
+	Vitruvio::FMaterialId GetId() const
+	{
+		return Id;
+	}
+
+private:
+	Vitruvio::FMaterialId Id;
+};
+using FMaterialReferencePtr = TSharedPtr<FMaterialReference>;
+
+struct FMaterialCacheStats
+{
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+	int32 NumMaterials = 0;
+	int32 NumReferencedMaterials = 0;
+};
+
+/**
+ * Caches the materials created for generated models by their material id. Only accessed on the game thread.
+ *
+ * The cache keeps its materials alive. Once it holds more materials than its budget (vitruvio.MaterialCache.Budget), the least recently
+ * used ones which are not referenced anymore are evicted, releasing the materials and the textures only they used.
+ */
+class FMaterialCache
+{
+public:
+	/**
+	 * \brief Returns the cached material and sets the reference which keeps it cached, or returns nullptr if it is not cached.
+	 */
+	VITRUVIO_API UMaterialInstanceDynamic* Get(Vitruvio::FMaterialId Id, FMaterialReferencePtr& OutReference);
+
+	/**
+	 * \brief Inserts the given material and returns the reference which keeps it cached.
+	 */
+	VITRUVIO_API FMaterialReferencePtr Add(Vitruvio::FMaterialId Id, UMaterialInstanceDynamic* Material);
+
+	/**
+	 * \brief Evicts the least recently used materials which are not referenced until the cache is within its budget again.
+	 */
+	VITRUVIO_API void EvictUnreferenced();
+
+	VITRUVIO_API void ForEachMaterial(TFunctionRef<void(const UMaterialInstanceDynamic*)> Function) const;
+
+	VITRUVIO_API FMaterialCacheStats GetStats() const;
+
+	VITRUVIO_API void Empty();
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FEntry
+	{
+		TObjectPtr<UMaterialInstanceDynamic> Material;
+		TWeakPtr<FMaterialReference> Reference;
+
+		// Keeps the material's entry in the FMaterialInternTable until this entry is evicted, null for materials which were not interned
+		TSharedPtr<const Vitruvio::FMaterialAttributeContainer> InternedMaterial;
+		uint64 LastUsed = 0;
+	};
+
+	TMap<Vitruvio::FMaterialId, FEntry> Entries;
+
+	uint64 UseCounter = 0;
+
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
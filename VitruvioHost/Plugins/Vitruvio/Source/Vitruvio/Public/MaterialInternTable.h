@@ -0,0 +1,47 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "VitruvioTypes.h"
+
+/**
+ * Global table of all distinct material attribute containers by their FMaterialId.
+ *
+ * The table does not own its materials. An interned material stays in the table as long as the returned reference is held, which are the
+ * generate results until they are applied and the material cache until the material created from it is evicted (see FMaterialCache).
+ */
+class FMaterialInternTable
+{
+public:
+	VITRUVIO_API TSharedRef<const Vitruvio::FMaterialAttributeContainer> Intern(const Vitruvio::FMaterialAttributeContainer& Material);
+	VITRUVIO_API TSharedPtr<const Vitruvio::FMaterialAttributeContainer> Get(Vitruvio::FMaterialId Id) const;
+
+	/**
+	 * \brief Removes the entries of all materials which are not referenced anymore.
+	 */
+	VITRUVIO_API void RemoveUnreferenced();
+
+	VITRUVIO_API int32 Num() const;
+
+private:
+	void RemoveUnreferencedLocked();
+
+	mutable FCriticalSection MaterialInternTableCriticalSection;
+
+	TMap<Vitruvio::FMaterialId, TWeakPtr<const Vitruvio::FMaterialAttributeContainer>> Materials;
+
+	// Unreferenced entries are also removed whenever the table has grown to this size, so it stays bounded without explicit cleanups
+	int32 RemoveUnreferencedThreshold = 256;
+};
@@ -16,15 +16,51 @@
 #pragma once
 #include "VitruvioMesh.h"
 
+/**
+ * \brief Identifies a generated model. Models with the same content hash are only shared if their counts, materials and vertex
+ * positions are equal as well.
+ */
+struct FModelKey
+{
+	uint64 ContentHash = 0;
+	int32 NumVertexInstances = 0;
+	int32 NumTriangles = 0;
+	TArray<Vitruvio::FMaterialId> MaterialIds;
+	TArray<FVector3f> VertexPositions;
+
+	bool operator==(const FModelKey& Other) const
+	{
+		return ContentHash == Other.ContentHash && NumVertexInstances == Other.NumVertexInstances && NumTriangles == Other.NumTriangles &&
+			   MaterialIds == Other.MaterialIds && VertexPositions == Other.VertexPositions;
+	}
+
+	friend uint32 GetTypeHash(const FModelKey& Key)
+	{
+		return GetTypeHash(Key.ContentHash);
+	}
+};
+
 class FMeshCache
 {
 public:
 	VITRUVIO_API TSharedPtr<FVitruvioMesh> Get(const FString& Uri);
 	VITRUVIO_API TSharedPtr<FVitruvioMesh> InsertOrGet(const FString& Uri, const TSharedPtr<FVitruvioMesh>& Mesh);
+
+	/**
+	 * Generated models are shared by their content hash. Models are not kept alive by the cache and are released once they are not
+	 * referenced anymore.
+	 */
+	VITRUVIO_API TSharedPtr<FVitruvioMesh> GetModel(const FModelKey& Key);
+	VITRUVIO_API TSharedPtr<FVitruvioMesh> InsertOrGetModel(const FModelKey& Key, const TSharedPtr<FVitruvioMesh>& Mesh);
+
 	VITRUVIO_API void Empty();
 
 private:
-	FCriticalSection MeshCacheCriticalSection;
+	mutable FCriticalSection MeshCacheCriticalSection;
 
 	TMap<FString, TSharedPtr<FVitruvioMesh>> Cache;
+	TMap<FModelKey, TWeakPtr<FVitruvioMesh>> ModelCache;
+
+	// Released models are removed whenever the model cache has grown to this size, so inserts do not have to sweep the whole cache
+	int32 RemoveReleasedModelsThreshold = 256;
 };
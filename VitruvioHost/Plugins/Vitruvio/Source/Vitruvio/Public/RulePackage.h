@@ -32,6 +32,10 @@ public:
 	UPROPERTY()
 	FString SourcePath;
 
+	/** Maximum width and height of the textures generated from this rule package, overrides vitruvio.Textures.MaxResolution if not 0. */
+	UPROPERTY(EditAnywhere, Category = "Textures", meta = (ClampMin = 0))
+	int32 MaxTextureResolution = 0;
+
 	virtual void PreSave(FObjectPreSaveContext SaveContext) override
 	{
 		Super::PreSave(SaveContext);
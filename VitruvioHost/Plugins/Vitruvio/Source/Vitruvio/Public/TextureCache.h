@@ -0,0 +1,164 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Async/Future.h"
+#include "UObject/GCObject.h"
+
+struct FTextureCacheStats
+{
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+	uint64 Prefetches = 0;
+	uint64 DeduplicatedTextures = 0;
+	SIZE_T SavedBytes = 0;
+	int32 NumTextures = 0;
+	int32 NumPendingLoads = 0;
+	SIZE_T SizeBytes = 0;
+};
+
+/**
+ * Caches decoded textures by the hash of their decoded content, files with identical pixels share one texture. Lookups go through the
+ * path of the texture file, the material property it is used for, since the property determines the texture settings, and the maximum
+ * resolution it is decoded with (see VitruvioModule::GetMaxTextureResolution). Textures
+ * which are still being decoded are tracked by the same key, so that every file is only decoded once per property and resolution no
+ * matter how many materials request it.
+ *
+ * The cache keeps its textures alive. Once the textures exceed the memory budget (vitruvio.TextureCache.BudgetMB), the least recently used
+ * ones which are not referenced anymore are evicted.
+ */
+class FTextureCache
+{
+public:
+	/**
+	 * \brief Returns the cached texture of the given file used for the given material property if there is one and marks it as used.
+	 */
+	VITRUVIO_API TOptional<Vitruvio::FTextureData> Get(const FString& Path, const FString& Key);
+
+	/**
+	 * \brief Returns the texture of the given file. It is either already cached, currently being decoded or decoding is started in the
+	 * background.
+	 *
+	 * @param Key the material property of the texture, which determines its texture settings.
+	 */
+	VITRUVIO_API TSharedFuture<Vitruvio::FTextureData> Load(const FString& Path, const FString& Key);
+
+	/**
+	 * \brief Returns the cached texture with the given content hash if there is one, eg to share it with another file with identical
+	 * pixels instead of creating a new texture.
+	 */
+	VITRUVIO_API TOptional<Vitruvio::FTextureData> FindByContentHash(uint64 ContentHash);
+
+	/**
+	 * \brief Starts decoding the texture of the given file in the background unless it is already cached or being decoded. Can be called
+	 * from any thread, eg as soon as the texture is referenced by a generated material.
+	 */
+	VITRUVIO_API void Prefetch(const FString& Path, const FString& Key);
+
+	/**
+	 * \brief Inserts the texture decoded from the given file. If a texture with the same content is already cached, the cached one is
+	 * returned instead and used for this file as well.
+	 *
+	 * @param LoadGeneration the generation of the cache when decoding started (see GetGeneration). Textures decoded before the cache has
+	 * been emptied are returned without being inserted.
+	 */
+	VITRUVIO_API Vitruvio::FTextureData InsertOrGet(const FString& Path, const FString& Key, int32 MaxResolution, uint64 LoadGeneration,
+													const Vitruvio::FTextureData& TextureData);
+
+	/**
+	 * \returns the generation of the cache, which changes whenever the cache is emptied.
+	 */
+	VITRUVIO_API uint64 GetGeneration() const;
+
+	/**
+	 * \brief Removes the textures whose files have changed since they were decoded. This accesses the file system and is meant to be
+	 * called off the game thread. Calls within vitruvio.TextureCache.RevalidateInterval seconds of the last one are skipped.
+	 */
+	VITRUVIO_API void Revalidate();
+
+	VITRUVIO_API bool IsOverBudget() const;
+
+	/**
+	 * \brief Evicts the least recently used textures which are not referenced until the cache is within its budget again.
+	 *
+	 * @param IsReferenced returns whether a texture is still in use and must not be evicted.
+	 */
+	VITRUVIO_API void EvictUnreferenced(TFunctionRef<bool(const UTexture2D*)> IsReferenced);
+
+	VITRUVIO_API FTextureCacheStats GetStats() const;
+
+	VITRUVIO_API void Empty();
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FEntry
+	{
+		Vitruvio::FTextureData TextureData;
+		TObjectPtr<UTexture2D> Texture;
+		SIZE_T SizeBytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	// The same file used for different material properties or with a different maximum resolution results in different textures
+	struct FPathKey
+	{
+		FString Path;
+		FString Key;
+		int32 MaxResolution = 0;
+
+		bool operator==(const FPathKey& Other) const
+		{
+			return Path == Other.Path && Key == Other.Key && MaxResolution == Other.MaxResolution;
+		}
+
+		friend uint32 GetTypeHash(const FPathKey& PathKey)
+		{
+			return HashCombine(HashCombine(GetTypeHash(PathKey.Path), GetTypeHash(PathKey.Key)), GetTypeHash(PathKey.MaxResolution));
+		}
+	};
+
+	struct FPathEntry
+	{
+		uint64 ContentHash = 0;
+		FDateTime LoadTime;
+	};
+
+	mutable FCriticalSection TextureCacheCriticalSection;
+
+	TMap<uint64, FEntry> Entries;
+	TMap<FPathKey, FPathEntry> Paths;
+	TMap<FPathKey, TSharedFuture<Vitruvio::FTextureData>> PendingLoads;
+
+	uint64 UseCounter = 0;
+	uint64 Generation = 0;
+	double LastRevalidateTime = 0.0;
+
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+	uint64 Prefetches = 0;
+	uint64 DeduplicatedTextures = 0;
+	SIZE_T SavedBytes = 0;
+	SIZE_T SizeBytes = 0;
+
+	FEntry* FindEntry(const FPathKey& PathKey);
+	TSharedFuture<Vitruvio::FTextureData> StartLoad(const FPathKey& PathKey);
+	void RemoveEntry(uint64 ContentHash);
+};
@@ -0,0 +1,86 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+namespace Vitruvio
+{
+
+struct FTextureCompressionSettings
+{
+	/** Whether the full mip chain is generated for decoded textures. */
+	bool bGenerateMips = false;
+
+	/** Whether decoded 8 bit textures are compressed to BC formats. */
+	bool bCompress = false;
+
+	/** Maximum width and height of decoded textures, larger ones are downsampled. 0 keeps the source resolution. */
+	int32 MaxResolution = 0;
+};
+
+/**
+ * Returns the texture compression settings configured by the vitruvio.Textures.* console variables.
+ */
+VITRUVIO_API FTextureCompressionSettings GetTextureCompressionSettings();
+
+struct FTextureMipData
+{
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	TArray64<uint8> Data;
+};
+
+/**
+ * Returns the block compressed format a decoded PF_B8G8R8A8 texture is compressed to depending on the material map it is used for
+ * (normalMap: BC5, grayscale roughnessMap and metallicMap: BC4, textures with alpha: BC3, otherwise BC1) or PF_Unknown if it stays
+ * uncompressed.
+ */
+VITRUVIO_API EPixelFormat GetCompressedPixelFormat(const FString& Key, EPixelFormat PixelFormat, uint32 NumChannels, int32 SizeX, int32 SizeY);
+
+/**
+ * Generates the mip chain of the given uncompressed image using a box filter. Supports PF_B8G8R8A8, PF_A16B16G16R16 and PF_FloatRGBA.
+ *
+ * @return the mips from level 1 down to 1x1, the given image is level 0.
+ */
+VITRUVIO_API TArray<FTextureMipData> GenerateMips(const uint8* Pixels, int32 SizeX, int32 SizeY, EPixelFormat PixelFormat);
+
+/**
+ * Downsamples the given uncompressed image so that its longer side is MaxSize and the shorter one keeps the aspect ratio (rounded down to a
+ * multiple of 4 for block compression). Halves with the box filter of GenerateMips as long as possible and resamples the remaining
+ * reduction with an area filter. Supports the same pixel formats as GenerateMips.
+ *
+ * @return the downsampled image or an empty array if the image already fits. InOutSizeX and InOutSizeY are updated accordingly.
+ */
+VITRUVIO_API TArray64<uint8> DownsampleToMaxSize(const uint8* Pixels, int32& InOutSizeX, int32& InOutSizeY, int32 MaxSize, EPixelFormat PixelFormat);
+
+/**
+ * Compresses the given PF_B8G8R8A8 image to PF_DXT1 (BC1), PF_DXT5 (BC3), PF_BC4 or PF_BC5.
+ */
+VITRUVIO_API TArray64<uint8> CompressBlocks(const uint8* Pixels, int32 SizeX, int32 SizeY, EPixelFormat CompressedFormat);
+
+/**
+ * Decompresses a PF_DXT1, PF_DXT5, PF_BC4 or PF_BC5 image created by CompressBlocks back to PF_B8G8R8A8.
+ */
+VITRUVIO_API TArray64<uint8> DecompressBlocks(const uint8* Blocks, int32 SizeX, int32 SizeY, EPixelFormat CompressedFormat);
+
+/**
+ * Returns whether the given pixel format is one of the block compressed formats created by CompressBlocks.
+ */
+VITRUVIO_API bool IsBlockCompressed(EPixelFormat PixelFormat);
+
+} // namespace Vitruvio
@@ -17,6 +17,7 @@
 
 #include "CoreMinimal.h"
 
+#include "VitruvioComponent.h"
 #include "VitruvioModule.h"
 #include "GenerateCompletedCallbackProxy.h"
 
@@ -66,6 +67,14 @@ struct FGrid
 	UPROPERTY()
 	TMap<UVitruvioComponent*, UTile*> TilesByComponent;
 
+	// Tiles marked for generate, so that processing them does not need to visit the whole grid
+	UPROPERTY()
+	TSet<UTile*> DirtyTiles;
+
+	// Tiles whose generate result has not been applied yet
+	UPROPERTY()
+	TSet<UTile*> GeneratingTiles;
+
 	void MarkForGenerate(UVitruvioComponent* VitruvioComponent, UGenerateCompletedCallbackProxy* CallbackProxy = nullptr);
 	void MarkAllForGenerate();
 	
@@ -77,15 +86,29 @@ struct FGrid
 
 	TArray<UTile*> GetTilesMarkedForGenerate() const;
 	void UnmarkForGenerate();
+
+	void SetGenerating(UTile* Tile, bool bIsGenerating);
+	bool IsGenerating() const;
+
+private:
+	void MarkForGenerate(UTile* Tile, UVitruvioComponent* VitruvioComponent, UGenerateCompletedCallbackProxy* CallbackProxy = nullptr);
 };
 
 struct FBatchGenerateQueueItem
 {
 	FGenerateResultDescription GenerateResultDescription;
-	UTile* Tile;
+	TWeakObjectPtr<UTile> Tile;
+	// Invalidated once the tile is generated again or cleared, the result is dropped then
+	FBatchGenerateResult::FTokenConstPtr Token;
 	TArray<UVitruvioComponent*> VitruvioComponents;
 };
 
+struct FPendingBatchGenerateResult
+{
+	FBatchGenerateQueueItem Item;
+	FApplyGenerateResultState State;
+};
+
 UCLASS(NotBlueprintable, NotPlaceable)
 class VITRUVIO_API AVitruvioBatchActor : public AActor
 {
@@ -106,6 +129,9 @@ private:
 
 	TQueue<FBatchGenerateQueueItem> GenerateQueue;
 
+	// Generate result whose meshes are still being built asynchronously
+	TOptional<FPendingBatchGenerateResult> PendingGenerateResult;
+
 	UPROPERTY(Transient)
 	TMap<UMaterialInterface*, FString> MaterialIdentifiers;
 	TMap<FString, int32> UniqueMaterialIdentifiers;
@@ -172,6 +198,9 @@ public:
 private:
 	void ProcessTiles();
 	void ProcessGenerateQueue();
+	EApplyStepResult ApplyGenerateResultStep();
+	void CancelPendingGenerateResult();
+	void ClearGrid();
 
 	FCriticalSection ProcessQueueCriticalSection;
 
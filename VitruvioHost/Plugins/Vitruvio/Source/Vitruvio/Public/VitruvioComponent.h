@@ -64,6 +64,9 @@ struct FInstance
 	TSharedPtr<FVitruvioMesh> InstanceMesh;
 	TArray<UMaterialInstanceDynamic*> OverrideMaterials;
 	TArray<FTransform> Transforms;
+	TArray<float> CustomData;
+	int32 NumCustomDataFloats = 0;
+	TArray<FMaterialReferencePtr> OverrideMaterialReferences;
 
 	friend FORCEINLINE uint32 GetTypeHash(const FInstance& Request)
 	{
@@ -88,13 +91,49 @@ struct FConvertedGenerateResult
 	TMap<FString, FReport> Reports;
 };
 
-FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
-									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-									 TMap<FString, Vitruvio::FTextureData>& TextureCache,
-									 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
-									 TMap<FString, int32>& UniqueMaterialIdentifiers,
-									 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-									 UWorld* World);
+enum class EApplyGenerateResultStage : uint8
+{
+	BuildShapeMesh,
+	BuildInstanceMeshes,
+	ConvertInstances,
+	FinishMeshes,
+	UpdateComponents,
+	AddInstances
+};
+
+/** Progress of applying a generate result across several frames. */
+struct FApplyGenerateResultState
+{
+	EApplyGenerateResultStage Stage = EApplyGenerateResultStage::BuildShapeMesh;
+	int32 StepIndex = 0;
+
+	TArray<FString> InstanceMeshIds;
+	TArray<Vitruvio::FInstanceCacheKey> InstanceKeys;
+	FConvertedGenerateResult ConvertedResult;
+
+	TWeakObjectPtr<UGeneratedModelStaticMeshComponent> ModelComponent;
+	TMap<FString, int32> NameMap;
+	TSet<FInstance> Replaced;
+};
+
+struct FPendingGenerateResult
+{
+	FGenerateQueueItem Item;
+	FApplyGenerateResultState State;
+};
+
+/**
+ * \brief Runs the next step of building the meshes and materials of the given generate result. Once all meshes are built the stage
+ * of the state is UpdateComponents and the remaining steps are up to the caller. Instance transforms and reports are moved out of
+ * the generate result into the converted result of the state.
+ */
+EApplyStepResult BuildGenerateResultStep(FGenerateResultDescription& GenerateResult, FApplyGenerateResultState& State,
+										 FMaterialCache& MaterialCache,
+										 FTextureCache& TextureCache,
+										 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+										 TMap<FString, int32>& UniqueMaterialIdentifiers,
+										 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+										 UWorld* World);
 
 FString UniqueComponentName(const FString& Name, TMap<FString, int32>& UsedNames);
 
@@ -104,7 +143,7 @@ void ApplyMaterialReplacements(UStaticMeshComponent* StaticMeshComponent, const
 TSet<FInstance> ApplyInstanceReplacements(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, 
 											  const TArray<FInstance>& Instances, UInstanceReplacementAsset* Replacement, TMap<FString, int32>& NameMap);
 
-void InitializeBodySetup(UBodySetup* BodySetup);
+void InitializeBodySetup(UBodySetup* BodySetup, bool bAsyncCook = false);
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class VITRUVIO_API UVitruvioComponent : public UActorComponent
@@ -481,6 +520,10 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, DisplayName = "Random Seed", Category = "Vitruvio", meta = (AllowPrivateAccess = "true"))
 	int32 RandomSeed;
 
+	/** Whether CGA Reports are collected during generation. Reports are not available in batch generation. */
+	UPROPERTY(EditAnywhere, DisplayName = "Generate Reports", Category = "Vitruvio")
+	bool bGenerateReports = true;
+
 	/** CGA Reports from generation. */
 	UPROPERTY(VisibleAnywhere, DisplayName = "Reports", Category = "Vitruvio")
 	TMap<FString, FReport> Reports;
@@ -497,6 +540,9 @@ private:
 	TQueue<FGenerateQueueItem> GenerateQueue;
 	TQueue<FAttributesEvaluationQueueItem> AttributesEvaluationQueue;
 
+	// Generate result whose meshes are still being built asynchronously
+	TOptional<FPendingGenerateResult> PendingGenerateResult;
+
 	FGenerateResult::FTokenPtr GenerateToken;
 	FAttributeMapResult::FTokenPtr EvalAttributesInvalidationToken;
 
@@ -512,6 +558,7 @@ private:
 	void NotifyAttributesChanged();
 
 	void ProcessGenerateQueue();
+	EApplyStepResult ApplyGenerateResultStep();
 	void ProcessAttributesEvaluationQueue();
 
 #if WITH_EDITOR
@@ -16,16 +16,28 @@
 #pragma once
 
 #include "CustomCollisionProvider.h"
+#include "MaterialCache.h"
 #include "MeshDescription.h"
+#include "StaticMeshResources.h"
+#include "TextureCache.h"
 #include "VitruvioTypes.h"
 #include "Runtime/PhysicsCore/Public/Interface_CollisionDataProviderCore.h"
+#include "Tasks/Task.h"
+
+namespace Vitruvio
+{
+struct FTextureAtlasPage;
+}
 
 
+/**
+ * Returns the cached material for the given attributes or creates it. The returned reference keeps the material cached and has to be held
+ * as long as the material is used.
+ */
 UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-										TMap<FString, Vitruvio::FTextureData>& TextureCache,
-										TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+										FTextureCache& TextureCache, FMaterialCache& MaterialCache,
 										const Vitruvio::FMaterialAttributeContainer& MaterialAttributes, TMap<FString, int32>& UniqueMaterialNames,
-										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer);
+										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer, FMaterialReferencePtr& OutReference);
 
 class FVitruvioMesh
 {
@@ -37,6 +49,33 @@ class FVitruvioMesh
 	UStaticMesh* StaticMesh;
 	UCustomCollisionDataProvider* CollisionDataProvider;
 
+	// Keep the materials of the static mesh cached as long as this mesh exists
+	TArray<FMaterialReferencePtr> MaterialReferences;
+
+	// Keep the atlas pages used by the materials registered, they are needed whenever a material is created again
+	TArray<TSharedPtr<const Vitruvio::FTextureAtlasPage>> TextureAtlasPages;
+
+	// Render and collision data built asynchronously by BuildTask and handed over to the UObjects in FinishBuild
+	UE::Tasks::FTask BuildTask;
+	TUniquePtr<FStaticMeshRenderData> RenderData;
+	Vitruvio::FCollisionData CollisionData;
+
+	// Optional simplified LODs (LOD1 and up), see vitruvio.LOD.ScreenSizes
+	TArray<FMeshDescription> LODMeshDescriptions;
+	TArray<float> LODScreenSizes;
+	bool bRenderDataFinished = false;
+	bool bSourceDataReleased = false;
+
+	// Time spent on the game thread in Build and FinishBuild, reported once the mesh is completely built
+	double GameThreadBuildSeconds = 0.0;
+	double GameThreadFinishBuildSeconds = 0.0;
+	bool bGameThreadTimeReported = false;
+
+	void BuildRenderAndCollisionData();
+	bool TryFinishBuild();
+	void ReportGameThreadTime();
+	void ReleaseSourceData();
+
 public:
 	FVitruvioMesh(const FString& Identifier, const FMeshDescription& MeshDescription,
 				  const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
@@ -61,8 +100,33 @@ public:
 		return StaticMesh;
 	}
 
-	void Build(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-			   TMap<FString, Vitruvio::FTextureData>& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
-			   TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+	const TArray<FMaterialReferencePtr>& GetMaterialReferences() const
+	{
+		return MaterialReferences;
+	}
+
+	void SetTextureAtlasPages(TArray<TSharedPtr<const Vitruvio::FTextureAtlasPage>> Pages)
+	{
+		TextureAtlasPages = MoveTemp(Pages);
+	}
+
+	/**
+	 * \brief Creates the UStaticMesh and its materials on the game thread and starts building the render and collision data
+	 * on a worker thread. The mesh can only be assigned to components after FinishBuild returned true.
+	 */
+	void Build(const FString& Name, FMaterialCache& MaterialCache, FTextureCache& TextureCache,
+			   TMap<UMaterialInterface*, FString>& MaterialIdentifiers, TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
 			   UWorld* World);
+
+	/**
+	 * \brief Hands the asynchronously built render data over to the UStaticMesh and starts cooking its collision.
+	 *
+	 * @return true if the UStaticMesh is completely built and can be assigned to components.
+	 */
+	bool FinishBuild();
+
+	/**
+	 * \brief Returns the approximate memory in bytes used by the source data (mesh descriptions and collision data) of this mesh.
+	 */
+	SIZE_T GetSourceDataSize() const;
 };
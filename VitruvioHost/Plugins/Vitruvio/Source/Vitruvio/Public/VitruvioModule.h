@@ -15,12 +15,16 @@
 
 #pragma once
 
+#include "ApplyScheduler.h"
 #include "AttributeMap.h"
 #include "InitialShape.h"
+#include "MaterialCache.h"
+#include "MaterialInternTable.h"
 #include "MeshCache.h"
 #include "PRTTypes.h"
 #include "Report.h"
 #include "RulePackage.h"
+#include "TextureCache.h"
 
 #include "prt/Object.h"
 
@@ -37,8 +41,25 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealPrt, Log, All);
 
+namespace Vitruvio
+{
+struct FTextureMetadata;
+struct FTexturePixels;
+} // namespace Vitruvio
+
+/**
+ * \brief The result of a generate call. It is move-only since the instance maps can get very large, it is moved from the output
+ * handler all the way to where it is applied.
+ */
 struct FGenerateResultDescription
 {
+	FGenerateResultDescription() = default;
+	FGenerateResultDescription(FGenerateResultDescription&&) = default;
+	FGenerateResultDescription& operator=(FGenerateResultDescription&&) = default;
+
+	FGenerateResultDescription(const FGenerateResultDescription&) = delete;
+	FGenerateResultDescription& operator=(const FGenerateResultDescription&) = delete;
+
 	TSharedPtr<FVitruvioMesh> GeneratedModel;
 	
 	Vitruvio::FInstanceMap Instances;
@@ -118,12 +139,29 @@ public:
 	void ShutdownModule() override;
 
 	/**
-	 * \brief Decodes the given texture.
+	 * \brief Decodes the given texture, downsampling it to MaxResolution if that is not 0.
+	 */
+	VITRUVIO_API Vitruvio::FTextureData DecodeTexture(UObject* Outer, const FString& Path, const FString& Key, int32 MaxResolution) const;
+
+	/**
+	 * \brief Returns the maximum resolution of the given texture, the override of the rule package it belongs to or
+	 * vitruvio.Textures.MaxResolution. 0 keeps the source resolution.
 	 */
-	VITRUVIO_API Vitruvio::FTextureData DecodeTexture(UObject* Outer, const FString& Path, const FString& Key) const;
+	VITRUVIO_API int32 GetMaxTextureResolution(const FString& Path) const;
 
 	/**
-	 * \brief Asynchronously evaluates the attributes and generates the models for all given InitialShapes.
+	 * \brief Reads the size and format of the given texture without reading its pixels.
+	 */
+	Vitruvio::FTextureMetadata ReadTextureMetadata(const FString& Path) const;
+
+	/**
+	 * \brief Reads the undecoded pixels of the given texture.
+	 */
+	Vitruvio::FTexturePixels ReadTexture(const FString& Path) const;
+
+	/**
+	 * \brief Asynchronously evaluates the attributes and generates the models for all given InitialShapes. Reports are not collected in
+	 * batch mode.
 	 *
 	 * \param InitialShapes
 	 * \return the generated UStaticMesh.
@@ -142,18 +180,20 @@ public:
 	 * \brief Asynchronously generate the models with the given InitialShape, RulePackage and Attributes.
 	 *
 	 * \param InitialShape
+	 * \param bEmitReports whether CGA reports should be collected, pass false if the reports are not read
 	 * \return the generated UStaticMesh.
 	 */
-	VITRUVIO_API FGenerateResult GenerateAsync(FInitialShape InitialShape) const;
+	VITRUVIO_API FGenerateResult GenerateAsync(FInitialShape InitialShape, bool bEmitReports = true) const;
 
 
 	/**
 	 * \brief Generate the models with the given InitialShape, RulePackage and Attributes.
 	 *
 	 * \param InitialShape
+	 * \param bEmitReports whether CGA reports should be collected, pass false if the reports are not read
 	 * \return the generated UStaticMesh.
 	 */
-	VITRUVIO_API FGenerateResultDescription Generate(const FInitialShape& InitialShape) const;
+	VITRUVIO_API FGenerateResultDescription Generate(const FInitialShape& InitialShape, bool bEmitReports = true) const;
 
 	/**
 	 * \brief Asynchronously evaluates attributes for the given initial shape and rule package.
@@ -199,11 +239,27 @@ public:
 	/**
 	 * \returns the cache used for materials generated by PRT.
 	 */
-	VITRUVIO_API TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& GetMaterialCache()
+	VITRUVIO_API FMaterialCache& GetMaterialCache()
 	{
 		return MaterialCache;
 	}
 
+	/**
+	 * \returns the table of all materials referenced by FMaterialId.
+	 */
+	VITRUVIO_API FMaterialInternTable& GetMaterialInternTable()
+	{
+		return MaterialInternTable;
+	}
+
+	/**
+	 * \returns the scheduler which applies generate results within the frame time budget.
+	 */
+	VITRUVIO_API FApplyScheduler& GetApplyScheduler()
+	{
+		return ApplyScheduler;
+	}
+
 	/**
 	 * \returns the cache used for instanced meshes by PRT.
 	 */
@@ -213,20 +269,26 @@ public:
 	}
 
 	/**
-	 * \returns the cache used for materials generated by PRT.
+	 * \returns the cache used for textures decoded from PRT materials.
 	 */
-	VITRUVIO_API TMap<FString, Vitruvio::FTextureData>& GetTextureCache()
+	VITRUVIO_API FTextureCache& GetTextureCache()
 	{
 		return TextureCache;
 	}
 
 	/**
-	 * Registers a generated mesh to keep it from being garbage collected.
+	 * Blocks until all textures still being decoded are bound to their generated materials, eg before the materials are cooked.
+	 */
+	VITRUVIO_API void FlushPendingTextureBindings() const;
+
+	/**
+	 * Registers a generated mesh to keep it from being garbage collected. Only call on the game thread.
 	 */
 	VITRUVIO_API void RegisterMesh(UStaticMesh* StaticMesh);
 
 	/**
-	 * Unregisters a generated mesh and therefore allows the garbage collector to delete it if it not referenced anywhere else.
+	 * Unregisters a generated mesh and therefore allows the garbage collector to delete it if it not referenced anywhere else. Only call on
+	 * the game thread.
 	 */
 	VITRUVIO_API void UnregisterMesh(UStaticMesh* StaticMesh);
 
@@ -244,11 +306,7 @@ public:
 	 */
 	FOnAllGenerateCompleted OnAllGenerateCompleted;
 
-	void AddReferencedObjects(FReferenceCollector& Collector) override
-	{
-		Collector.AddReferencedObjects(MaterialCache);
-		Collector.AddReferencedObjects(RegisteredMeshes);
-	}
+	void AddReferencedObjects(FReferenceCollector& Collector) override;
 
 	FString GetReferencerName() const override
 	{
@@ -277,6 +335,12 @@ private:
 	mutable TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr> ResolveMapCache;
 	mutable TMap<TLazyObjectPtr<URulePackage>, FGraphEventRef> ResolveMapEventGraphRefCache;
 
+	// Texture resolution overrides of the loaded rule packages by their rpk uri, which prefixes the uris of their textures. They are
+	// copied from the rule packages when these are loaded or changed, so that texture lookups on any thread only read plain values.
+	mutable TMap<FString, int32> RpkMaxTextureResolutions;
+	mutable TMap<TLazyObjectPtr<URulePackage>, FString> RpkUris;
+	mutable FRWLock MaxTextureResolutionLock;
+
 	mutable FCriticalSection LoadResolveMapLock;
 
 	mutable FThreadSafeCounter GenerateCallsCounter;
@@ -285,9 +349,11 @@ private:
 
 	FString RpkFolder;
 
-	TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>> MaterialCache;
-	TMap<FString, Vitruvio::FTextureData> TextureCache;
+	FMaterialCache MaterialCache;
+	mutable FTextureCache TextureCache;
+	FMaterialInternTable MaterialInternTable;
 	FMeshCache MeshCache;
+	FApplyScheduler ApplyScheduler;
 
 	FCriticalSection RegisterMeshLock;
 	TSet<TObjectPtr<UStaticMesh>> RegisteredMeshes;
@@ -298,4 +364,7 @@ private:
 	void InitializePrt();
 
 	VITRUVIO_API void EvictFromResolveMapCache(URulePackage* RulePackage);
+
+	// Copies the texture resolution override of the given rule package after it has been changed in the editor
+	VITRUVIO_API void UpdateMaxTextureResolution(URulePackage* RulePackage);
 };
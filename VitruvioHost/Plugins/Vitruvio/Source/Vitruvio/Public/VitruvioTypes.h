@@ -17,6 +17,7 @@
 
 #include "Interface_CollisionDataProviderCore.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "MeshDescription.h"
 #include "Misc/Paths.h"
 
 #include "prt/AttributeMap.h"
@@ -82,6 +83,12 @@ enum class EPrtUvSetType : int32
 
 const FString CityEngineDefaultMaterialName("CityEngineMaterial");
 
+/**
+ * Stable id of a material, computed from a 64 bit content hash of its attributes. Used as key instead of the material attributes
+ * themselves to avoid hashing and comparing their string maps.
+ */
+using FMaterialId = uint64;
+
 struct FMaterialAttributeContainer
 {
 	TMap<FString, FString> TextureProperties;
@@ -92,17 +99,18 @@ struct FMaterialAttributeContainer
 	FString BlendMode;
 	FString Name; // ignored on purpose for hash and equality
 
-	explicit FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap);
+	FMaterialId Id = 0; // computed on construction, UpdateId must be called if the properties are modified afterwards
+
+	explicit FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap, const TMap<FString, double>& AdditionalScalarProperties = {});
+
+	/**
+	 * \brief Recomputes the id from the current properties.
+	 */
+	void UpdateId();
 
 	friend bool operator==(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
 	{
-		// clang-format off
-		return Lhs.TextureProperties.OrderIndependentCompareEqual(RHS.TextureProperties) &&
-			   Lhs.ColorProperties.OrderIndependentCompareEqual(RHS.ColorProperties) &&
-			   Lhs.ScalarProperties.OrderIndependentCompareEqual(RHS.ScalarProperties) &&
-			   Lhs.StringProperties.OrderIndependentCompareEqual(RHS.StringProperties) && 
-			   Lhs.BlendMode == RHS.BlendMode;
-		// clang-format on
+		return Lhs.Id == RHS.Id;
 	}
 
 	friend bool operator!=(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
@@ -110,7 +118,21 @@ struct FMaterialAttributeContainer
 		return !(Lhs == RHS);
 	}
 
-	friend uint32 GetTypeHash(const FMaterialAttributeContainer& Object);
+	friend uint32 GetTypeHash(const FMaterialAttributeContainer& Object)
+	{
+		return GetTypeHash(Object.Id);
+	}
+
+	bool HasEqualProperties(const FMaterialAttributeContainer& Other) const
+	{
+		// clang-format off
+		return TextureProperties.OrderIndependentCompareEqual(Other.TextureProperties) &&
+			   ColorProperties.OrderIndependentCompareEqual(Other.ColorProperties) &&
+			   ScalarProperties.OrderIndependentCompareEqual(Other.ScalarProperties) &&
+			   StringProperties.OrderIndependentCompareEqual(Other.StringProperties) && 
+			   BlendMode == Other.BlendMode;
+		// clang-format on
+	}
 
 	FString GetMaterialName() const
 	{
@@ -129,7 +151,7 @@ struct FMaterialAttributeContainer
 struct FInstanceCacheKey
 {
 	FString MeshId;
-	TArray<Vitruvio::FMaterialAttributeContainer> MaterialOverrides;
+	TArray<FMaterialId> MaterialOverrides; // see FMaterialInternTable
 
 	friend uint32 GetTypeHash(const FInstanceCacheKey& Object);
 
@@ -143,7 +165,18 @@ struct FInstanceCacheKey
 		return !(Lhs == RHS);
 	}
 };
-using FInstanceMap = TMap<FInstanceCacheKey, TArray<FTransform>>;
+struct FInstanceData
+{
+	TArray<FTransform> Transforms;
+
+	/** NumCustomDataFloats values per instance, or empty if the instances have no custom data (see vitruvio.CustomData.Attributes). */
+	TArray<float> CustomData;
+	int32 NumCustomDataFloats = 0;
+
+	/** The interned materials of FInstanceCacheKey::MaterialOverrides, keeps them in the FMaterialInternTable until the result is applied. */
+	TArray<TSharedRef<const FMaterialAttributeContainer>> MaterialOverrides;
+};
+using FInstanceMap = TMap<FInstanceCacheKey, FInstanceData>;
 
 struct FTextureData
 {
@@ -151,6 +184,16 @@ struct FTextureData
 	uint32 NumChannels = 0;
 	FDateTime LoadTime;
 
+	/** Hash of the decoded pixels and the texture settings, identical textures from different files have the same hash. */
+	uint64 ContentHash = 0;
+
+	/**
+	 * Number of black and white pixels of the opacity channel (alpha for textures with 4 channels, red otherwise), counted while decoding
+	 * opacity maps to choose their blend mode. Always 0 for textures decoded for other material properties.
+	 */
+	uint32 OpacityBlackPixels = 0;
+	uint32 OpacityWhitePixels = 0;
+
 	friend bool operator==(const FTextureData& Lhs, const FTextureData& Rhs)
 	{
 		return Lhs.Texture == Rhs.Texture && Lhs.NumChannels == Rhs.NumChannels;
@@ -173,4 +216,9 @@ struct FCollisionData
 	}
 };
 
+/**
+ * Extracts the vertex positions and triangle indices used for complex collision from the given mesh.
+ */
+FCollisionData CreateCollisionData(const FMeshDescription& MeshDescription);
+
 } // namespace Vitruvio
@@ -51,7 +51,9 @@ public class Vitruvio : ModuleRules
 				"ImageCore",
 				"PRT",
 				"UnrealGeometryEncoderLib",
-				"GeometryCore"
+				"GeometryCore",
+				"DynamicMesh",
+				"MeshConversion"
 			}
 		);
 		
@@ -21,9 +21,11 @@
 #include "Factories/MaterialInstanceConstantFactoryNew.h"
 #include "GeneratedModelHISMComponent.h"
 #include "GeneratedModelStaticMeshComponent.h"
+#include "Hash/xxhash.h"
 #include "Materials/MaterialInstanceConstant.h"
 #include "PhysicsEngine/BodySetup.h"
 #include "StaticMeshAttributes.h"
+#include "TextureCompression.h"
 #include "VitruvioBatchActor.h"
 
 #include "Misc/ScopedSlowTask.h"
@@ -34,8 +36,16 @@
 namespace
 {
 
-using FMaterialCache = TMap<UMaterialInstance*, UMaterialInstanceConstant*>;
-using FTextureCache = TMap<UTexture*, UTexture2D*>;
+using FCookedMaterialCache = TMap<UMaterialInstance*, UMaterialInstanceConstant*>;
+
+struct FCookedTextureCache
+{
+	TMap<UTexture*, UTexture2D*> Textures;
+
+	// Generated textures with identical pixels and settings are saved as one asset
+	TMap<uint64, UTexture2D*> TexturesByContentHash;
+};
+
 using FStaticMeshCache = TMap<UStaticMesh*, UStaticMesh*>;
 
 std::atomic<bool> IsCooking;
@@ -101,11 +111,35 @@ ETextureSourceFormat GetTextureFormatFromPixelFormat(const EPixelFormat PixelFor
 	}
 }
 
-UTexture2D* SaveTexture(UTexture2D* Original, const FString& Path, FTextureCache& TextureCache)
+uint64 ComputeTextureContentHash(UTexture2D* Texture)
 {
-	if (TextureCache.Contains(Original))
+	const FTexturePlatformData* PlatformData = Texture->GetPlatformData();
+	const FTexture2DMipMap& Mip = PlatformData->Mips[0];
+
+	FXxHash64Builder ContentHashBuilder;
+	ContentHashBuilder.Update(Mip.BulkData.LockReadOnly(), Mip.BulkData.GetBulkDataSize());
+	Mip.BulkData.Unlock();
+	ContentHashBuilder.Update(&PlatformData->SizeX, sizeof(PlatformData->SizeX));
+	ContentHashBuilder.Update(&PlatformData->SizeY, sizeof(PlatformData->SizeY));
+	ContentHashBuilder.Update(&PlatformData->PixelFormat, sizeof(PlatformData->PixelFormat));
+	ContentHashBuilder.Update(&Texture->CompressionSettings, sizeof(Texture->CompressionSettings));
+	const bool bSRGB = Texture->SRGB;
+	ContentHashBuilder.Update(&bSRGB, sizeof(bSRGB));
+	return ContentHashBuilder.Finalize().Hash;
+}
+
+UTexture2D* SaveTexture(UTexture2D* Original, const FString& Path, FCookedTextureCache& TextureCache)
+{
+	if (UTexture2D** CookedTexture = TextureCache.Textures.Find(Original))
+	{
+		return *CookedTexture;
+	}
+
+	const uint64 ContentHash = ComputeTextureContentHash(Original);
+	if (UTexture2D** CookedTexture = TextureCache.TexturesByContentHash.Find(ContentHash))
 	{
-		return TextureCache[Original];
+		TextureCache.Textures.Add(Original, *CookedTexture);
+		return *CookedTexture;
 	}
 	FString AssetName;
 	UPackage* TexturePackage = CreateUniquePackage(FPaths::Combine(Path, TEXT("Textures"), Original->GetName()), AssetName);
@@ -137,21 +171,32 @@ UTexture2D* SaveTexture(UTexture2D* Original, const FString& Path, FTextureCache
 	FMemory::Memcpy(TextureData, SourcePixels, OriginalMip.BulkData.GetBulkDataSize());
 	Mip->BulkData.Unlock();
 
-	const ETextureSourceFormat SourceFormat = GetTextureFormatFromPixelFormat(OriginalPlatformData->PixelFormat);
-	NewTexture->Source.Init(OriginalPlatformData->SizeX, OriginalPlatformData->SizeY, 1, 1, SourceFormat, SourcePixels);
+	// Textures compressed at runtime are decompressed again for the source, the editor builds the compressed mips of the asset from it
+	if (Vitruvio::IsBlockCompressed(OriginalPlatformData->PixelFormat))
+	{
+		const TArray64<uint8> DecompressedPixels =
+			Vitruvio::DecompressBlocks(SourcePixels, OriginalMip.SizeX, OriginalMip.SizeY, OriginalPlatformData->PixelFormat);
+		NewTexture->Source.Init(OriginalMip.SizeX, OriginalMip.SizeY, 1, 1, TSF_BGRA8, DecompressedPixels.GetData());
+	}
+	else
+	{
+		const ETextureSourceFormat SourceFormat = GetTextureFormatFromPixelFormat(OriginalPlatformData->PixelFormat);
+		NewTexture->Source.Init(OriginalPlatformData->SizeX, OriginalPlatformData->SizeY, 1, 1, SourceFormat, SourcePixels);
+	}
 	OriginalMip.BulkData.Unlock();
 
 	NewTexture->PostEditChange();
 	TexturePackage->MarkPackageDirty();
 	FAssetRegistryModule::AssetCreated(NewTexture);
 
-	TextureCache.Add(Original, NewTexture);
+	TextureCache.Textures.Add(Original, NewTexture);
+	TextureCache.TexturesByContentHash.Add(ContentHash, NewTexture);
 
 	return NewTexture;
 }
 
-UMaterialInstanceConstant* SaveMaterial(UMaterialInstance* Material, const FString& Path, FMaterialCache& MaterialCache,
-										FTextureCache& TextureCache)
+UMaterialInstanceConstant* SaveMaterial(UMaterialInstance* Material, const FString& Path, FCookedMaterialCache& MaterialCache,
+										FCookedTextureCache& TextureCache)
 {
 	if (MaterialCache.Contains(Material))
 	{
@@ -214,8 +259,8 @@ UMaterialInstanceConstant* SaveMaterial(UMaterialInstance* Material, const FStri
 	return NewMaterial;
 }
 
-UStaticMesh* SaveStaticMesh(UStaticMesh* Mesh, const FString& Path, FStaticMeshCache& MeshCache, FMaterialCache& MaterialCache,
-							FTextureCache& TextureCache)
+UStaticMesh* SaveStaticMesh(UStaticMesh* Mesh, const FString& Path, FStaticMeshCache& MeshCache, FCookedMaterialCache& MaterialCache,
+							FCookedTextureCache& TextureCache)
 {
 	if (MeshCache.Contains(Mesh))
 	{
@@ -228,51 +273,67 @@ UStaticMesh* SaveStaticMesh(UStaticMesh* Mesh, const FString& Path, FStaticMeshC
 	UStaticMesh* PersistedMesh = NewObject<UStaticMesh>(MeshPackage, *AssetName, RF_Public | RF_Standalone);
 	PersistedMesh->InitResources();
 
-	FMeshDescription* OriginalMeshDescription = Mesh->GetMeshDescription(0);
-	FMeshDescription NewMeshDescription(*OriginalMeshDescription);
-	FStaticMeshAttributes MeshAttributes(NewMeshDescription);
+	// Copy all LODs generated at runtime
+	TArray<FMeshDescription> NewMeshDescriptions;
+	for (int32 LODIndex = 0; LODIndex < Mesh->GetNumSourceModels(); ++LODIndex)
+	{
+		NewMeshDescriptions.Emplace(*Mesh->GetMeshDescription(LODIndex));
+	}
 
 	// Copy Materials
 	TMap<UMaterialInterface*, FName> MaterialSlots;
 
-	const auto PolygonGroups = NewMeshDescription.PolygonGroups();
-	for (const auto& PolygonGroupId : PolygonGroups.GetElementIDs())
+	for (FMeshDescription& NewMeshDescription : NewMeshDescriptions)
 	{
-		const FName MaterialName = MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId];
-		int32 Index = Mesh->GetMaterialIndex(MaterialName);
+		FStaticMeshAttributes MeshAttributes(NewMeshDescription);
 
-		if (Index != INDEX_NONE)
+		const auto PolygonGroups = NewMeshDescription.PolygonGroups();
+		for (const auto& PolygonGroupId : PolygonGroups.GetElementIDs())
 		{
-			UMaterialInterface* Material = Mesh->GetMaterial(Index);
-			if (UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Material))
-			{
-				Material = SaveMaterial(MaterialInstance, Path, MaterialCache, TextureCache);
-			}
-			
-			const auto MaterialResult = MaterialSlots.Find(Material);
-			if (MaterialResult)
-			{
-				MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = *MaterialResult;
-			}
-			else
+			const FName MaterialName = MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId];
+			int32 Index = Mesh->GetMaterialIndex(MaterialName);
+
+			if (Index != INDEX_NONE)
 			{
-				FName NewSlot = PersistedMesh->AddMaterial(Material);
-				MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = NewSlot;
-				MaterialSlots.Add(Material, NewSlot);
+				UMaterialInterface* Material = Mesh->GetMaterial(Index);
+				if (UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Material))
+				{
+					Material = SaveMaterial(MaterialInstance, Path, MaterialCache, TextureCache);
+				}
+
+				const auto MaterialResult = MaterialSlots.Find(Material);
+				if (MaterialResult)
+				{
+					MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = *MaterialResult;
+				}
+				else
+				{
+					FName NewSlot = PersistedMesh->AddMaterial(Material);
+					MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = NewSlot;
+					MaterialSlots.Add(Material, NewSlot);
+				}
 			}
 		}
 	}
 
 	// Build the Static Mesh
 	TArray<const FMeshDescription*> MeshDescriptions;
-	MeshDescriptions.Add(&NewMeshDescription);
+	for (const FMeshDescription& NewMeshDescription : NewMeshDescriptions)
+	{
+		MeshDescriptions.Add(&NewMeshDescription);
+	}
 	PersistedMesh->BuildFromMeshDescriptions(MeshDescriptions);
 
-	check(PersistedMesh->GetNumSourceModels() == 1);
-	FStaticMeshSourceModel& SrcModel = PersistedMesh->GetSourceModel(0);
-	SrcModel.BuildSettings.bRecomputeNormals = false;
-	SrcModel.BuildSettings.bRecomputeTangents = false;
-	SrcModel.BuildSettings.bRemoveDegenerates = true;
+	check(PersistedMesh->GetNumSourceModels() == MeshDescriptions.Num());
+	PersistedMesh->bAutoComputeLODScreenSize = false;
+	for (int32 LODIndex = 0; LODIndex < PersistedMesh->GetNumSourceModels(); ++LODIndex)
+	{
+		FStaticMeshSourceModel& SrcModel = PersistedMesh->GetSourceModel(LODIndex);
+		SrcModel.BuildSettings.bRecomputeNormals = false;
+		SrcModel.BuildSettings.bRecomputeTangents = false;
+		SrcModel.BuildSettings.bRemoveDegenerates = true;
+		SrcModel.ScreenSize = Mesh->GetSourceModel(LODIndex).ScreenSize;
+	}
 	PersistedMesh->GetBodySetup()->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
 
 	PersistedMesh->PostEditChange();
@@ -290,8 +351,11 @@ void CookActors(const TArray<AActor*>& Actors, const FString& CookPath)
 	FScopedSlowTask CookTask(Actors.Num(), FText::FromString("Cooking models..."));
 	CookTask.MakeDialog();
 
-	FMaterialCache MaterialCache;
-	FTextureCache TextureCache;
+	// Generated materials might still wait for their textures
+	VitruvioModule::Get().FlushPendingTextureBindings();
+
+	FCookedMaterialCache MaterialCache;
+	FCookedTextureCache TextureCache;
 	FStaticMeshCache MeshCache;
 
 	for (AActor* Actor : Actors)
@@ -387,11 +451,20 @@ void CookActors(const TArray<AActor*>& Actors, const FString& CookPath)
 						InstancedStaticMeshComponent = AttachMeshComponent<UHierarchicalInstancedStaticMeshComponent>(CookedActor, CookedMeshComponent, InstanceMesh, Name, GeneratedModelHismComponent->GetComponentTransform());
 					}
 					
+					// Per-instance custom data carries material attributes (see vitruvio.CustomData.Attributes) and is copied as well
+					const int32 NumCustomDataFloats = GeneratedModelHismComponent->NumCustomDataFloats;
+					InstancedStaticMeshComponent->SetNumCustomDataFloats(NumCustomDataFloats);
 					for (int32 InstanceIndex = 0; InstanceIndex < GeneratedModelHismComponent->GetInstanceCount(); ++InstanceIndex)
 					{
 						FTransform Transform;
 						GeneratedModelHismComponent->GetInstanceTransform(InstanceIndex, Transform);
-						InstancedStaticMeshComponent->AddInstance(Transform);
+						const int32 NewInstanceIndex = InstancedStaticMeshComponent->AddInstance(Transform);
+
+						if (NumCustomDataFloats > 0)
+						{
+							const float* CustomData = GeneratedModelHismComponent->PerInstanceSMCustomData.GetData() + InstanceIndex * NumCustomDataFloats;
+							InstancedStaticMeshComponent->SetCustomData(NewInstanceIndex, MakeArrayView(CustomData, NumCustomDataFloats));
+						}
 					}
 				}
 			}
@@ -205,6 +205,8 @@ void VitruvioEditorModule::StartupModule()
 	MapChangedHandle = LevelEditor.OnMapChanged().AddRaw(this, &VitruvioEditorModule::OnMapChanged);
 
 	PostUndoRedoDelegate = FEditorDelegates::PostUndoRedo.AddRaw(this, &VitruvioEditorModule::PostUndoRedo);
+
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddRaw(this, &VitruvioEditorModule::OnObjectPropertyChanged);
 }
 
 void VitruvioEditorModule::ShutdownModule()
@@ -232,6 +234,7 @@ void VitruvioEditorModule::ShutdownModule()
 	LevelEditor.OnMapChanged().Remove(MapChangedHandle);
 
 	FEditorDelegates::PostUndoRedo.Remove(PostUndoRedoDelegate);
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
 }
 
 void VitruvioEditorModule::BlockUntilGenerated() const
@@ -284,6 +287,16 @@ void VitruvioEditorModule::OnPostEngineInit()
 	// clang-format on
 }
 
+void VitruvioEditorModule::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	// Textures are cached by their resolution cap, so they are decoded again with the new cap the next time they are requested
+	URulePackage* RulePackage = Cast<URulePackage>(Object);
+	if (RulePackage && PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(URulePackage, MaxTextureResolution))
+	{
+		VitruvioModule::Get().UpdateMaxTextureResolution(RulePackage);
+	}
+}
+
 void VitruvioEditorModule::OnMapChanged(UWorld* World, EMapChangeType ChangeType)
 {
 	if (ChangeType == EMapChangeType::TearDownWorld)
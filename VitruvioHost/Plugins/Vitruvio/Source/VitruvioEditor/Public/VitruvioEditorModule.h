@@ -36,6 +36,7 @@ private:
 	void PostUndoRedo();
 	void OnMapChanged(UWorld* World, EMapChangeType ChangeType);
 	void OnGenerateCompleted(int NumWarnings, int NumErrors);
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
 
 	TWeakPtr<SNotificationItem> NotificationItem;
 
@@ -44,4 +45,5 @@ private:
 	FDelegateHandle OnAssetReloadHandle;
 	FDelegateHandle MapChangedHandle;
 	FDelegateHandle PostUndoRedoDelegate;
+	FDelegateHandle ObjectPropertyChangedHandle;
 };